@@ -23,9 +23,19 @@
 #ifndef _AGENDA_H_
 #define _AGENDA_H_
 
+#include <algorithm>
 #include <queue>
 #include <vector>
 
+/** An entry of the agenda's priority queue: the task together with a copy of
+ *  its priority, so that the heap operations do not have to touch the tasks.
+ */
+template <typename T> struct agenda_entry {
+  double priority;
+  T *task;
+  agenda_entry(T *t) : priority(t->priority()), task(t) {}
+};
+
 #include "item.h"
 #include "options.h"
 #include "task.h"
@@ -52,15 +62,16 @@ public :
   exhaustive_agenda() : _A() {}
   ~exhaustive_agenda() { while(!this->empty()) delete this->pop(); }
 
-  void push(T *t) { _A.push(t); }
-  T * top()       { return _A.top(); }
+  void push(T *t) { _A.push(agenda_entry<T>(t)); }
+  T * top()       { return _A.top().task; }
   T * pop()       { T *t = top(); _A.pop(); return t; }
   bool empty()    { return _A.empty(); }
   void feedback (T *t, tItem *result) {}
 
 private:
 
-  std::priority_queue<T *, std::vector<T *>, LESS_THAN> _A;
+  std::priority_queue<agenda_entry<T>, std::vector<agenda_entry<T> >,
+                      LESS_THAN> _A;
 };
 
 
@@ -82,7 +93,7 @@ public :
   ~local_cap_agenda();
 
   void push(T *t) {
-    _A.push(t);
+    _A.push(agenda_entry<T>(t));
   }
   T * top();
   T * pop();
@@ -91,7 +102,8 @@ public :
 
 private:
 
-  std::priority_queue<T *, std::vector<T *>, LESS_THAN> _A;
+  std::priority_queue<agenda_entry<T>, std::vector<agenda_entry<T> >,
+                      LESS_THAN> _A;
   std::vector<int> _popped;
   int _max_pos;
   int _cell_size;
@@ -109,7 +121,7 @@ private:
 template <typename T, class LESS_THAN>
 local_cap_agenda<T, LESS_THAN>::~local_cap_agenda() {
   while (!_A.empty()) {
-    T* t = _A.top();
+    T* t = _A.top().task;
     delete t;
     _A.pop();
   }
@@ -121,7 +133,7 @@ T * local_cap_agenda<T, LESS_THAN>::top() {
   bool found = false;
   while (!found) {
     if (!_A.empty()) {
-      t = _A.top();
+      t = _A.top().task;
       if (t->phrasal() && _popped[t->start()*(_max_pos+1) + t->end()] >= _cell_size) {
         // This span reached the limit, so continue searching for a new task.
         // Inflectional and lexical rules are always carried out.
@@ -161,4 +173,137 @@ void local_cap_agenda<T, LESS_THAN>::feedback (T *t, tItem *result) {
 }
 
 
+
+/*
+ * BEST-FIRST AGENDA
+ */
+
+template <typename T, typename LESS_THAN > class best_first_agenda : public abstract_agenda<T, LESS_THAN > {
+/* This class provides an agenda for best-first parsing, where the task
+ * priorities are the parse selection scores of the items the tasks would
+ * build, raised by the model's bound for the rest of a tree. Two beams cut
+ * it down: the global beam keeps at most beam_size phrasal tasks and drops
+ * the worst ones when the agenda overflows, the cell beams drop phrasal
+ * tasks whose priority is more than cell_beam below the best task that built
+ * a passive item for their span so far. A width of zero switches a beam
+ * off. Inflectional and lexical rules are always carried out. */
+
+public :
+
+  best_first_agenda(int beam_size, double cell_beam, int max_pos)
+    : _A(), _beam_size(beam_size), _cell_beam(cell_beam), _max_pos(max_pos),
+      _best((max_pos+1)*(max_pos+1), 0.0),
+      _scored((max_pos+1)*(max_pos+1), false) {
+  }
+  ~best_first_agenda();
+
+  void push(T *t);
+  T * top();
+  T * pop();
+  bool empty() { return top() == NULL; }
+  void feedback (T *t, tItem *result);
+
+private:
+
+  /** Order agenda entries best first */
+  struct entry_greater {
+    bool operator()(const agenda_entry<T> &x, const agenda_entry<T> &y) const {
+      return LESS_THAN()(y, x);
+    }
+  };
+
+  /** Does the cell beam exclude \a t? */
+  bool outside_cell_beam(T *t) {
+    int cell = t->start()*(_max_pos+1) + t->end();
+    return _cell_beam > 0 && t->phrasal() && _scored[cell]
+      && t->priority() < _best[cell] - _cell_beam;
+  }
+
+  /** Return true if the entry's task is inflectional or lexical */
+  static bool not_phrasal(const agenda_entry<T> &e) {
+    return ! e.task->phrasal();
+  }
+
+  void prune();
+
+  /** the heap of entries, with the best one in front */
+  std::vector<agenda_entry<T> > _A;
+  int _beam_size;
+  double _cell_beam;
+  int _max_pos;
+
+  /** the best priority of a task that built a passive item per cell, if
+   *  _scored is set */
+  std::vector<double> _best;
+  std::vector<bool> _scored;
+};
+
+
+template <typename T, class LESS_THAN>
+best_first_agenda<T, LESS_THAN>::~best_first_agenda() {
+  for (typename std::vector<agenda_entry<T> >::iterator it = _A.begin();
+       it != _A.end(); ++it)
+    delete it->task;
+}
+
+template <typename T, class LESS_THAN>
+void best_first_agenda<T, LESS_THAN>::push(T *t) {
+  _A.push_back(agenda_entry<T>(t));
+  std::push_heap(_A.begin(), _A.end(), LESS_THAN());
+  // prune only now and then, so that pushing stays cheap on average
+  if (_beam_size > 0 && _A.size() >= 2 * (size_t) _beam_size)
+    prune();
+}
+
+/** Cut the agenda down to the global beam */
+template <typename T, class LESS_THAN>
+void best_first_agenda<T, LESS_THAN>::prune() {
+  typename std::vector<agenda_entry<T> >::iterator phrasal
+    = std::partition(_A.begin(), _A.end(), not_phrasal);
+  if (_A.end() - phrasal > _beam_size) {
+    typename std::vector<agenda_entry<T> >::iterator keep
+      = phrasal + _beam_size;
+    std::nth_element(phrasal, keep, _A.end(), entry_greater());
+    for (typename std::vector<agenda_entry<T> >::iterator it = keep;
+         it != _A.end(); ++it)
+      delete it->task;
+    _A.erase(keep, _A.end());
+  }
+  std::make_heap(_A.begin(), _A.end(), LESS_THAN());
+}
+
+template <typename T, class LESS_THAN>
+T * best_first_agenda<T, LESS_THAN>::top() {
+  while (!_A.empty()) {
+    T *t = _A.front().task;
+    if (! outside_cell_beam(t)) return t;
+    delete t;
+    std::pop_heap(_A.begin(), _A.end(), LESS_THAN());
+    _A.pop_back();
+  }
+  return NULL;
+}
+
+template <typename T, class LESS_THAN>
+T * best_first_agenda<T, LESS_THAN>::pop() {
+  T *t = top();
+  if (t != NULL) {
+    std::pop_heap(_A.begin(), _A.end(), LESS_THAN());
+    _A.pop_back();
+  }
+  return t;
+}
+
+template <typename T, class LESS_THAN>
+void best_first_agenda<T, LESS_THAN>::feedback (T *t, tItem *result) {
+  if (result != 0 && t->phrasal() && result->passive()) {
+    int cell = t->start()*(_max_pos+1) + t->end();
+    if (! _scored[cell] || t->priority() > _best[cell]) {
+      _best[cell] = t->priority();
+      _scored[cell] = true;
+    }
+  }
+}
+
+
 #endif
@@ -0,0 +1,319 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* parallel batch processing with forked worker processes */
+
+#include "pet-config.h"
+#include "batch.h"
+#include "cheap.h"
+#include "errors.h"
+#include "lexparser.h"
+#include "tsdb++.h"
+#include "logging.h"
+
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/select.h>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+//
+// low level communication over pipes
+//
+
+static bool write_all(int fd, const char *buf, size_t n) {
+  while(n > 0) {
+    ssize_t written = write(fd, buf, n);
+    if(written < 0) {
+      if(errno == EINTR) continue;
+      return false;
+    }
+    buf += written; n -= written;
+  }
+  return true;
+}
+
+static bool read_all(int fd, char *buf, size_t n) {
+  while(n > 0) {
+    ssize_t got = read(fd, buf, n);
+    if(got < 0) {
+      if(errno == EINTR) continue;
+      return false;
+    }
+    if(got == 0) return false;
+    buf += got; n -= got;
+  }
+  return true;
+}
+
+static bool write_int(int fd, int i) {
+  return write_all(fd, (const char *) &i, sizeof(i));
+}
+
+static bool read_int(int fd, int &i) {
+  return read_all(fd, (char *) &i, sizeof(i));
+}
+
+static bool write_string(int fd, const string &s) {
+  return write_int(fd, s.size()) && write_all(fd, s.data(), s.size());
+}
+
+static bool read_string(int fd, string &s) {
+  int len;
+  if(! read_int(fd, len) || len < 0) return false;
+  s.resize(len);
+  return len == 0 || read_all(fd, &s[0], len);
+}
+
+/** A temporary file collecting the output a worker produces for one item. */
+class tCapture {
+public:
+  tCapture() : _file(tmpfile()) {
+    if(_file == NULL)
+      throw tError("batch: can not create temporary file");
+  }
+
+  ~tCapture() { fclose(_file); }
+
+  FILE *file() { return _file; }
+  int fd() { return fileno(_file); }
+
+  /** Return everything written to the file so far and empty it. The output
+   *  streams have to be flushed before.
+   */
+  string take() {
+    fflush(_file);
+    struct stat st;
+    string result;
+    if(fstat(fd(), &st) == 0 && st.st_size > 0) {
+      result.resize(st.st_size);
+      if(pread(fd(), &result[0], st.st_size, 0) != st.st_size)
+        result.clear();
+    }
+    if(ftruncate(fd(), 0) != 0)
+      throw tError("batch: can not truncate temporary file");
+    rewind(_file);
+    return result;
+  }
+
+private:
+  FILE *_file;
+};
+
+/** The output of one item: stdout, stderr and the three tsdb relations */
+struct tItemOutput {
+  string out, err, parse, result, item;
+};
+
+/** The main process' view of a worker */
+struct tWorker {
+  pid_t pid;
+  /** pipes to send items to and receive results from the worker */
+  int to, from;
+  /** the id of the item being processed, zero if the worker is idle */
+  int id;
+  string input;
+};
+
+/** Do stdout and stderr go to the same file, e.g., a terminal? */
+static bool same_output_file() {
+  struct stat out, err;
+  return fstat(STDOUT_FILENO, &out) == 0 && fstat(STDERR_FILENO, &err) == 0
+    && out.st_dev == err.st_dev && out.st_ino == err.st_ino;
+}
+
+static void
+worker_loop(int from, int to, tTsdbDump &tsdb_dump, item_processor process) {
+  tCapture out, err, parse, result, item;
+  // if both streams end up in the same file, capture them in one, too, so
+  // that they are interleaved as in a sequential run
+  bool same = same_output_file();
+  bool line_buffered = isatty(STDOUT_FILENO);
+  if(dup2(out.fd(), STDOUT_FILENO) < 0
+     || dup2(same ? out.fd() : err.fd(), STDERR_FILENO) < 0)
+    return;
+  if(line_buffered) setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+  tsdb_dump.redirect(parse.file(), result.file(), item.file());
+
+  int id;
+  string input;
+  while(read_int(from, id) && read_string(from, input)) {
+    process(input, id, tsdb_dump);
+    cout.flush(); cerr.flush(); fflush(NULL);
+    if(! (write_int(to, id)
+          && write_string(to, out.take()) && write_string(to, err.take())
+          && write_string(to, parse.take()) && write_string(to, result.take())
+          && write_string(to, item.take())))
+      return;
+  }
+}
+
+static void
+start_worker(tWorker &w, vector<tWorker> &workers,
+             tTsdbDump &tsdb_dump, item_processor process) {
+  int down[2], up[2];
+  if(pipe(down) < 0)
+    throw tError("batch: can not create pipe");
+  if(pipe(up) < 0) {
+    close(down[0]); close(down[1]);
+    throw tError("batch: can not create pipe");
+  }
+
+  // nothing buffered may be written twice
+  cout.flush(); cerr.flush(); fflush(NULL);
+
+  w.pid = fork();
+  if(w.pid < 0) {
+    close(down[0]); close(down[1]); close(up[0]); close(up[1]);
+    throw tError("batch: can not fork worker process");
+  }
+
+  if(w.pid == 0) {
+    // the other workers must see an end of file when the main process closes
+    // their pipes, so do not keep them open here
+    for(vector<tWorker>::iterator it = workers.begin(); it != workers.end();
+        ++it) {
+      if(it->pid > 0) { close(it->to); close(it->from); }
+    }
+    close(down[1]); close(up[0]);
+    signal(SIGPIPE, SIG_DFL);
+    try {
+      worker_loop(down[0], up[1], tsdb_dump, process);
+    }
+    catch(tError e) {
+      LOG(logAppl, ERROR, "worker " << getpid() << ": " << e.getMessage());
+    }
+    // skip destructors and exit handlers, they belong to the main process
+    _exit(0);
+  }
+
+  close(down[0]); close(up[1]);
+  w.to = down[1];
+  w.from = up[0];
+  w.id = 0;
+}
+
+static void stop_worker(tWorker &w) {
+  close(w.to);
+  close(w.from);
+  waitpid(w.pid, NULL, 0);
+  w.pid = 0;
+}
+
+static bool
+read_output(tWorker &w, int &id, tItemOutput &output) {
+  return read_int(w.from, id) && id == w.id
+    && read_string(w.from, output.out) && read_string(w.from, output.err)
+    && read_string(w.from, output.parse) && read_string(w.from, output.result)
+    && read_string(w.from, output.item);
+}
+
+static void write_output(const tItemOutput &output, tTsdbDump &tsdb_dump) {
+  fwrite(output.out.data(), 1, output.out.size(), stdout);
+  fflush(stdout);
+  fwrite(output.err.data(), 1, output.err.size(), stderr);
+  fflush(stderr);
+  tsdb_dump.write_rows(output.parse, output.result, output.item);
+}
+
+void parallel_batch(istream &in, int jobs, tTsdbDump &tsdb_dump,
+                    item_processor process) {
+  // a dying worker must not take us down when we write to it
+  void (*old_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+
+  tWorker none = { 0, -1, -1, 0, string() };
+  vector<tWorker> workers(jobs, none);
+  for(int i = 0; i < jobs; ++i)
+    start_worker(workers[i], workers, tsdb_dump, process);
+
+  // results that arrived before those of their predecessors
+  map<int, tItemOutput> pending;
+  int next_id = 1, next_output = 1, busy = 0;
+  bool eof = false;
+  string input;
+
+  while(true) {
+    // hand out items to idle workers
+    for(vector<tWorker>::iterator w = workers.begin();
+        w != workers.end() && ! eof; ++w) {
+      if(w->id != 0) continue;
+      if(! Lexparser.next_input(in, input)) {
+        eof = true;
+        break;
+      }
+      w->id = next_id++;
+      w->input = input;
+      ++busy;
+      // a failure here shows up as end of file on the result pipe
+      if(write_int(w->to, w->id)) write_string(w->to, w->input);
+    }
+
+    if(busy == 0) break;
+
+    fd_set ready;
+    FD_ZERO(&ready);
+    int maxfd = -1;
+    for(vector<tWorker>::iterator w = workers.begin(); w != workers.end();
+        ++w) {
+      if(w->id == 0) continue;
+      FD_SET(w->from, &ready);
+      if(w->from > maxfd) maxfd = w->from;
+    }
+    if(select(maxfd + 1, &ready, NULL, NULL, NULL) < 0) {
+      if(errno == EINTR) continue;
+      throw tError("batch: select failed");
+    }
+
+    for(vector<tWorker>::iterator w = workers.begin(); w != workers.end();
+        ++w) {
+      if(w->id == 0 || ! FD_ISSET(w->from, &ready)) continue;
+      int id;
+      tItemOutput &output = pending[w->id];
+      if(! read_output(*w, id, output)) {
+        LOG(logAppl, ERROR, "worker " << w->pid << " died on item "
+            << w->id << ", restarting it");
+        output = tItemOutput();
+        output.err = "worker process died on item `" + w->input + "'\n";
+        stop_worker(*w);
+        start_worker(*w, workers, tsdb_dump, process);
+      }
+      w->id = 0;
+      --busy;
+    }
+
+    // print everything that is complete in input order
+    map<int, tItemOutput>::iterator it;
+    while((it = pending.find(next_output)) != pending.end()) {
+      write_output(it->second, tsdb_dump);
+      pending.erase(it);
+      ++next_output;
+    }
+  }
+
+  for(vector<tWorker>::iterator w = workers.begin(); w != workers.end(); ++w)
+    stop_worker(*w);
+  signal(SIGPIPE, old_sigpipe);
+}
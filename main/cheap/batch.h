@@ -0,0 +1,53 @@
+/* -*- Mode: C++ -*- */
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** \file batch.h
+ * Parallel batch processing with several worker processes.
+ */
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <string>
+#include <istream>
+
+class tTsdbDump;
+
+/** Function processing a single input item with number \a id. All output has
+ *  to go to the standard streams (stdout, stderr, \c fstatus, \c ferr) or
+ *  into \a tsdb_dump.
+ */
+typedef void (*item_processor)(const std::string &input, int id,
+                               tTsdbDump &tsdb_dump);
+
+/** Process all items read from \a in with \a jobs worker processes.
+ *
+ *  The workers are forked from the current process and thus share the loaded
+ *  grammar copy-on-write. Every worker processes one item at a time, the
+ *  output it produces for an item is collected and written by the calling
+ *  process strictly in input order, so the result is the same as processing
+ *  the items one after another with \a process.
+ *
+ *  If a worker dies while processing an item, an error is reported for this
+ *  item and a new worker is started.
+ */
+void parallel_batch(std::istream &in, int jobs, tTsdbDump &tsdb_dump,
+                    item_processor process);
+
+#endif
@@ -83,17 +83,42 @@ static bool initialized = init();
 // helpers
 // =====================================================
 
-class not_contained_in_list
+class not_succeeding
 {
 private:
-  item_list _items;
+  tChart &_chart;
+  tChartVertex *_v;
+  int _min, _max;
 public:
-  not_contained_in_list(item_list items) : _items(items) { }
+  not_succeeding(tChart &chart, tChartVertex *v, int min, int max)
+    : _chart(chart), _v(v), _min(min), _max(max) { }
   bool operator() (tItem*& item) {
-    for (item_iter item_it = _items.begin(); item_it != _items.end(); ++item_it)
-      if (*item_it == item)
-        return false;
-    return true;
+    return !_chart.is_succeeding_item(item, _v, _min, _max);
+  }
+};
+
+class not_preceding
+{
+private:
+  tChart &_chart;
+  tChartVertex *_v;
+  int _min, _max;
+public:
+  not_preceding(tChart &chart, tChartVertex *v, int min, int max)
+    : _chart(chart), _v(v), _min(min), _max(max) { }
+  bool operator() (tItem*& item) {
+    return !_chart.is_preceding_item(item, _v, _min, _max);
+  }
+};
+
+class cannot_match
+{
+private:
+  const tChartMappingRuleArg *_arg;
+public:
+  cannot_match(const tChartMappingRuleArg *arg) : _arg(arg) { }
+  bool operator() (tItem*& item) {
+    return !_arg->may_match(item);
   }
 };
 
@@ -126,11 +151,25 @@ struct sig_hash {
 typedef hash_map<tChartMappingMatchSig, tChartMappingMatch*, sig_hash>
   tChartMappingMatchCache;
 
+/**
+ * The incomplete matches all of whose extensions have been explored without
+ * finding a new completed match, together with the number of rules that had
+ * added items to the chart at that point. As long as no items are added,
+ * such a match can not be extended to a new completed match: freezing items
+ * only reduces the suitable items for the next argument.
+ */
+typedef std::map<tChartMappingMatch*, int> tChartMappingExploredMap;
+
 static tChartMappingMatch*
 get_new_completed_match(tChart &chart, tChartMappingMatch *match,
-    tChartMappingMatchCache &cache, int loglevel) {
+    tChartMappingMatchCache &cache, tChartMappingExploredMap &explored,
+    tRegexMatchMemo &memo, int additions, int loglevel) {
   assert(!match->is_complete());
 
+  tChartMappingExploredMap::iterator ex = explored.find(match);
+  if ((ex != explored.end()) && (ex->second == additions))
+    return 0;
+
   // loop over all suitable items for the next match:
   const tChartMappingRule *rule = match->get_rule();
   const tChartMappingRuleArg *arg = match->get_next_matching_arg();
@@ -144,8 +183,11 @@ get_new_completed_match(tChart &chart, tChartMappingMatch *match,
     // TODO invalidate cached matches with items anchored at ^ or $
     //      if chart start and end are affected by this rule
     tChartMappingMatchSig sig(rule, match, item, arg);
-    new_match = (cache.find(sig) == cache.end());
-    next_match = new_match ? (cache[sig]=match->match(item, arg, loglevel)) : cache[sig];
+    tChartMappingMatchCache::iterator cached = cache.find(sig);
+    new_match = (cached == cache.end());
+    next_match = new_match
+      ? (cache[sig] = match->match(item, arg, memo, loglevel))
+      : cached->second;
 
     // logging:
     if (new_match && (LOG_ENABLED(logChartMapping, DEBUG) || (loglevel & 256))) {
@@ -167,7 +209,8 @@ get_new_completed_match(tChart &chart, tChartMappingMatch *match,
         }
       } else {
         tChartMappingMatch *next_completed_match =
-          get_new_completed_match(chart, next_match, cache, loglevel);
+          get_new_completed_match(chart, next_match, cache, explored, memo,
+                                  additions, loglevel);
         if (next_completed_match) {
           return next_completed_match;
         }
@@ -175,6 +218,7 @@ get_new_completed_match(tChart &chart, tChartMappingMatch *match,
     }
   }
 
+  explored[match] = additions;
   return 0; // there were no suitable items or no further completed match
 }
 
@@ -214,6 +258,11 @@ void tChartMappingEngine::process(tChart &chart)
 
   // cache storing each match we've created:
   tChartMappingMatchCache cache;
+  // matches without further completions, see get_new_completed_match():
+  tChartMappingExploredMap explored;
+  // regex match results, shared by all rules of this phase:
+  tRegexMatchMemo memo;
+  int additions = 0;
 
   //
   // chart mapping loop: rewriting rules are ordered, so we want a single pass
@@ -234,8 +283,13 @@ void tChartMappingEngine::process(tChart &chart)
         chart.clear();
         throw tError(message);
       }
-      completed = get_new_completed_match(chart, empty_match, cache, loglevel);
-      if (completed) completed->fire(chart, loglevel);
+      completed = get_new_completed_match(chart, empty_match, cache, explored,
+                                          memo, additions, loglevel);
+      if (completed) {
+        completed->fire(chart, loglevel);
+        if (!rule->get_output_args().empty())
+          ++additions;
+      }
     } while (completed);
   } // for each rule
 
@@ -259,13 +313,16 @@ void tChartMappingEngine::process(tChart &chart)
 // =====================================================
 
 tChartMappingRuleArg::tChartMappingRuleArg(const std::string &name,
-    tChartMappingRuleArg::Trait trait, int nr, tPathRegexMap &regexs)
+    tChartMappingRuleArg::Trait trait, int nr, tPathRegexMap &regexs,
+    tPathRegexInfoMap &infos, type_t type)
 : _name(name),
   _start_anchor(name + ":s"),
   _end_anchor(name + ":e"),
   _trait(trait),
   _nr(nr),
-  _regexs(regexs) {
+  _regexs(regexs),
+  _regex_infos(infos),
+  _type(type) {
   // done
 }
 
@@ -277,8 +334,9 @@ tChartMappingRuleArg::~tChartMappingRuleArg() {
 
 tChartMappingRuleArg*
 tChartMappingRuleArg::create(const std::string &name,
-    tChartMappingRuleArg::Trait trait, int nr, tPathRegexMap &regexs) {
-  return new tChartMappingRuleArg(name, trait, nr, regexs);
+    tChartMappingRuleArg::Trait trait, int nr, tPathRegexMap &regexs,
+    tPathRegexInfoMap &infos, type_t type) {
+  return new tChartMappingRuleArg(name, trait, nr, regexs, infos, type);
 }
 
 const std::string&
@@ -311,6 +369,34 @@ tChartMappingRuleArg::get_regexs() const {
   return _regexs;
 }
 
+const tPathRegexInfoMap&
+tChartMappingRuleArg::get_regex_infos() const {
+  return _regex_infos;
+}
+
+bool
+tChartMappingRuleArg::may_match(tItem *item) const {
+  fs item_fs = item->get_fs();
+  if (glb(item_fs.type(), _type) == T_BOTTOM)
+    return false;
+
+  // these are the conditions checked first in tChartMappingMatch::match():
+  for (tPathRegexInfoMap::const_iterator it = _regex_infos.begin();
+       it != _regex_infos.end();
+       ++it) {
+    fs value_fs = item_fs.get_path_value(it->first);
+    if (!value_fs.valid() || (value_fs.type() == BI_STRING))
+      return false;
+    const string &prefix = it->second.prefix;
+    if (!prefix.empty()
+        && (get_printname(value_fs.type()).compare(0, prefix.size(), prefix)
+            != 0))
+      return false;
+  }
+
+  return true;
+}
+
 
 
 // =====================================================
@@ -699,15 +785,81 @@ tChartMappingAnchoringGraph::get_anchors_string(tVertex v) const {
 // class tChartMappingRule
 // =====================================================
 
+/**
+ * Helper function that returns the number identifying the regular expression
+ * \a source. Equal expressions get the same number.
+ */
+static int
+regex_number(const string &source)
+{
+  static std::map<string, int> numbers;
+  std::map<string, int>::iterator it = numbers.find(source);
+  if (it == numbers.end())
+    it = numbers.insert(std::make_pair(source, (int) numbers.size())).first;
+  return it->second;
+}
+
+/**
+ * Return the literal prefix of the regular expression \a regex, i.e., a
+ * string that all strings matched by \a regex start with.
+ * The result is conservative: it ends before the first special character
+ * that is not a plain group or a leading anchor, and it is empty if the
+ * expression contains an alternation.
+ */
+string
+regex_literal_prefix(const string &regex)
+{
+  static const string meta("\\^$.|[](){}*+?");
+  static const string optional("*?{");
+  if (regex.find('|') != string::npos)
+    return string();
+  string prefix;
+  vector<size_t> groups; // prefix lengths at the open groups
+  // the matched strings start right after an anchor at the beginning:
+  size_t start = ((regex.size() > 1) && (regex[0] == '^')
+                  && (optional.find(regex[1]) == string::npos)) ? 1 : 0;
+  for (size_t i = start; i < regex.size(); ++i) {
+    char c = regex[i];
+    bool quantified = (i + 1 < regex.size())
+      && (optional.find(regex[i + 1]) != string::npos);
+    if ((c == '(') && !((i + 1 < regex.size()) && (regex[i + 1] == '?'))) {
+      groups.push_back(prefix.size());
+    } else if ((c == ')') && !groups.empty()) {
+      if (quantified)
+        break;
+      groups.pop_back();
+    } else if (meta.find(c) != string::npos) {
+      break;
+    } else if (quantified) {
+      // drop the beginning of an optional multibyte character, too:
+      if ((c & 0xC0) == 0x80) {
+        while (!prefix.empty()
+               && ((prefix[prefix.size() - 1] & 0xC0) == 0x80))
+          prefix.erase(prefix.size() - 1);
+        if (!prefix.empty())
+          prefix.erase(prefix.size() - 1);
+      }
+      break;
+    } else {
+      prefix += c;
+    }
+  }
+  // an unfinished or quantified group might be optional as a whole:
+  if (!groups.empty())
+    prefix.erase(groups.front());
+  return prefix;
+}
+
 /**
  * Helper function that looks up each path in the given argument feature
  * structure that ends in a string, inspects whether this string contains a
  * regular expression, if so it stores that regex with the path in the
- * \a regexs map and replaces the regex in the feature structure with the
- * general string type to allow for unification with any string literal.
+ * \a regexs map (and further information about it in \a infos) and
+ * replaces the regex in the feature structure with the general string type
+ * to allow for unification with any string literal.
  */
 static void
-modify_arg_fs(fs arg_fs, tPathRegexMap &regexs)
+modify_arg_fs(fs arg_fs, tPathRegexMap &regexs, tPathRegexInfoMap &infos)
 {
   // check for each path in arg ending in a string whether it contains a
   // regex. if so, store it in a map and replace it with the general type
@@ -726,6 +878,9 @@ modify_arg_fs(fs arg_fs, tPathRegexMap &regexs)
         && uc_arg_val.endsWith(rex_end)) {
       uc_arg_val.setTo(uc_arg_val, 2, len - 4);
       regexs[regex_path] = boost::make_u32regex(uc_arg_val);
+      string source = arg_val.substr(2, arg_val.size() - 4);
+      infos[regex_path].id = regex_number(source);
+      infos[regex_path].prefix = regex_literal_prefix(source);
       arg_fs.get_path_value(regex_path).set_type(BI_STRING);
     } else {
       free_list(regex_path);
@@ -738,6 +893,8 @@ modify_arg_fs(fs arg_fs, tPathRegexMap &regexs)
         (*(--end)   == '"') && (*(--end)   == '$')) {
       arg_val.assign(begin, end); // use the regex string only
       regexs[regex_path] = boost::regex(arg_val);
+      infos[regex_path].id = regex_number(arg_val);
+      infos[regex_path].prefix = regex_literal_prefix(arg_val);
       arg_fs.get_path_value(regex_path).set_type(BI_STRING);
     } else {
       free_list(regex_path);
@@ -771,16 +928,18 @@ tChartMappingRule::tChartMappingRule(type_t type, Trait trait)
     for (fs_it = arg_fss.begin(), i = 1; fs_it != arg_fss.end(); ++fs_it, ++i) {
       try {
         tPathRegexMap regexs;
-        modify_arg_fs(*fs_it, regexs);
+        tPathRegexInfoMap infos;
+        modify_arg_fs(*fs_it, regexs, infos);
         string name = prefix + lexical_cast<std::string> (i);
         tChartMappingRuleArg *arg = tChartMappingRuleArg::create(name, trait,
-            i, regexs);
+            i, regexs, infos, fs_it->type());
         _args.push_back(arg);
         if (trait == tChartMappingRuleArg::OUTPUT_ARG)
           _output_args.push_back(arg);
         else
           _matching_args.push_back(arg);
       } catch (boost::regex_error e) {
+        discard_args();
         throw tError("Could not compile regex for rule " + get_typename(type)
             + ".");
       }
@@ -793,6 +952,10 @@ tChartMappingRule::tChartMappingRule(type_t type, Trait trait)
   // make sure we have a complete feature structure for the rule.
   //
   _fs.expand();
+  if (!_fs.valid()) {
+    discard_args();
+    throw tError("Expansion failed for rule " + get_typename(type) + ".");
+  }
 
   // parse positional constraints specification:
   string poscons_s;
@@ -802,6 +965,16 @@ tChartMappingRule::tChartMappingRule(type_t type, Trait trait)
   evaluate_poscons(poscons_s);
 }
 
+void
+tChartMappingRule::discard_args()
+{
+  for (tRuleArgs::iterator it = _args.begin(); it != _args.end(); ++it)
+    delete *it;
+  _args.clear();
+  _matching_args.clear();
+  _output_args.clear();
+}
+
 tChartMappingRule*
 tChartMappingRule::create(type_t type, tChartMappingRule::Trait trait)
 {
@@ -1132,6 +1305,7 @@ tChartMappingMatch::get_suitable_items(tChart &chart,
 
   // TODO make this much more efficient!!! (intersecting item lists is not good)
   item_list items = chart.items(cv_arg_s, cv_arg_e, true, true, skip);
+  items.remove_if(cannot_match(arg));
   if (!cv_arg_s) {
     tChartMappingAnchoringGraph::tInEdgeIt in_it, in_it_end;
     boost::tie(in_it, in_it_end) = boost::in_edges(av_arg_s, _anch_graph._graph);
@@ -1144,8 +1318,7 @@ tChartMappingMatch::get_suitable_items(tChart &chart,
         if (cv_next) { // there is an edge to a bound vertex
           int min = _anch_graph._graph[edge].min;
           int max = _anch_graph._graph[edge].max;
-          item_list restr = chart.succeeding_items(cv_next, min, max);
-          items.remove_if(not_contained_in_list(restr));
+          items.remove_if(not_succeeding(chart, cv_next, min, max));
         }
       }
     }
@@ -1162,8 +1335,7 @@ tChartMappingMatch::get_suitable_items(tChart &chart,
         if (cv_next) { // there is an edge to a bound vertex
           int min = _anch_graph._graph[edge].min;
           int max = _anch_graph._graph[edge].max;
-          item_list restr = chart.preceding_items(cv_next, min, max);
-          items.remove_if(not_contained_in_list(restr));
+          items.remove_if(not_preceding(chart, cv_next, min, max));
         }
       }
     }
@@ -1172,21 +1344,61 @@ tChartMappingMatch::get_suitable_items(tChart &chart,
   return items;
 }
 
+/**
+ * Helper function that matches \a str against \a regex and returns the
+ * result.
+ */
+#ifdef HAVE_BOOST_REGEX_ICU_HPP
+static void
+match_regex(const boost::u32regex &regex, const string &str,
+            tRegexMatch &result)
+{
+  boost::u16match regex_matches;
+  UnicodeString ucstr = Conv->convert(str);
+  result.matched = boost::u32regex_match(ucstr, regex_matches, regex);
+  if (!result.matched)
+    return;
+  for (unsigned int i = 1; i < regex_matches.size(); ++i) {
+    UnicodeString ucval(regex_matches[i].first, regex_matches.length(i));
+    result.groups.push_back(Conv->convert(ucval));
+    result.groups_lc.push_back(Conv->convert(ucval.toLower()));
+    result.groups_uc.push_back(Conv->convert(ucval.toUpper()));
+  }
+}
+#else
+static void
+match_regex(const boost::regex &regex, const string &str, tRegexMatch &result)
+{
+  boost::smatch regex_matches;
+  result.matched = boost::regex_match(str, regex_matches, regex);
+  if (!result.matched)
+    return;
+  for (unsigned int i = 1; i < regex_matches.size(); ++i) {
+    string val = regex_matches[i].str();
+    string val_lc = val;
+    string val_uc = val;
+    for (string::iterator it = val_lc.begin(); it != val_lc.end(); ++it)
+      *it = tolower(*it);
+    for (string::iterator it = val_uc.begin(); it != val_uc.end(); ++it)
+      *it = toupper(*it);
+    result.groups.push_back(val);
+    result.groups_lc.push_back(val_lc);
+    result.groups_uc.push_back(val_uc);
+  }
+}
+#endif
+
 tChartMappingMatch*
-tChartMappingMatch::match(tItem *item, const tChartMappingRuleArg *arg, int loglevel) {
+tChartMappingMatch::match(tItem *item, const tChartMappingRuleArg *arg,
+    tRegexMatchMemo &memo, int loglevel) {
   assert(!is_complete());
 
-  fs root_fs = get_fs();
-  fs arg_fs = get_arg_fs(arg);
   fs item_fs = item->get_fs();
 
-  // 1. try to unify argument with item (ignoring regexs for now):
-  fs result_fs = unify(root_fs, arg_fs, item_fs);
-  if (!result_fs.valid())
-    return 0;
-
-  // 2. check for each regex path whether it matches in item:
+  // 1. check for each regex path whether it matches in item. this only
+  // depends on the item, so do it before the (expensive) unification:
   const tPathRegexMap &regexs = arg->get_regexs();
+  const tPathRegexInfoMap &infos = arg->get_regex_infos();
   std::map<std::string, std::string> captures(_captures);
   for (tPathRegexMap::const_iterator it = regexs.begin();
        it != regexs.end();
@@ -1197,21 +1409,19 @@ tChartMappingMatch::match(tItem *item, const tChartMappingRuleArg *arg, int logl
     if (!value_fs.valid()) // the regex_path need not exist in the item fs
       return 0;
     type_t t = value_fs.type();
-    string str = get_printname(t);
-
-    // get regex and match string with regex (if any):
-#ifdef HAVE_BOOST_REGEX_ICU_HPP
-    boost::u32regex regex = it->second;
-    boost::u16match regex_matches;
-    UnicodeString ucstr = Conv->convert(str);
-    if ((t == BI_STRING) || !boost::u32regex_match(ucstr, regex_matches, regex))
+    if (t == BI_STRING)
       return 0;
-#else
-    boost::regex regex = it->second;
-    boost::smatch regex_matches;
-    if ((t == BI_STRING) || !boost::regex_match(str, regex_matches, regex))
+
+    // match string with regex, unless this has been done before:
+    std::pair<int, type_t> key(infos.find(regex_path)->second.id, t);
+    tRegexMatchMemo::iterator memo_it = memo.find(key);
+    if (memo_it == memo.end()) {
+      memo_it = memo.insert(std::make_pair(key, tRegexMatch())).first;
+      match_regex(it->second, get_printname(t), memo_it->second);
+    }
+    const tRegexMatch &regex_match = memo_it->second;
+    if (!regex_match.matched)
       return 0;
-#endif
 
     // get string representation of regex_path:
     std::string str_path;
@@ -1223,44 +1433,31 @@ tChartMappingMatch::match(tItem *item, const tChartMappingRuleArg *arg, int logl
     }
 
     // store new regex captures:
-    for (unsigned int i = 1; i < regex_matches.size(); ++i) {
-      // store vanilla string:
+    for (unsigned int i = 0; i < regex_match.groups.size(); ++i) {
       string capture_name = arg->get_name() + ":" + str_path + ":" +
-        boost::lexical_cast<std::string>(i);
-#ifdef HAVE_BOOST_REGEX_ICU_HPP
-      string att = Conv->convert(Conv->convert("${"+capture_name+"}"));
-      string att_lc = Conv->convert(Conv->convert("${lc("+capture_name+")}"));
-      string att_uc = Conv->convert(Conv->convert("${uc("+capture_name+")}"));
-      UnicodeString ucval(regex_matches[i].first, regex_matches.length(i));
-      string val = Conv->convert(ucval);
-      string val_lc = Conv->convert(ucval.toLower());
-      string val_uc = Conv->convert(ucval.toUpper());
-#else
-      string att = "${" + capture_name + "}";
-      string att_lc = "${lc(" + capture_name + ")}";
-      string att_uc = "${uc(" + capture_name + ")}";
-      string val = regex_matches[i].str();
-      string val_lc = val;
-      string val_uc = val;
-      for (string::iterator it = val_lc.begin(); it != val_lc.end(); ++it)
-        *it = tolower(*it);
-      for (string::iterator it = val_uc.begin(); it != val_uc.end(); ++it)
-        *it = toupper(*it);
-#endif
-      captures[att] = val;
-      captures[att_lc] = val_lc;
-      captures[att_uc] = val_uc;
+        boost::lexical_cast<std::string>(i + 1);
+      captures["${" + capture_name + "}"] = regex_match.groups[i];
+      captures["${lc(" + capture_name + ")}"] = regex_match.groups_lc[i];
+      captures["${uc(" + capture_name + ")}"] = regex_match.groups_uc[i];
     }
     if (LOG_ENABLED(logChartMapping, DEBUG) || loglevel & 2) {
 #ifdef HAVE_BOOST_REGEX_ICU_HPP
-      string rex_str = Conv->convert(regex.str().c_str()); // UChar32* -> string
+      string rex_str = Conv->convert(it->second.str().c_str()); // UChar32* -> string
 #else
-      string rex_str = regex.str();
+      string rex_str = it->second.str();
 #endif
-      cerr << format("[cm] regex_match(/%s/, \"%s\")\n") % rex_str % str;
+      cerr << format("[cm] regex_match(/%s/, \"%s\")\n") % rex_str
+        % get_printname(t);
     }
   }
 
+  // 2. try to unify argument with item:
+  fs root_fs = get_fs();
+  fs arg_fs = get_arg_fs(arg);
+  fs result_fs = unify(root_fs, arg_fs, item_fs);
+  if (!result_fs.valid())
+    return 0;
+
   // add current arg/item-binding:
   tArgItemMap arg_item_map(_arg_item_map);
   arg_item_map[arg] = item;
@@ -35,6 +35,7 @@
 #include <list>
 #include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 #include <boost/graph/adjacency_list.hpp>
@@ -63,6 +64,45 @@ typedef std::map<list_int*, boost::u32regex> tPathRegexMap;
 typedef std::map<list_int*, boost::regex> tPathRegexMap;
 #endif
 
+/**
+ * What is known about the regular expression at a path of a rule argument
+ * before matching: a number identifying the expression, which is the same
+ * for equal expressions in all rules, and the literal prefix that all
+ * strings matched by the expression start with (possibly empty).
+ */
+struct tRegexInfo {
+  int id;
+  std::string prefix;
+};
+
+/**
+ * A container mapping paths in feature structures to information about the
+ * regular expressions at these paths.
+ */
+typedef std::map<list_int*, tRegexInfo> tPathRegexInfoMap;
+
+/**
+ * The literal prefix of the regular expression \a regex, as stored in
+ * tRegexInfo.
+ */
+std::string regex_literal_prefix(const std::string &regex);
+
+/**
+ * The result of matching a string against a regular expression: whether it
+ * matched and the substrings captured by the groups of the expression, as
+ * they are and in lower and upper case.
+ */
+struct tRegexMatch {
+  bool matched;
+  std::vector<std::string> groups, groups_lc, groups_uc;
+};
+
+/**
+ * Results of regular expression matches, by the number of the expression
+ * (see tRegexInfo) and the type of the string that has been matched.
+ */
+typedef std::map<std::pair<int, type_t>, tRegexMatch> tRegexMatchMemo;
+
 
 
 /**
@@ -136,7 +176,7 @@ public:
    */
   static tChartMappingRuleArg*
   create(const std::string &name, tChartMappingRuleArg::Trait trait, int nr,
-      tPathRegexMap &regexs);
+      tPathRegexMap &regexs, tPathRegexInfoMap &infos, type_t type);
 
   /**
    * The name of this rule argument. Argument's names are used to
@@ -178,6 +218,24 @@ public:
   const tPathRegexMap&
   get_regexs() const;
 
+  /**
+   * Returns a container mapping the paths of the regular expressions to
+   * further information about them.
+   */
+  const tPathRegexInfoMap&
+  get_regex_infos() const;
+
+  /**
+   * Returns \c false if \a item certainly does not match this argument:
+   * its type is incompatible with the type of the argument, or one of the
+   * strings the regular expressions are applied to is missing or does not
+   * start with the literal prefix of the expression. This is much cheaper
+   * than tChartMappingMatch::match() and is used to index the chart items
+   * for the argument before trying to unify them.
+   */
+  bool
+  may_match(tItem *item) const;
+
 private:
 
   /**
@@ -185,7 +243,8 @@ private:
    * \see create()
    */
   tChartMappingRuleArg(const std::string &name,
-      tChartMappingRuleArg::Trait trait, int nr, tPathRegexMap &regexs);
+      tChartMappingRuleArg::Trait trait, int nr, tPathRegexMap &regexs,
+      tPathRegexInfoMap &infos, type_t type);
 
   /** No default copy constructor. */
   tChartMappingRuleArg(const tChartMappingRuleArg& arg);
@@ -208,6 +267,12 @@ private:
   /** \see get_regexs() */
   tPathRegexMap _regexs;
 
+  /** \see get_regex_infos() */
+  tPathRegexInfoMap _regex_infos;
+
+  /** The type of the argument feature structure */
+  type_t _type;
+
 };
 
 
@@ -555,6 +620,13 @@ private:
   void
   evaluate_poscons(std::string poscons_s);
 
+  /**
+   * Deletes the arguments of a rule that cannot be constructed, before
+   * the constructor throws and create() drops the rule.
+   */
+  void
+  discard_args();
+
   /** Identifier of the rule's type in PET's type system. */
   type_t _type;
 
@@ -691,9 +763,12 @@ public:
    * as the key. For example, if the argument's name
    * is "I2" and contains a regular expression "/(bar)rks/" in path "FORM",
    * then the matched substring "bar" is stored under key "${I2:FORM:1}".
+   * The regular expressions are checked before the unification, and their
+   * results are looked up in and added to \a memo.
    */
   tChartMappingMatch*
-  match(tItem *item, const tChartMappingRuleArg *arg, int loglevel);
+  match(tItem *item, const tChartMappingRuleArg *arg, tRegexMatchMemo &memo,
+      int loglevel);
 
   /**
    * Applies the rule of this completed match to the chart, that is
@@ -44,6 +44,9 @@ chart::chart(int len, auto_ptr<item_owner> owner)
 
 chart::~chart()
 {
+    // items created after the chart is gone must not go to its owner
+    if(tItem::default_owner() == _item_owner.get())
+        tItem::default_owner(NULL);
 }
 
 void chart::reset(int len)
@@ -53,6 +53,8 @@
 #include "settings.h"
 
 #include "api.h"
+#include "batch.h"
+#include "profiler.h"
 
 #ifdef YY
 #include "yy.h"
@@ -255,6 +257,155 @@ void print_result_as(string format, tItem *reading, ostream &out) {
   }
 }
 
+/** Parse \a input as item number \a id and print the results */
+static void parse_item(const string &input, int id, tTsdbDump &tsdb_dump) {
+  chart *Chart = 0;
+
+  // number the database rows after the input, also if the item fails before
+  // it has a chart, and in a worker of parallel_batch(), which does not see
+  // all items
+  tsdb_dump.start();
+  tsdb_dump.set_id(id);
+
+  try {
+    fs_alloc_state FSAS;
+
+    list<tError> errors;
+    analyze(input, Chart, FSAS, errors, id);
+    if(!errors.empty())
+      throw errors.front();
+
+    /// \todo Who needs this? Can we remove it? (pead 01.04.2008)
+    if(verbosity == -1)
+      fprintf(stdout, "%d\t%d\t%d\n", stats.id, stats.readings, stats.pedges);
+
+    string surface = Chart->get_surface_string();
+
+    fprintf(fstatus,
+            "(%d) `%s' [%d] --- %s%d (%.2f|%.2fs) <%d:%d> (%.1fK) [%.1fs]\n",
+            stats.id, surface.c_str(),
+            get_opt_int("opt_pedgelimit"),
+            (stats.readings && stats.rreadings ? "*" : ""), stats.readings,
+            stats.first/1000., stats.tcpu / 1000.,
+            stats.words, stats.pedges, stats.dyn_bytes / 1024.0,
+            TotalParseTime.elapsed_ts() / 10.);
+
+    if(verbosity > 0) stats.print(fstatus);
+
+    tsdb_dump.finish(Chart, surface);
+    dump_jxchg(surface, Chart);
+
+    //ofstream out("/tmp/final-chart-bernie");
+    //tTclChartPrinter chp(out, 0);
+    //tFegramedPrinter chp("/tmp/fed-");
+    //Chart->print(out, &chp, true, true);
+
+    const char * opt_mrs = get_opt_string("opt_mrs").c_str();
+    if (strlen(opt_mrs) == 0) opt_mrs = NULL;
+    if(verbosity > 1 || opt_mrs) {
+      int nres = 1;
+
+      item_list results(Chart->readings().begin()
+                              , Chart->readings().end());
+      // sorting was done already in parse_finish
+      // results.sort(item_greater_than_score());
+      int opt_nresults;
+      get_opt("opt_nresults", opt_nresults);
+      for(item_iter iter = results.begin()
+            ; (iter != results.end()
+               && ((opt_nresults == 0) || (opt_nresults >= nres)))
+            ; ++iter, ++nres) {
+        //tFegramedPrinter baseprint("/tmp/fed-");
+        //tLabelPrinter baseprint(pn) ;
+        //tDelegateDerivationPrinter deriv(cerr, baseprint, 2);
+        //tTSDBDerivationPrinter deriv(cerr, 1);
+        tCompactDerivationPrinter deriv(cerr);
+        tItem *it = *iter;
+
+        fprintf(fstatus, "derivation[%d]", nres);
+        fprintf(fstatus, " (%.4g)", it->score());
+        fprintf(fstatus, ":%s\n", it->get_yield().c_str());
+        if(verbosity > 2) {
+          deriv.print(it);
+          fprintf(fstatus, "\n");
+        }
+        if (opt_mrs != NULL) {
+          tProfilePhase phase(PHASE_MRS);
+          if ((strcmp(opt_mrs, "new") != 0)
+              && (strcmp(opt_mrs, "simple") != 0)) {
+#ifdef HAVE_MRS
+            string mrs;
+            if(it->trait() != PCFG_TRAIT)
+              mrs = ecl_cpp_extract_mrs(it->get_fs().dag(), opt_mrs);
+            if (mrs.empty()) {
+              fprintf(fstatus, "\n%s\n",
+                      ((strcmp(opt_mrs, "rmrx") == 0)
+                       ? "<rmrs cfrom='-2' cto='-2'>\n</rmrs>"
+                       : "No MRS"));
+            } else {
+              fprintf(fstatus, "%s\n", mrs.c_str());
+            }
+#endif
+          }
+          else {
+            print_mrs_as(opt_mrs[0], it->get_fs().dag(), cerr);
+          }
+        }
+      }
+
+      if(get_opt_bool("opt_partial") && (Chart->readings().empty())) {
+        list< tItem * > partials;
+        passive_weights pass;
+        Chart->shortest_path<unsigned int>(partials, pass, true);
+        bool rmrs_xml = (opt_mrs != NULL && strcmp(opt_mrs, "rmrx") == 0);
+        if (rmrs_xml) fprintf(fstatus, "\n<rmrs-list>\n");
+        for(item_iter it = partials.begin(); it != partials.end(); ++it) {
+          if(opt_mrs) {
+            tProfilePhase phase(PHASE_MRS);
+            tPhrasalItem *item = dynamic_cast<tPhrasalItem *>(*it);
+            if (item != NULL) {
+#ifdef HAVE_MRS
+              string mrs = ecl_cpp_extract_mrs(item->get_fs().dag(), opt_mrs);
+              if (! mrs.empty()) {
+                fprintf(fstatus, "%s\n", mrs.c_str());
+              }
+#else
+              if ((strcmp(opt_mrs, "new") == 0)
+                  || (strcmp(opt_mrs, "simple") == 0)) {
+                print_mrs_as(opt_mrs[0], item->get_fs().dag(), cerr);
+              }
+#endif
+            }
+          }
+        }
+        if (rmrs_xml) fprintf(fstatus, "</rmrs-list>\n");
+        else fprintf(fstatus, "EOM\n");
+      }
+    }
+  } /* try */
+
+  catch(tError e) {
+    // shouldn't this be fstatus?? it's a "return value"
+    fprintf(ferr, "%s\n", e.getMessage().c_str());
+    if (verbosity > 0)
+      stats.print(fstatus);
+    stats.readings = -1;
+
+    if (Chart != NULL) {
+      string surface = Chart->get_surface_string();
+      dump_jxchg(surface, Chart);
+      tsdb_dump.error(Chart, surface, e);
+    } else {
+      tsdb_dump.error(Chart, input, e);
+    }
+  }
+
+  fflush(fstatus);
+  Profiler.finish_item();
+
+  if(Chart != 0) delete Chart;
+}
+
 void interactive() {
   string input;
   int id = 1;
@@ -276,146 +427,27 @@ void interactive() {
   ifstream ifs;
   ifs.open(infile.c_str());
   istream& lexinput = ifs ? ifs : cin;
-  while(Lexparser.next_input(lexinput, input)) {
-    chart *Chart = 0;
-
-    tsdb_dump.start();
-
-    try {
-      fs_alloc_state FSAS;
-
-      list<tError> errors;
-      analyze(input, Chart, FSAS, errors, id);
-      if(!errors.empty())
-        throw errors.front();
-
-      /// \todo Who needs this? Can we remove it? (pead 01.04.2008)
-      if(verbosity == -1)
-        fprintf(stdout, "%d\t%d\t%d\n", stats.id, stats.readings, stats.pedges);
-
-      string surface = Chart->get_surface_string();
-
-      fprintf(fstatus,
-              "(%d) `%s' [%d] --- %s%d (%.2f|%.2fs) <%d:%d> (%.1fK) [%.1fs]\n",
-              stats.id, surface.c_str(),
-              get_opt_int("opt_pedgelimit"),
-              (stats.readings && stats.rreadings ? "*" : ""), stats.readings,
-              stats.first/1000., stats.tcpu / 1000.,
-              stats.words, stats.pedges, stats.dyn_bytes / 1024.0,
-              TotalParseTime.elapsed_ts() / 10.);
-
-      if(verbosity > 0) stats.print(fstatus);
-
-      tsdb_dump.finish(Chart, surface);
-      dump_jxchg(surface, Chart);
-
-      //ofstream out("/tmp/final-chart-bernie");
-      //tTclChartPrinter chp(out, 0);
-      //tFegramedPrinter chp("/tmp/fed-");
-      //Chart->print(out, &chp, true, true);
-
-      const char * opt_mrs = get_opt_string("opt_mrs").c_str();
-      if (strlen(opt_mrs) == 0) opt_mrs = NULL;
-      if(verbosity > 1 || opt_mrs) {
-        int nres = 1;
-
-        item_list results(Chart->readings().begin()
-                                , Chart->readings().end());
-        // sorting was done already in parse_finish
-        // results.sort(item_greater_than_score());
-        int opt_nresults;
-        get_opt("opt_nresults", opt_nresults);
-        for(item_iter iter = results.begin()
-              ; (iter != results.end()
-                 && ((opt_nresults == 0) || (opt_nresults >= nres)))
-              ; ++iter, ++nres) {
-          //tFegramedPrinter baseprint("/tmp/fed-");
-          //tLabelPrinter baseprint(pn) ;
-          //tDelegateDerivationPrinter deriv(cerr, baseprint, 2);
-          //tTSDBDerivationPrinter deriv(cerr, 1);
-          tCompactDerivationPrinter deriv(cerr);
-          tItem *it = *iter;
-
-          fprintf(fstatus, "derivation[%d]", nres);
-          fprintf(fstatus, " (%.4g)", it->score());
-          fprintf(fstatus, ":%s\n", it->get_yield().c_str());
-          if(verbosity > 2) {
-            deriv.print(it);
-            fprintf(fstatus, "\n");
-          }
-          if (opt_mrs != NULL) {
-            if ((strcmp(opt_mrs, "new") != 0)
-                && (strcmp(opt_mrs, "simple") != 0)) {
-#ifdef HAVE_MRS
-              string mrs;
-              if(it->trait() != PCFG_TRAIT)
-                mrs = ecl_cpp_extract_mrs(it->get_fs().dag(), opt_mrs);
-              if (mrs.empty()) {
-                fprintf(fstatus, "\n%s\n",
-                        ((strcmp(opt_mrs, "rmrx") == 0)
-                         ? "<rmrs cfrom='-2' cto='-2'>\n</rmrs>"
-                         : "No MRS"));
-              } else {
-                fprintf(fstatus, "%s\n", mrs.c_str());
-              }
-#endif
-            }
-            else {
-              print_mrs_as(opt_mrs[0], it->get_fs().dag(), cerr);
-            }
-          }
-        }
 
-        if(get_opt_bool("opt_partial") && (Chart->readings().empty())) {
-          list< tItem * > partials;
-          passive_weights pass;
-          Chart->shortest_path<unsigned int>(partials, pass, true);
-          bool rmrs_xml = (opt_mrs != NULL && strcmp(opt_mrs, "rmrx") == 0);
-          if (rmrs_xml) fprintf(fstatus, "\n<rmrs-list>\n");
-          for(item_iter it = partials.begin(); it != partials.end(); ++it) {
-            if(opt_mrs) {
-              tPhrasalItem *item = dynamic_cast<tPhrasalItem *>(*it);
-              if (item != NULL) {
-#ifdef HAVE_MRS
-                string mrs = ecl_cpp_extract_mrs(item->get_fs().dag(), opt_mrs);
-                if (! mrs.empty()) {
-                  fprintf(fstatus, "%s\n", mrs.c_str());
-                }
-#else
-                if ((strcmp(opt_mrs, "new") == 0)
-                    || (strcmp(opt_mrs, "simple") == 0)) {
-                  print_mrs_as(opt_mrs[0], item->get_fs().dag(), cerr);
-                }
-#endif
-              }
-            }
-          }
-          if (rmrs_xml) fprintf(fstatus, "</rmrs-list>\n");
-          else fprintf(fstatus, "EOM\n");
-        }
-      }
-    } /* try */
+  int jobs = get_opt_int("opt_jobs");
+  if(jobs > 1 && get_opt_charp("opt_compute_qc") != NULL) {
+    LOG(logAppl, WARN, "quickcheck computation needs all items in one "
+        "process, ignoring -jobs.");
+    jobs = 1;
+  }
+  if(jobs > 1 && ! get_opt_string("opt_tagger").empty()) {
+    LOG(logAppl, WARN, "the external tagger can not be shared by several "
+        "processes, ignoring -jobs.");
+    jobs = 1;
+  }
 
-    catch(tError e) {
-      // shouldn't this be fstatus?? it's a "return value"
-      fprintf(ferr, "%s\n", e.getMessage().c_str());
-      if (verbosity > 0)
-        stats.print(fstatus);
-      stats.readings = -1;
-
-      if (Chart != NULL) {
-        string surface = Chart->get_surface_string();
-        dump_jxchg(surface, Chart);
-        tsdb_dump.error(Chart, surface, e);
-      }
+  if(jobs > 1) {
+    parallel_batch(lexinput, jobs, tsdb_dump, parse_item);
+  } else {
+    while(Lexparser.next_input(lexinput, input)) {
+      parse_item(input, id, tsdb_dump);
+      id++;
     }
-
-    fflush(fstatus);
-
-    if(Chart != 0) delete Chart;
-
-    id++;
-  } /* while */
+  }
 
   if(get_opt_charp("opt_compute_qc") != NULL) {
     ofstream qc(get_opt_charp("opt_compute_qc"));
@@ -861,6 +893,22 @@ static void init_main_options() {
 
   managed_opt("opt_take", "use take processing mode: mrs|trees|both", string());
 
+  managed_opt("opt_jobs",
+              "number of worker processes parsing batch input in parallel; "
+              "output is still printed in input order. In server mode, the "
+              "number of pre-forked workers serving clients",
+              1);
+
+  managed_opt("opt_server_items",
+              "number of items after which a server worker is replaced by a "
+              "fresh one (0: never)",
+              0);
+
+  managed_opt("opt_server_memory",
+              "growth of the dynamic memory in MB after which a server worker "
+              "is replaced by a fresh one (0: never)",
+              0);
+
   managed_opt("opt_jxchg_dir",
               "write parse charts in jxchg format to the given directory",
               string());
@@ -1051,8 +1099,13 @@ int main(int argc, char* argv[]) {
        usage(stderr);
        exit(1);
      }
-     if (! get_opt_string("opt_take").empty())
+     // before any mode starts, the servers do not return
+     Profiler.open(get_opt_string("opt_profile"));
+     if (! get_opt_string("opt_take").empty()) {
+       if (get_opt_int("opt_jobs") > 1)
+         throw tError("-jobs can not be used with -take");
        take_process(grammar_file_name);
+     }
      else
        process(grammar_file_name);
   }
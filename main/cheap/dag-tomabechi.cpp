@@ -24,6 +24,7 @@
 #include "tsdb++.h"
 #include "options.h"
 #include "logging.h"
+#include "profiler.h"
 #include <iomanip>
 
 using namespace std;
@@ -99,7 +100,18 @@ dag_unify(dag_node *root, dag_node *dag1, dag_node *dag2, list_int *del) {
 
   unification_cost = 0;
 
-  if((res = recfail<false>::dag_unify1(dag1, dag2)) != FAIL) {
+  if(Profiler.active()) {
+    cycle_count_t start = cycle_count();
+    res = recfail<false>::dag_unify1(dag1, dag2);
+    cycle_count_t unified = cycle_count();
+    Profiler.unify_cycles += unified - start;
+    if(res != FAIL) {
+      ++stats.copies;
+      res = dag_copy(root, del);
+      Profiler.copy_cycles += cycle_count() - unified;
+    }
+  }
+  else if((res = recfail<false>::dag_unify1(dag1, dag2)) != FAIL) {
     ++stats.copies;
     res = dag_copy(root, del);
   }
@@ -111,6 +123,12 @@ dag_unify(dag_node *root, dag_node *dag1, dag_node *dag2, list_int *del) {
 
 dag_node *dag_unify_temp(dag_node *root, dag_node *dag1, dag_node *dag2) {
   unification_cost = 0;
+  if(Profiler.active()) {
+    cycle_count_t start = cycle_count();
+    dag_node *res = recfail<false>::dag_unify1(dag1, dag2);
+    Profiler.unify_cycles += cycle_count() - start;
+    return res == FAIL ? FAIL : root;
+  }
   if(recfail<false>::dag_unify1(dag1, dag2) == FAIL)
     return FAIL;
   else
@@ -29,6 +29,7 @@
 #include "settings.h"
 
 #include <list>
+#include <set>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -51,7 +52,7 @@ inline static void
 filter_items(const item_list &items,
     bool skip_blocked,
     bool skip_pending_inflrs,
-    item_list &skip,
+    const item_list &skip,
     item_list &result)
 {
   item_list::const_iterator it;
@@ -79,6 +80,8 @@ tChart::clear()
   _vertex_to_ending_items.clear();
   _item_to_prec_vertex.clear();
   _item_to_succ_vertex.clear();
+  _succeeding_cache.clear();
+  _preceding_cache.clear();
 }
 
 std::list<tChartVertex*>
@@ -126,6 +129,8 @@ tChart::add_item(tItem *item, tChartVertex *prec, tChartVertex *succ)
   _item_to_succ_vertex[item] = succ;
   _vertex_to_starting_items[prec].push_back(item);
   _vertex_to_ending_items[succ].push_back(item);
+  _succeeding_cache.clear();
+  _preceding_cache.clear();
 
   item->notify_chart_changed(this);
 
@@ -144,6 +149,8 @@ tChart::remove_item(tItem *item)
   _item_to_prec_vertex.erase(item);
   _item_to_succ_vertex.erase(item);
   _items.remove(item);
+  _succeeding_cache.clear();
+  _preceding_cache.clear();
 
   item->notify_chart_changed(0);
 
@@ -192,19 +199,20 @@ tChart::items(tChartVertex *prec, tChartVertex *succ, bool skip_blocked,
 
 static void
 succeeding_items(tChartVertex *v, int min, int max,
-              bool skip_blocked, bool skip_pending_inflrs, item_list skip,
-              int dist, item_list &result, std::list<tChartVertex*> &vertices) {
-  vertices.push_back(v);
+              bool skip_blocked, bool skip_pending_inflrs,
+              const item_list &skip,
+              int dist, item_list &result, std::set<tChartVertex*> &vertices) {
+  vertices.insert(v);
   if (dist > max)
     return;
-  item_list items = v->starting_items();
+  const item_list items = v->starting_items();
   // add filtered succeeding items to the result list:
   if ((min <= dist) && (dist <= max))
     filter_items(items, skip_blocked, skip_pending_inflrs, skip, result);
   // schedule processing of all vertices not processed before:
-  for (item_iter iit = items.begin(); iit != items.end(); ++iit) {
+  for (item_citer iit = items.begin(); iit != items.end(); ++iit) {
     tChartVertex *next = (*iit)->succ_vertex();
-    if (find(vertices.begin(), vertices.end(), next) == vertices.end()) {
+    if (vertices.find(next) == vertices.end()) {
       succeeding_items(next, min, max, skip_blocked, skip_pending_inflrs, skip,
           dist+1, result, vertices);
     }
@@ -215,7 +223,7 @@ item_list
 tChart::succeeding_items(tChartVertex *v, int min, int max, bool skip_blocked,
                          bool skip_pending_inflrs, item_list skip) {
   item_list result;
-  std::list<tChartVertex*> vertices; // processed vertices
+  std::set<tChartVertex*> vertices; // processed vertices
   ::succeeding_items(v, min, max, skip_blocked, skip_pending_inflrs, skip, 0,
       result, vertices);
   return result;
@@ -223,19 +231,20 @@ tChart::succeeding_items(tChartVertex *v, int min, int max, bool skip_blocked,
 
 static void
 preceding_items(tChartVertex *v, int min, int max,
-              bool skip_blocked, bool skip_pending_inflrs, item_list skip,
-              int dist, item_list &result, std::list<tChartVertex*> &vertices) {
-  vertices.push_back(v);
+              bool skip_blocked, bool skip_pending_inflrs,
+              const item_list &skip,
+              int dist, item_list &result, std::set<tChartVertex*> &vertices) {
+  vertices.insert(v);
   if (dist > max)
     return;
-  item_list items = v->ending_items();
+  const item_list items = v->ending_items();
   // add filtered preceding items to the result list:
   if ((min <= dist) && (dist <= max))
     filter_items(items, skip_blocked, skip_pending_inflrs, skip, result);
   // schedule processing of all vertices not processed before:
-  for (item_iter iit = items.begin(); iit != items.end(); ++iit) {
+  for (item_citer iit = items.begin(); iit != items.end(); ++iit) {
     tChartVertex *next = (*iit)->prec_vertex();
-    if (find(vertices.begin(), vertices.end(), next) == vertices.end()) {
+    if (vertices.find(next) == vertices.end()) {
       preceding_items(next, min, max, skip_blocked, skip_pending_inflrs, skip,
           dist+1, result, vertices);
     }
@@ -246,12 +255,36 @@ item_list
 tChart::preceding_items(tChartVertex *v, int min, int max, bool skip_blocked,
                          bool skip_pending_inflrs, item_list skip) {
   item_list result;
-  std::list<tChartVertex*> vertices; // processed vertices
+  std::set<tChartVertex*> vertices; // processed vertices
   ::preceding_items(v, min, max, skip_blocked, skip_pending_inflrs, skip, 0,
       result, vertices);
   return result;
 }
 
+bool
+tChart::is_succeeding_item(tItem *item, tChartVertex *v, int min, int max) {
+  tItemSetCache::key_type key(v, std::make_pair(min, max));
+  tItemSetCache::iterator it = _succeeding_cache.find(key);
+  if (it == _succeeding_cache.end()) {
+    item_list items = succeeding_items(v, min, max);
+    it = _succeeding_cache.insert(std::make_pair(key,
+        std::set<tItem*>(items.begin(), items.end()))).first;
+  }
+  return it->second.find(item) != it->second.end();
+}
+
+bool
+tChart::is_preceding_item(tItem *item, tChartVertex *v, int min, int max) {
+  tItemSetCache::key_type key(v, std::make_pair(min, max));
+  tItemSetCache::iterator it = _preceding_cache.find(key);
+  if (it == _preceding_cache.end()) {
+    item_list items = preceding_items(v, min, max);
+    it = _preceding_cache.insert(std::make_pair(key,
+        std::set<tItem*>(items.begin(), items.end()))).first;
+  }
+  return it->second.find(item) != it->second.end();
+}
+
 bool
 tChart::connected() {
   if(_vertices.empty()) return true;
@@ -36,6 +36,7 @@
 
 #include <list>
 #include <map>
+#include <set>
 #include <vector>
 
 
@@ -79,6 +80,15 @@ private:
   std::map<tItem*, tChartVertex* > _item_to_prec_vertex;
   std::map<tItem*, tChartVertex* > _item_to_succ_vertex;
 
+  /**
+   * The results of succeeding_items() and preceding_items() for a vertex
+   * and a distance range, as needed by is_succeeding_item() and
+   * is_preceding_item(). They are discarded whenever the chart changes.
+   */
+  typedef std::map<std::pair<tChartVertex*, std::pair<int, int> >,
+                   std::set<tItem*> > tItemSetCache;
+  tItemSetCache _succeeding_cache, _preceding_cache;
+
   /**
    * Copy construction and assignment are disallowed.
    */
@@ -215,6 +225,20 @@ public:
   preceding_items(tChartVertex *v, int min, int max, bool skip_blocked = false,
       bool skip_pending_inflrs = false, item_list skip = item_list());
 
+  /**
+   * Checks whether \a item is one of succeeding_items(v, min, max). The
+   * succeeding items are computed once and kept until the chart changes.
+   */
+  bool
+  is_succeeding_item(tItem *item, tChartVertex *v, int min, int max);
+
+  /**
+   * Checks whether \a item is one of preceding_items(v, min, max). The
+   * preceding items are computed once and kept until the chart changes.
+   */
+  bool
+  is_preceding_item(tItem *item, tChartVertex *v, int min, int max);
+
   /**
    * Checks whether the chart is connected. That means it should have
    * exactly one start and exactly one end vertex where a start/end vertex is
@@ -680,6 +680,27 @@ qc_vec fs::get_qc_vector(qc_node *qc_paths, int qc_len) const {
   return vector;
 }
 
+void
+fs::signature_compatible_subs(const path_types &a, const path_types &b,
+                              bool &forward, bool &backward) {
+  bool st_a_b, st_b_a;
+  path_types::const_iterator i = a.begin(), j = b.begin();
+  while(i != a.end() && j != b.end()) {
+    if(i->first < j->first)
+      ++i;
+    else if(j->first < i->first)
+      ++j;
+    else {
+      if(i->second != j->second) {
+        subtype_bidir(i->second, j->second, st_a_b, st_b_a);
+        if(st_a_b == false) { backward = false; if (forward == false) return; }
+        if(st_b_a == false) { forward = false; if (backward == false) return; }
+      }
+      ++i; ++j;
+    }
+  }
+}
+
 /** Initialize the static variables for quick check appropriately */
 void
 fs::init_qc_unif(dumper *f, bool subs_too) {
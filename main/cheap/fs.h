@@ -37,6 +37,13 @@
 typedef std::list< std::pair<std::string, type_t> > modlist;
 typedef type_t *qc_vec;
 
+/** The maximal length of the paths in a subsumption signature, see
+ *  fs::get_subs_signature()
+ */
+#define SUBS_SIGNATURE_DEPTH 4
+/** The maximal number of paths in a subsumption signature */
+#define SUBS_SIGNATURE_PATHS 256
+
 /** Adapter for different dag implementations */
 class fs
 {
@@ -272,6 +279,33 @@ class fs
     }
   }
 
+  /** Return the subsumption signature of a feature structure: the types at
+   *  (at most \c SUBS_SIGNATURE_PATHS) paths of length up to
+   *  \c SUBS_SIGNATURE_DEPTH. The signature is empty if the paths can not be
+   *  encoded for the attributes of this grammar.
+   */
+  inline void get_subs_signature(path_types &signature) const {
+    dag_get_path_types(_dag, SUBS_SIGNATURE_DEPTH, SUBS_SIGNATURE_PATHS,
+                       signature);
+    // do not keep the spare capacity with every item
+    path_types(signature).swap(signature);
+  }
+
+  /** Check the subsumption signatures \a a and \a b for compatibility with
+   *  respect to subsumption in both directions, analogous to
+   *  qc_compatible_subs().
+   *
+   *  Only the paths that exist in both signatures are compared. The
+   *  subsumption check visits all of them, so this is a necessary condition
+   *  for subsumption, even if \a a or \a b are not fully expanded. An empty
+   *  signature is compatible with every other one.
+   *  \attention \a forward and \a backward must be \c true when calling this
+   *  function.
+   */
+  static void
+  signature_compatible_subs(const path_types &a, const path_types &b,
+                            bool &forward, bool &backward);
+
  private:
 
   dag_node *_dag;
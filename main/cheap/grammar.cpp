@@ -435,6 +435,8 @@ undump_dags(dumper *f) {
 // Construct a grammar object from binary representation in a file
 tGrammar::tGrammar(const char * filename)
     : _properties(), _root_insts(0), _generics(0),
+      _lex_rules_active(false), _syn_rules_active(false),
+      _rule_index_null(0),
       _deleted_daughters(0), _packing_restrictor(0),
       _sm(0), _lexsm(0), _pcfgsm(0), _gm(0)
 {
@@ -508,7 +510,7 @@ tGrammar::tGrammar(const char * filename)
         {
             lex_stem *st = new lex_stem(i);
             _lexicon[i] = st;
-            _stemlexicon.insert(make_pair(st->orth(st->inflpos()), st));
+            _stemlexicon.add(st->orth(st->inflpos()), st);
 #if defined(YY)
             if(get_opt_bool("opt_yy") && st->length() > 1)
                 // for multiwords, insert additional index entry
@@ -516,7 +518,7 @@ tGrammar::tGrammar(const char * filename)
                 string full = st->orth(0);
                 for(int i = 1; i < st->length(); ++i)
                     full += string(" ") + string(st->orth(i));
-                _stemlexicon.insert(make_pair(full.c_str(), st));
+                _stemlexicon.add(full, st);
             }
 #endif
         }
@@ -562,6 +564,7 @@ tGrammar::tGrammar(const char * filename)
           _lexicon[i] = new lex_stem(i);
         }
     }
+    _stemlexicon.finalize();
 
     int id = 0;
     // number the rules such that the lexical rules have the lower IDs
@@ -595,6 +598,7 @@ tGrammar::tGrammar(const char * filename)
     if(get_opt_bool("opt_filter")) {
       initialize_filter();
     }
+    initialize_rule_index();
 
     //
     // avoid costly load of the various statistical models, when unneeded
@@ -822,6 +826,29 @@ tGrammar::init_parameters()
           "packing enabled but no restrictor - packing disabled");
       opt_packing = 0;
     }
+
+    // optionally keep the glbs of the most queried types in a dense table
+    const char *glbtable = cheap_settings->value("glb-table-types");
+    if(glbtable != NULL) {
+      const char *warmup = cheap_settings->value("glb-table-warmup");
+      init_glb_table(strtoint(glbtable, "as value of glb-table-types"),
+                     warmup != NULL
+                     ? strtoint(warmup, "as value of glb-table-warmup")
+                     : 100000);
+    }
+
+    // the number of lexicon entries that keep their feature structure, see
+    // lex_stem::instantiate(); there is no cache unless this is set
+    lex_stem::_ncached = 0;
+    lex_stem::_max_cached = 0;
+    const char *cachesize = cheap_settings->value("lexicon-cache-size");
+    if(cachesize != NULL) {
+      int size = strtoint(cachesize, "as value of lexicon-cache-size");
+      if(size < 0)
+        throw tError(string("negative integer `") + cachesize
+                     + "' as value of lexicon-cache-size");
+      lex_stem::_max_cached = size;
+    }
 }
 
 void
@@ -875,6 +902,36 @@ tGrammar::initialize_filter() {
   S0.clear_stats();
 }
 
+void
+tGrammar::initialize_rule_index() {
+  // the rules ordered by id, i.e., the lexical rules first
+  vector<grammar_rule *> rules(_lex_rules.begin(), _lex_rules.end());
+  rules.insert(rules.end(), _syn_rules.begin(), _syn_rules.end());
+  int nrules = rules.size();
+  _rule_index_null = nrules;
+
+  _rule_index.clear();
+  _rule_index_offsets.clear();
+  int nlexrules = _lex_rules.size();
+  for(int d = 0; d <= nrules; ++d) {
+    grammar_rule *daughter = (d < nrules) ? rules[d] : NULL;
+    assert(daughter == NULL || daughter->id() == d);
+    _rule_index_offsets.push_back(_rule_index.size());
+    for(int m = 0; m < nrules; ++m) {
+      if(m == nlexrules)
+        _rule_index_offsets.push_back(_rule_index.size());
+      grammar_rule *mother = rules[m];
+      if(filter_compatible(mother, mother->nextarg(), daughter))
+        _rule_index.push_back(mother);
+    }
+    if(nlexrules == nrules)
+      _rule_index_offsets.push_back(_rule_index.size());
+    _rule_index_offsets.push_back(_rule_index.size());
+  }
+  // filtered_rules() takes the address of the first element
+  if(_rule_index.empty()) _rule_index.push_back(NULL);
+}
+
 
 tGrammar::~tGrammar()
 {
@@ -974,21 +1031,16 @@ tGrammar::lookup_stem(string s)
     set<type_t> native_types;
 #endif
 
-    pair<multimap<string, lex_stem *>::iterator,
-        multimap<string, lex_stem *>::iterator> eq =
-        _stemlexicon.equal_range(s);
+    _stemlexicon.lookup(s, results);
 
-    for(multimap<string, lex_stem *>::iterator it = eq.first;
-        it != eq.second; ++it)
-    {
-        results.push_back(it->second);
 #ifdef HAVE_EXTDICT
-        if(_extDict)
-        {
-            native_types.insert(_extDict->equiv_rep(leaftype_parent(it->second->type())));
-        }
-#endif
+    if(_extDict)
+    {
+        for(list<lex_stem *>::iterator it = results.begin();
+            it != results.end(); ++it)
+            native_types.insert(_extDict->equiv_rep(leaftype_parent((*it)->type())));
     }
+#endif
 
 #ifdef HAVE_EXTDICT
     if(!_extDict)
@@ -312,6 +312,28 @@ public:
 
   /** Return the number of rules in this grammar */
   inline const rulelist &rules() { return _rules; }
+
+  /** Return the number of currently active rules */
+  inline int nactive_rules() {
+    const int *offsets = &_rule_index_offsets[3 * _rule_index_null];
+    return offsets[_syn_rules_active ? 2 : 1]
+      - offsets[_lex_rules_active ? 0 : 1];
+  }
+
+  /** Return the active rules that may take a passive item built with \a
+   *  daughter (\c NULL for lexical and input items) as their next argument
+   *  according to the rule filter, in the order of rules(). The rules are
+   *  returned as the contiguous array [\a begin, \a end).
+   */
+  inline void filtered_rules(grammar_rule *daughter,
+                             grammar_rule * const *&begin,
+                             grammar_rule * const *&end) {
+    const int *offsets = &_rule_index_offsets[3 * (daughter == NULL
+                                                   ? _rule_index_null
+                                                   : daughter->id())];
+    begin = &_rule_index[0] + offsets[_lex_rules_active ? 0 : 1];
+    end = &_rule_index[0] + offsets[_syn_rules_active ? 2 : 1];
+  }
   /** Return list of lexical rules in this grammar */
   inline const rulelist &lexrules() { return _lex_rules; }
 
@@ -364,24 +386,28 @@ public:
   /** deactivate all rules */
   void deactivate_all_rules() {
     _rules.clear();
+    _lex_rules_active = _syn_rules_active = false;
   }
   
   /** activate all (and only) lexical and inflection rules */
   void activate_lex_rules() {
     deactivate_all_rules();
     _rules.insert(_rules.end(), _lex_rules.begin(), _lex_rules.end());
+    _lex_rules_active = true;
   }
 
   /** activate syntactic rules only */
   void activate_syn_rules() {
     deactivate_all_rules();
     _rules.insert(_rules.end(), _syn_rules.begin(), _syn_rules.end());
+    _syn_rules_active = true;
   }
 
   /** activate all available rules */
   void activate_all_rules() {
     activate_lex_rules();
     _rules.insert(_rules.end(), _syn_rules.begin(), _syn_rules.end());
+    _syn_rules_active = true;
   }
 
   /** Return the grammar_rule pointer for type \a type or NULL, if not
@@ -411,7 +437,7 @@ public:
   std::map<std::string, std::string> _properties;
 
   std::map<type_t, lex_stem *> _lexicon;
-  std::multimap<std::string, lex_stem *> _stemlexicon;
+  tStemIndex _stemlexicon;
 
 #ifdef EXTDICT
   extDictionary *_extDict;
@@ -458,6 +484,21 @@ public:
   rulefilter _subsumption_filter;
   void initialize_filter();
 
+  /** Which of the rule sets make up the currently active rules */
+  bool _lex_rules_active, _syn_rules_active;
+
+  /** For every rule as daughter and for lexical items, the rules that pass
+   *  the rule filter with it as their next argument, ordered by id. Since
+   *  the lexical rules have the lower ids, these are a list of lexical
+   *  followed by a list of syntactic rules. \c _rule_index_offsets holds
+   *  the start of both lists and the end of the second for every daughter,
+   *  lexical items being number \c _rule_index_null.
+   */
+  std::vector<grammar_rule *> _rule_index;
+  std::vector<int> _rule_index_offsets;
+  int _rule_index_null;
+  void initialize_rule_index();
+
   list_int *_deleted_daughters;
   class restrictor *_packing_restrictor;
 
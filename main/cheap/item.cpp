@@ -36,6 +36,7 @@
 #include "configs.h"
 #include "logging.h"
 
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <sys/times.h>
@@ -145,7 +146,7 @@ tItem::tItem(int start, int end, const tPaths &paths,
       _spanningonly(false), _paths(paths),
       _fs(f), _tofill(0), _nfilled(0), _inflrs_todo(0), _prefix_lrs(0),
       _result_root(-1), _result_contrib(false),
-      _qc_vector_unif(0), _qc_vector_subs(0),
+      _qc_vector_unif(0), _qc_vector_subs(0), _subs_signature_done(false),
       _score(0.0), _gmscore(0.0), _printname(printname),
       _blocked(0), _unpack_cache(0), parents(), packed(), _chart(0)
 {
@@ -158,7 +159,7 @@ tItem::tItem(int start, int end, const tPaths &paths,
       _start(start), _end(end), _spanningonly(false), _paths(paths),
       _fs(), _tofill(0), _nfilled(0), _inflrs_todo(0), _prefix_lrs(0),
       _result_root(-1), _result_contrib(false),
-      _qc_vector_unif(0), _qc_vector_subs(0),
+      _qc_vector_unif(0), _qc_vector_subs(0), _subs_signature_done(false),
       _score(0.0), _gmscore(0.0), _printname(printname),
       _blocked(0), _unpack_cache(0), parents(), packed(), _chart(0)
 {
@@ -909,6 +910,9 @@ tItem::block(int mark, bool freeze_parents)
 
     _blocked = mark;
   }
+  // a frosted item takes part in no packing any more
+  if (frosted())
+    release_subs_signature();
   if (freeze_parents) {
     for (item_iter p = parents.begin(); p != parents.end(); ++p) {
       (*p)->freeze();
@@ -1130,19 +1134,113 @@ tPhrasalItem::unpack_combine(vector<tItem *> &daughters) {
   return result;
 }
 
+//
+// grandparenting paths and hypothesis agendas of selective unpacking
+//
+
+/** hash function for item lists, only looking at the item addresses */
+struct item_list_hash {
+  inline size_t operator()(const item_list &path) const {
+    size_t h = 0;
+    for(item_citer it = path.begin(); it != path.end(); ++it)
+      h = h * 31 + (size_t) *it;
+    return h;
+  }
+};
+
+unsigned int tUnpackPaths::_gplevel = 0;
+tPathId tUnpackPaths::_first = 0;
+deque<item_list> tUnpackPaths::_items;
+
+/** the ids of the interned paths */
+static HASH_SPACE::hash_map<item_list, tPathId, item_list_hash> path_ids;
+/** for every path, the extensions computed so far, indexed by the item */
+static deque<HASH_SPACE::hash_map<tItem *, tPathId> > path_extensions;
+
+tPathId
+tUnpackPaths::reset(unsigned int gplevel) {
+  _gplevel = gplevel;
+  // continue numbering after the paths of the last run
+  _first += _items.size();
+  _items.clear();
+  path_ids.clear();
+  path_extensions.clear();
+
+  item_list root;
+  root.push_back(NULL); // root path
+  while (root.size() > gplevel)
+    root.pop_front();
+  return intern(root);
+}
+
+tPathId
+tUnpackPaths::intern(const item_list &path) {
+  HASH_SPACE::hash_map<item_list, tPathId, item_list_hash>::iterator it
+    = path_ids.find(path);
+  if (it != path_ids.end())
+    return it->second;
+
+  tPathId id = _first + _items.size();
+  _items.push_back(path);
+  path_extensions.push_back(HASH_SPACE::hash_map<tItem *, tPathId>());
+  path_ids[path] = id;
+  return id;
+}
+
+tPathId
+tUnpackPaths::extend(tPathId path, tItem *item) {
+  HASH_SPACE::hash_map<tItem *, tPathId> &extensions
+    = path_extensions[path - _first];
+  HASH_SPACE::hash_map<tItem *, tPathId>::iterator it = extensions.find(item);
+  if (it != extensions.end())
+    return it->second;
+
+  item_list extended = _items[path - _first];
+  extended.push_back(item);
+  if (extended.size() > _gplevel)
+    extended.pop_front();
+  tPathId result = intern(extended);
+  extensions[item] = result;
+  return result;
+}
+
+void
+tHypothesisAgenda::push(tHypothesis *hypo, double score) {
+  entry e = { score, _added++, hypo };
+  _heap.push_back(e);
+  push_heap(_heap.begin(), _heap.end(), worse);
+}
+
+tHypothesis *
+tHypothesisAgenda::pop() {
+  pop_heap(_heap.begin(), _heap.end(), worse);
+  tHypothesis *hypo = _heap.back().hypo;
+  _heap.pop_back();
+  return hypo;
+}
+
+void
+tHypothesisAgenda::delete_all() {
+  for (vector<entry>::iterator it = _heap.begin(); it != _heap.end(); ++it)
+    delete it->hypo;
+  _heap.clear();
+}
+
 tHypothesis *
-tInputItem::hypothesize_edge(list<tItem*> path, unsigned int i) {
+tInputItem::hypothesize_edge(tPathId path, unsigned int i) {
   return NULL;
 }
 
 tHypothesis *
-tLexItem::hypothesize_edge(list<tItem*> path, unsigned int i) {
+tLexItem::hypothesize_edge(tPathId path, unsigned int i) {
   if (i == 0) {
     if (_hypo == NULL) {
       _hypo = new tHypothesis(this);
       stats.p_hypotheses ++;
     }
-    Grammar->sm()->score_hypothesis(_hypo, path, opt_gplevel);
+    // the score of a lexical hypothesis only depends on the path
+    if (_hypo->scores.find(path) == NULL)
+      Grammar->sm()->score_hypothesis(_hypo, path, opt_gplevel);
 
     return _hypo;
   } else
@@ -1150,7 +1248,7 @@ tLexItem::hypothesize_edge(list<tItem*> path, unsigned int i) {
 }
 
 tHypothesis *
-tPhrasalItem::hypothesize_edge(list<tItem*> path, unsigned int i)
+tPhrasalItem::hypothesize_edge(tPathId path, unsigned int i)
 {
   tHypothesis *hypo = NULL;
 
@@ -1161,37 +1259,31 @@ tPhrasalItem::hypothesize_edge(list<tItem*> path, unsigned int i)
       return hypo;
   }
 
-  // Only check the path length no longer than the opt_gplevel
-  while (path.size() > opt_gplevel)
-    path.pop_front();
-
-  if (_hypo_agendas.find(path) == _hypo_agendas.end()) {
+  map<tPathId, tPathHypotheses>::iterator found = _hypotheses_path.find(path);
+  if (found == _hypotheses_path.end()) {
     // This is a new path:
     // * initialize the agenda
     // * score the hypotheses
     // * create the hypothese cache
-    _hypo_agendas[path].clear();
+    found = _hypotheses_path.insert(make_pair(path, tPathHypotheses())).first;
     for (vector<tHypothesis*>::iterator h = _hypotheses.begin();
          h != _hypotheses.end(); ++h) {
-      Grammar->sm()->score_hypothesis(*h, path, opt_gplevel);
-      hagenda_insert(_hypo_agendas[path], *h, path);
+      double hscore = Grammar->sm()->score_hypothesis(*h, path, opt_gplevel);
+      found->second.agenda.push(*h, hscore);
     }
-    _hypo_path_max[path] = UINT_MAX;
   }
+  tPathHypotheses &hypos = found->second;
 
   // Check cached hypotheses
-  if (i < _hypotheses_path[path].size() && _hypotheses_path[path][i])
-    return _hypotheses_path[path][i];
+  if (i < hypos.ranked.size() && hypos.ranked[i])
+    return hypos.ranked[i];
 
   // Quick return for failed hypothesis
-  if (i >= _hypo_path_max[path])
+  if (i >= hypos.max)
     return NULL;
 
   // Create new path for daughters
-  list<tItem*> newpath = path;
-  newpath.push_back(this);
-  if (newpath.size() > opt_gplevel)
-    newpath.pop_front();
+  tPathId newpath = tUnpackPaths::extend(path, this);
 
   // Initialize the set of decompositions and pushing initial
   // hypotheses onto the local agenda when called on an edge for the
@@ -1220,9 +1312,8 @@ tPhrasalItem::hypothesize_edge(list<tItem*> path, unsigned int i)
     }
   }
 
-  while (!_hypo_agendas[path].empty() && i >= _hypotheses_path[path].size()) {
-    hypo = _hypo_agendas[path].front();
-    _hypo_agendas[path].pop_front();
+  while (!hypos.agenda.empty() && i >= hypos.ranked.size()) {
+    hypo = hypos.agenda.pop();
     list<vector<int> > indices_adv = advance_indices(hypo->indices);
 
     while (!indices_adv.empty()) {
@@ -1265,15 +1356,15 @@ tPhrasalItem::hypothesize_edge(list<tItem*> path, unsigned int i)
         new_hypothesis(hypo->decomposition, dtrs, indices);
     }
     //    if (!hypo->inst_failed) // this will cause missing readings when used with grandparenting
-    _hypotheses_path[path].push_back(hypo);
+    hypos.ranked.push_back(hypo);
   }
-  if (i < _hypotheses_path[path].size()){
-    if (_hypo_agendas[path].size() == 0)
-      _hypo_path_max[path] = _hypotheses_path[path].size();
-    return _hypotheses_path[path][i];
+  if (i < hypos.ranked.size()){
+    if (hypos.agenda.empty())
+      hypos.max = hypos.ranked.size();
+    return hypos.ranked[i];
   }
   else {
-    _hypo_path_max[path] = _hypotheses_path[path].size();
+    hypos.max = hypos.ranked.size();
     return NULL;
   }
   //  return hypo;
@@ -1325,10 +1416,11 @@ tPhrasalItem::new_hypothesis(tDecomposition* decomposition,
   tHypothesis *hypo = new tHypothesis(this, decomposition, dtrs, indices);
   stats.p_hypotheses ++;
   _hypotheses.push_back(hypo);
-  for (map<list<tItem*>, list<tHypothesis*> >::iterator iter = _hypo_agendas.begin();
-       iter != _hypo_agendas.end(); ++iter) {
-    Grammar->sm()->score_hypothesis(hypo, (*iter).first, opt_gplevel);
-    hagenda_insert(_hypo_agendas[(*iter).first], hypo, (*iter).first);
+  for (map<tPathId, tPathHypotheses>::iterator iter = _hypotheses_path.begin();
+       iter != _hypotheses_path.end(); ++iter) {
+    double hscore
+      = Grammar->sm()->score_hypothesis(hypo, (*iter).first, opt_gplevel);
+    (*iter).second.agenda.push(hypo, hscore);
   }
 }
 
@@ -1428,14 +1520,11 @@ tItem::selectively_unpack(list<tItem*> roots, int nsolutions,
   if (nsolutions <= 0)
     return results;
 
-  list<tHypothesis*> ragenda;
+  tPathId path = tUnpackPaths::reset(opt_gplevel);
+  tHypothesisAgenda ragenda;
   tHypothesis* aitem;
 
   tHypothesis* hypo;
-  list<tItem*> path;
-  path.push_back(NULL); // root path
-  while (path.size() > opt_gplevel)
-    path.pop_front();
 
   for (item_iter it = roots.begin(); it != roots.end(); ++it) {
     tPhrasalItem* root = (tPhrasalItem*)(*it);
@@ -1445,7 +1534,7 @@ tItem::selectively_unpack(list<tItem*> roots, int nsolutions,
       // Grammar->sm()->score_hypothesis(hypo);
       aitem = new tHypothesis(root, hypo, 0);
       stats.p_hypotheses ++;
-      hagenda_insert(ragenda, aitem, path);
+      ragenda.push(aitem, aitem->scores[path]);
     }
     for (item_iter edge = root->packed.begin();
          edge != root->packed.end(); ++edge) {
@@ -1458,13 +1547,12 @@ tItem::selectively_unpack(list<tItem*> roots, int nsolutions,
       //Grammar->sm()->score_hypothesis(hypo);
       aitem = new tHypothesis(*edge, hypo, 0);
       stats.p_hypotheses ++;
-      hagenda_insert(ragenda, aitem, path);
+      ragenda.push(aitem, aitem->scores[path]);
     }
   }
 
   while (!ragenda.empty() && nsolutions > 0) {
-    aitem = ragenda.front();
-    ragenda.pop_front();
+    aitem = ragenda.pop();
     tItem *result = aitem->edge->instantiate_hypothesis(path, aitem->hypo_dtrs.front(), upedgelimit, memlimit);
     if (upedgelimit > 0 && stats.p_upedges > upedgelimit) {
       return results;
@@ -1473,6 +1561,9 @@ tItem::selectively_unpack(list<tItem*> roots, int nsolutions,
     if (result &&
         (result->trait() == PCFG_TRAIT || result->root(Grammar, end, rule))) {
       result->set_result_root(rule);
+      // the result may have been instantiated by an earlier unpacking of
+      // this chart, with the score of another grandparenting context
+      result->score(aitem->scores[path]);
       results.push_back(result);
       --nsolutions;
       if (nsolutions == 0) {
@@ -1486,33 +1577,31 @@ tItem::selectively_unpack(list<tItem*> roots, int nsolutions,
       //Grammar->sm()->score_hypothesis(hypo);
       tHypothesis* naitem = new tHypothesis(aitem->edge, hypo, aitem->indices[0]+1);
       stats.p_hypotheses ++;
-      hagenda_insert(ragenda, naitem, path);
+      ragenda.push(naitem, naitem->scores[path]);
     }
     delete aitem;
   }
 
   //_fix_me release memory allocated
-  for (list<tHypothesis*>::iterator it = ragenda.begin();
-       it != ragenda.end(); ++it)
-    delete *it;
+  ragenda.delete_all();
 
   return results;
 }
 
 tItem*
-tInputItem::instantiate_hypothesis(list<tItem*> path, tHypothesis * hypo, int upedgelimit, long memlimit) {
+tInputItem::instantiate_hypothesis(tPathId path, tHypothesis * hypo, int upedgelimit, long memlimit) {
   score(hypo->scores[path]);
   return this;
 }
 
 tItem *
-tLexItem::instantiate_hypothesis(list<tItem*> path, tHypothesis * hypo, int upedgelimit, long memlimit) {
+tLexItem::instantiate_hypothesis(tPathId path, tHypothesis * hypo, int upedgelimit, long memlimit) {
   score(hypo->scores[path]);
   return this;
 }
 
 tItem *
-tPhrasalItem::instantiate_hypothesis(list<tItem*> path, tHypothesis * hypo, int upedgelimit, long memlimit)
+tPhrasalItem::instantiate_hypothesis(tPathId path, tHypothesis * hypo, int upedgelimit, long memlimit)
 {
 
   // Check if we reached the unpack edge limit. Caller is responsible for
@@ -1532,14 +1621,7 @@ tPhrasalItem::instantiate_hypothesis(list<tItem*> path, tHypothesis * hypo, int
 
   vector<tItem*> daughters;
 
-  // Only check the path length no longer than the opt_gplevel
-  while (path.size() > opt_gplevel)
-    path.pop_front();
-
-  list<tItem*> newpath = path;
-  newpath.push_back(this);
-  if (newpath.size() > opt_gplevel)
-    newpath.pop_front();
+  tPathId newpath = tUnpackPaths::extend(path, this);
 
   // Instantiate all the sub hypotheses.
   for (list<tHypothesis*>::iterator subhypo = hypo->hypo_dtrs.begin();
@@ -1622,22 +1704,3 @@ list<vector<int> > advance_indices(vector<int> indices) {
   }
   return results;
 }
-
-void hagenda_insert(list<tHypothesis*> &agenda, tHypothesis* hypo, list<tItem*> path) {
-  if (agenda.empty()) {
-    agenda.push_back(hypo);
-    return;
-  }
-  int flag = 0;
-  for (list<tHypothesis*>::iterator it = agenda.begin();
-       it != agenda.end(); ++it) {
-    if (hypo->scores[path] > (*it)->scores[path]) {
-      agenda.insert(it, hypo);
-      flag = 1;
-      break;
-    }
-  }
-  if (!flag)
-    agenda.push_back(hypo);
-}
-
@@ -33,6 +33,9 @@
 #include "paths.h"
 #include "postags.h"
 #include "hashing.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
 #include <functional>
 #include <ios>
 
@@ -74,6 +77,94 @@ typedef std::list< tInputItem * > inp_list;
 /** Iterator for inp_list */
 typedef inp_list::iterator inp_iterator;
 
+/** The identifier of an interned grandparenting path, cf. tUnpackPaths */
+typedef long long tPathId;
+
+/** The grandparenting paths of selective unpacking, i.e., the up to
+ *  \c opt_gplevel nearest ancestors of an edge, starting with the most
+ *  remote one. Every path is interned and represented by a small integer,
+ *  so that the per-path tables of items and hypotheses are keyed by
+ *  integers instead of item lists.
+ *
+ *  The paths refer to the items of the chart being unpacked, so they are
+ *  only valid until the next call of tItem::selectively_unpack(). Their ids
+ *  are not reused, though: the hypotheses and scores of items that are
+ *  unpacked again, e.g., by the robust PCFG fallback, are keyed by the ids of
+ *  earlier runs, which must not match the paths of the current one.
+ */
+class tUnpackPaths {
+public:
+  /** Forget all paths and start a new unpacking run with paths of length at
+   *  most \a gplevel. \return the path of the root edges.
+   */
+  static tPathId reset(unsigned int gplevel);
+
+  /** \return \a path extended by \a item, without its first element if it
+   *  gets too long.
+   */
+  static tPathId extend(tPathId path, tItem *item);
+
+  /** \return the items of \a path */
+  static const item_list &items(tPathId path) {
+    return _items[path - _first];
+  }
+
+private:
+  static tPathId intern(const item_list &path);
+
+  static unsigned int _gplevel;
+  /** the id of the first path of the current run */
+  static tPathId _first;
+  /** the items of the paths of the current run */
+  static std::deque<item_list> _items;
+};
+
+/** The scores of a hypothesis for the paths it has been scored with, a
+ *  vector sorted by path id. New paths are interned with increasing ids, so
+ *  new scores are almost always appended.
+ */
+class tPathScores {
+public:
+  /** \return the score for \a path or NULL if there is none */
+  const double *find(tPathId path) const {
+    std::vector< std::pair<tPathId, double> >::const_iterator it
+      = std::lower_bound(_scores.begin(), _scores.end(),
+                         std::make_pair(path, -HUGE_VAL));
+    return (it != _scores.end() && it->first == path) ? &it->second : NULL;
+  }
+
+  /** \return the score for \a path, which is inserted if there is none */
+  double &operator[](tPathId path) {
+    if(_scores.empty() || _scores.back().first < path) {
+      _scores.push_back(std::make_pair(path, 0.0));
+      return _scores.back().second;
+    }
+    std::vector< std::pair<tPathId, double> >::iterator it
+      = std::lower_bound(_scores.begin(), _scores.end(),
+                         std::make_pair(path, -HUGE_VAL));
+    if(it == _scores.end() || it->first != path)
+      it = _scores.insert(it, std::make_pair(path, 0.0));
+    return it->second;
+  }
+
+private:
+  std::vector< std::pair<tPathId, double> > _scores;
+};
+
+/** The scores of the model features of a local tree in one grandparenting
+ *  context, i.e., of all features of a hypothesis that do not depend on the
+ *  hypotheses of the daughters, cf. tSM::score_hypothesis().
+ */
+struct tLocalTreeScores
+{
+  /** the combined scores of the features with grandparenting level > 0 */
+  double context;
+  /** the level 0 feature of the rule and its key daughter */
+  double key;
+  /** the level 0 feature of the whole local tree */
+  double local;
+};
+
 /** Represent a possible (not necessarily valid) decomposition of an
     item. */
 struct tDecomposition
@@ -81,6 +172,10 @@ struct tDecomposition
 public:
   std::set< std::vector<int> > indices;
   item_list rhs;
+  /** The feature scores of this local tree, which are shared by all
+   *  hypotheses with this decomposition, for every path scored so far.
+   */
+  std::map<tPathId, tLocalTreeScores> scores;
   tDecomposition(item_list rhs) {
     this->rhs = rhs;
   }
@@ -93,7 +188,7 @@ public:
 struct tHypothesis
 {
 public:
-  std::map<item_list,double> scores;
+  tPathScores scores;
   tItem* edge;
   tItem* inst_edge;
   bool inst_failed;
@@ -136,6 +231,41 @@ public:
   }
 };
 
+/** The agenda of hypotheses for one grandparenting path, a binary heap
+ *  ordered by the hypotheses' scores for this path. Hypotheses with equal
+ *  scores are taken in the order they were added.
+ */
+class tHypothesisAgenda {
+public:
+  tHypothesisAgenda() : _added(0) {}
+
+  /** Add \a hypo, which has \a score for the path of this agenda */
+  void push(tHypothesis *hypo, double score);
+
+  /** Remove and return the best hypothesis */
+  tHypothesis *pop();
+
+  bool empty() const { return _heap.empty(); }
+
+  /** Delete all hypotheses still on the agenda */
+  void delete_all();
+
+private:
+  struct entry {
+    double score;
+    unsigned long added;
+    tHypothesis *hypo;
+  };
+
+  /** Heap order: the entry that is to be taken first is the greatest */
+  static bool worse(const entry &a, const entry &b) {
+    return a.score < b.score || (a.score == b.score && a.added > b.added);
+  }
+
+  unsigned long _added;
+  std::vector<entry> _heap;
+};
+
 
 // #define CFGAPPROX_LEXGEN 1
 
@@ -426,6 +556,27 @@ public:
    */
   inline const qc_vec &qc_vector_subs() const { return _qc_vector_subs; }
 
+  /** \brief Return the subsumption signature of the (restricted) feature
+   *  structure of this passive item, which is used to rule out packing
+   *  candidates before the real subsumption check. It is computed on first
+   *  use.
+   */
+  const path_types &subs_signature() {
+    if(!_subs_signature_done) {
+      get_fs().get_subs_signature(_subs_signature);
+      _subs_signature_done = true;
+    }
+    return _subs_signature;
+  }
+
+  /** \brief Release the subsumption signature of an item that is no packing
+   *  candidate any more. It is computed again if it is needed after all.
+   */
+  void release_subs_signature() {
+    path_types().swap(_subs_signature);
+    _subs_signature_done = false;
+  }
+
   /** \brief Return the rule this item was built from. This returns values
    *  different from \c NULL only for phrasal items.
    */
@@ -527,7 +678,7 @@ protected:
    *
    *  \return the \a i th best hypothesis of the item
    */
-  virtual tHypothesis * hypothesize_edge(item_list path, unsigned int i) = 0;
+  virtual tHypothesis * hypothesize_edge(tPathId path, unsigned int i) = 0;
 
   /** \brief Base function that instantiate the hypothesis (and
    *   recursively instantiate its sub-hypotheses) until \a upedgelimit
@@ -535,7 +686,7 @@ protected:
    *
    *  \return the instantiated item from the hypothesis
    */
-  virtual tItem * instantiate_hypothesis(item_list path, tHypothesis * hypo, int upedgelimit, long memlimit) = 0;
+  virtual tItem * instantiate_hypothesis(tPathId path, tHypothesis * hypo, int upedgelimit, long memlimit) = 0;
 
 private:
   /**
@@ -591,6 +742,10 @@ private:
   qc_vec _qc_vector_unif;
   qc_vec _qc_vector_subs;
 
+  /** The subsumption signature, valid if \c _subs_signature_done */
+  path_types _subs_signature;
+  bool _subs_signature_done;
+
   double _score;
   double _gmscore;
 
@@ -857,8 +1012,8 @@ public:
 
   /** \brief tInputItem will not have items packed into them. They
       need not be unpacked. */
-  virtual tHypothesis * hypothesize_edge(std::list<tItem*> path, unsigned int i);
-  virtual tItem * instantiate_hypothesis(std::list<tItem*> path, tHypothesis * hypo, int upedgelimit, long memlimit);
+  virtual tHypothesis * hypothesize_edge(tPathId path, unsigned int i);
+  virtual tItem * instantiate_hypothesis(tPathId path, tHypothesis * hypo, int upedgelimit, long memlimit);
   //  virtual item_list selectively_unpack(int n, int upedgelimit);
 
   /** Return the external id associated with this item */
@@ -1030,8 +1185,8 @@ protected:
   /** \brief Return the \a i th best hypothesis. For tLexItem, there
    *   is always only one hypothesis, for a given \a path .
    */
-  virtual tHypothesis * hypothesize_edge(std::list<tItem*> path, unsigned int i);
-  virtual tItem * instantiate_hypothesis(std::list<tItem*> path, tHypothesis * hypo, int upedgelimit, long memlimit);
+  virtual tHypothesis * hypothesize_edge(tPathId path, unsigned int i);
+  virtual tItem * instantiate_hypothesis(tPathId path, tHypothesis * hypo, int upedgelimit, long memlimit);
   //  virtual item_list selectively_unpack(int n, int upedgelimit);
 
 private:
@@ -1192,10 +1347,10 @@ protected:
   //  virtual item_list selectively_unpack(int n, int upedgelimit);
 
   /** Get the \i th best hypothesis of the item with \a path to root. */
-  virtual tHypothesis * hypothesize_edge(std::list<tItem*> path, unsigned int i);
+  virtual tHypothesis * hypothesize_edge(tPathId path, unsigned int i);
 
   /** Instantiatve the hypothesis */
-  virtual tItem * instantiate_hypothesis(std::list<tItem*> path, tHypothesis * hypo, int upedgelimit, long memlimit);
+  virtual tItem * instantiate_hypothesis(tPathId path, tHypothesis * hypo, int upedgelimit, long memlimit);
 
   /** Decompose edge and return the number of decompositions
    * All the decompositions are recorded in this->decompositions .
@@ -1213,13 +1368,20 @@ private:
 
   /** A vector of hypotheses*/
   std::vector<tHypothesis*> _hypotheses;
-  /** a map from path to corresponding cached hypotheses */
-  std::map<std::list<tItem*>,std::vector<tHypothesis*> > _hypotheses_path;
-  /** a map from path to corresponding max number of hypothese */
-  std::map<std::list<tItem*>,unsigned int> _hypo_path_max;
 
-  /** Hypothesis agenda*/
-  std::map<std::list<tItem*>,std::list<tHypothesis*> > _hypo_agendas;
+  /** The hypotheses of this item in the context of one path */
+  struct tPathHypotheses {
+    tPathHypotheses() : max(UINT_MAX) {}
+    /** the hypotheses found so far, best first */
+    std::vector<tHypothesis*> ranked;
+    /** the candidates for the next hypotheses */
+    tHypothesisAgenda agenda;
+    /** the number of hypotheses, if all have been found */
+    unsigned int max;
+  };
+
+  /** The hypotheses for all paths this item has been hypothesized with */
+  std::map<tPathId, tPathHypotheses> _hypotheses_path;
 
   /** A list of decompositions */
   std::list<tDecomposition*> decompositions;
@@ -1238,11 +1400,6 @@ void propagate_failure(tHypothesis *hypo);
  */
 std::list<std::vector<int> > advance_indices(std::vector<int> indices);
 
-/** Insert hypothesis into agenda. Agenda is sorted descendingly
- *
- */
-void hagenda_insert(std::list<tHypothesis*> &agenda, tHypothesis* hypo, std::list<tItem*> path);
-
 // \todo _fix_me_
 #if 0
 class greater_than_score {
@@ -26,6 +26,10 @@
 #include "morph.h"
 #include "settings.h"
 #include "logging.h"
+#include "hashing.h"
+#include "dag.h"
+
+#include <map>
 
 using std::string;
 using std::list;
@@ -33,8 +37,37 @@ using std::vector;
 
 int lex_stem::next_id = 0;
 
+int lex_stem::_ncached = 0;
+
+int lex_stem::_max_cached = 0;
+
+/** The number of uses of an entry before its feature structure is cached */
+#define LEXICON_CACHE_THRESHOLD 2
+
 fs
 lex_stem::instantiate()
+{
+    if(_cached_dag != 0)
+        return fs(_cached_dag);
+
+    fs expanded = expand();
+
+    // keep the feature structures of entries that are used repeatedly. they
+    // are copied to permanent memory, which can not be freed again, so the
+    // cache is bounded by not accepting new entries when it is full.
+    if(++_uses >= LEXICON_CACHE_THRESHOLD && _ncached < _max_cached
+       && expanded.valid()) {
+        dag_invalidate_changes();
+        _cached_dag = dag_full_p_copy(expanded.dag());
+        dag_invalidate_changes();
+        ++_ncached;
+    }
+
+    return expanded;
+}
+
+fs
+lex_stem::expand()
 {
     fs e(_lexical_type);
 
@@ -76,7 +109,7 @@ lex_stem::get_stems() {
   fs_alloc_state FSAS;
   vector <string> orth;
   dag_node *dag = FAIL;
-  fs e = instantiate();
+  fs e = expand();
 
   if(e.valid())
     dag = dag_get_path_value(e.dag(),
@@ -154,7 +187,7 @@ lex_stem::lex_stem(type_t instance_type //, const modlist &mods
   : _id(next_id++), _instance_type(instance_type)
   , _lexical_type(lex_type == -1 ? leaftype_parent(instance_type) : lex_type)
                   // , _mods(mods)
-  , _orth(0) {
+  , _uses(0), _cached_dag(0), _orth(0) {
 
   if(orths.size() == 0) {
     vector<string> orth = get_stems();
@@ -201,3 +234,69 @@ lex_stem::~lex_stem()
     delete[] _orth;
 }
 
+
+
+void tStemIndex::add(const string &form, lex_stem *stem) {
+  _pending.push_back(std::make_pair(form, stem));
+}
+
+size_t tStemIndex::find_slot(const string &form) const {
+  size_t mask = _table.size() - 1;
+  size_t slot = bj_string_hash()(form) & mask;
+  while(_table[slot] != -1 && _forms[_table[slot]] != form)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+void tStemIndex::finalize() {
+  if(_pending.empty()) return;
+
+  // collect all entries again, grouped by form, keeping the order in which
+  // they were added
+  vector< std::pair<string, lex_stem *> > entries;
+  entries.reserve(_stems.size() + _pending.size());
+  for(size_t i = 0; i + 1 < _first.size(); ++i)
+    for(int j = _first[i]; j < _first[i + 1]; ++j)
+      entries.push_back(std::make_pair(_forms[i], _stems[j]));
+  entries.insert(entries.end(), _pending.begin(), _pending.end());
+  _pending.clear();
+
+  std::map<string, int> numbers;
+  vector<int> number(entries.size());
+  _forms.clear();
+  for(size_t i = 0; i < entries.size(); ++i) {
+    std::map<string, int>::iterator it = numbers.find(entries[i].first);
+    if(it == numbers.end()) {
+      it = numbers.insert(std::make_pair(entries[i].first,
+                                         (int) _forms.size())).first;
+      _forms.push_back(entries[i].first);
+    }
+    number[i] = it->second;
+  }
+
+  _first.assign(_forms.size() + 1, 0);
+  for(size_t i = 0; i < entries.size(); ++i)
+    ++_first[number[i] + 1];
+  for(size_t i = 1; i < _first.size(); ++i)
+    _first[i] += _first[i - 1];
+  _stems.resize(entries.size());
+  vector<int> next(_first.begin(), _first.end() - 1);
+  for(size_t i = 0; i < entries.size(); ++i)
+    _stems[next[number[i]]++] = entries[i].second;
+
+  // keep the table at most half full
+  size_t size = 1;
+  while(size < 2 * _forms.size()) size <<= 1;
+  _table.assign(size, -1);
+  for(size_t i = 0; i < _forms.size(); ++i)
+    _table[find_slot(_forms[i])] = i;
+}
+
+void tStemIndex::lookup(const string &form, list<lex_stem *> &result) const {
+  assert(_pending.empty());
+  if(_table.empty()) return;
+  int i = _table[find_slot(form)];
+  if(i == -1) return;
+  for(int j = _first[i]; j < _first[i + 1]; ++j)
+    result.push_back(_stems[j]);
+}
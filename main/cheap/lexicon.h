@@ -26,6 +26,10 @@
 
 #include "types.h"
 
+#include <string>
+#include <list>
+#include <vector>
+
 /** A lexicon entry. */
 class lex_stem
 {
@@ -54,8 +58,13 @@ class lex_stem
            , const std::list<std::string> &orths = std::list<std::string>());
   ~lex_stem();
 
-  /** (Re)create the feature structure for this entry from the dags of the
-   *  instance and the root type of the instance.
+  /** Return the feature structure for this entry, i.e., the unification of
+   *  the dags of the instance and the root type of the instance.
+   *
+   *  The feature structures of entries that are used repeatedly are kept in
+   *  permanent memory, up to the number of entries given by the setting
+   *  \c lexicon-cache-size. The cache is off by default. Callers must not
+   *  modify the result destructively.
    */
   class fs instantiate();
 
@@ -109,6 +118,21 @@ class lex_stem
 
   // modlist _mods;
 
+  /** The number of calls to instantiate() so far */
+  int _uses;
+  /** The permanent copy of the feature structure of this entry, if any */
+  struct dag_node *_cached_dag;
+
+  /** The number of entries whose feature structure is cached */
+  static int _ncached;
+  /** The maximal number of cached entries, set by tGrammar from the setting
+   *  \c lexicon-cache-size
+   */
+  static int _max_cached;
+
+  /** Compute the feature structure for this entry, bypassing the cache */
+  class fs expand();
+
   /** length of _orth */
   int _nwords;
   /** array of _nwords strings */
@@ -123,4 +147,45 @@ inline std::ostream &operator<<(std::ostream &out, const lex_stem &ls){
   ls.print(out); return out;
 }
 
+/** An index from base forms to lexicon entries, using a hash table with open
+ *  addressing. The entries for one form are stored next to each other.
+ *
+ *  All entries have to be added with add() before finalize() builds the
+ *  table. lookup() returns the entries for a form in the order in which
+ *  they were added.
+ */
+class tStemIndex
+{
+ public:
+  tStemIndex() {}
+
+  /** Add \a stem as an entry for \a form */
+  void add(const std::string &form, lex_stem *stem);
+
+  /** Build the hash table from the entries added so far */
+  void finalize();
+
+  /** Append all entries for \a form to \a result */
+  void lookup(const std::string &form, std::list<lex_stem *> &result) const;
+
+ private:
+  /** The entries added since the last call to finalize() */
+  std::vector< std::pair<std::string, lex_stem *> > _pending;
+
+  /** The distinct forms */
+  std::vector<std::string> _forms;
+  /** The entries for form \c i are _stems[_first[i] .. _first[i + 1]) */
+  std::vector<int> _first;
+  std::vector<lex_stem *> _stems;
+  /** The hash table: form numbers, -1 for empty slots. Its size is a power
+   *  of two.
+   */
+  std::vector<int> _table;
+
+  /** Return the slot of \a form in _table, or of the empty slot where it
+   *  belongs.
+   */
+  size_t find_slot(const std::string &form) const;
+};
+
 #endif
@@ -33,6 +33,7 @@
 #include "settings.h"
 #include "configs.h"
 #include "logging.h"
+#include "profiler.h"
 
 #include <iostream>
 
@@ -172,6 +173,7 @@ list<lex_stem *> lex_parser::get_lex_entries(string stem) {
 list<tMorphAnalysis> lex_parser::morph_analyze(string form) {
   if (_morphs.empty())
     throw tError("No morphology registered");
+  tProfilePhase phase(PHASE_MORPHOLOGY);
   return call_resp_chain<tMorphAnalysis>(_morphs.begin(), _morphs.end(), form);
 }
 
@@ -881,26 +883,30 @@ lex_parser::process_input(string input, inp_list &inp_tokens,
   // through command line option.                              (5-aug-11; oe)
   int chart_mapping_loglevel = get_opt_int("opt_chart_mapping");
 
-  // Tokenize the input
-  tokenize(input, inp_tokens);
+  {
+    tProfilePhase phase(PHASE_TOKENIZATION);
 
-  //
-  // non-vanilla tokenizers can delete pieces of input (e.g. mark-up), hence we
-  // might be looking at an empty token sequence at this point.  no point in
-  // going through further processing (and making sure all downstream modules
-  // robustly treat an empty input).
-  //
-  if(inp_tokens.empty()) return 0;
+    // Tokenize the input
+    tokenize(input, inp_tokens);
+
+    //
+    // non-vanilla tokenizers can delete pieces of input (e.g. mark-up), hence
+    // we might be looking at an empty token sequence at this point.  no point
+    // in going through further processing (and making sure all downstream
+    // modules robustly treat an empty input).
+    //
+    if(inp_tokens.empty()) return 0;
 
-  // Attach POS tags to the input
-  tag(input, inp_tokens);
+    // Attach POS tags to the input
+    tag(input, inp_tokens);
 
-  // NE recognition has to care about morphology itself
-  ne_recognition(input, inp_tokens);
+    // NE recognition has to care about morphology itself
+    ne_recognition(input, inp_tokens);
 
-  // map the input positions into chart positions
-  position_map position_mapping = _tokenizers.front()->position_mapping();
-  _maxpos = map_positions(inp_tokens, position_mapping);
+    // map the input positions into chart positions
+    position_map position_mapping = _tokenizers.front()->position_mapping();
+    _maxpos = map_positions(inp_tokens, position_mapping);
+  }
 
   const char *foo = cheap_settings->value("tokenizer-output");
   string format = (foo != NULL ? foo : "");
@@ -927,6 +933,7 @@ lex_parser::process_input(string input, inp_list &inp_tokens,
 
   // token mapping:
   if (chart_mapping) {
+    tProfilePhase phase(PHASE_CHART_MAPPING);
     if (LOG_ENABLED(logChartMapping, NOTICE) || chart_mapping_loglevel & 1) {
       fprintf(stderr, "[cm] token mapping starts\n");
     }
@@ -1044,6 +1051,7 @@ lex_parser::lexical_parsing(inp_list &inp_tokens,
 
   // Lexical chart mapping (a.k.a. lexical filtering):
   if (chart_mapping) {
+    tProfilePhase phase(PHASE_CHART_MAPPING);
     if (LOG_ENABLED(logChartMapping, NOTICE) || chart_mapping_loglevel & 1)
       fprintf(stderr, "[cm] lexical filtering starts\n");
     // map to tChart:
@@ -1076,6 +1084,7 @@ void
 lex_parser::lexical_processing(inp_list &inp_tokens
                                , bool chart_mapping, bool lex_exhaustive
                                , fs_alloc_state &FSAS, list<tError> &errors) {
+  tProfilePhase phase(PHASE_LEXICAL_PARSING);
 
   lexical_parsing(inp_tokens, chart_mapping, lex_exhaustive, FSAS, errors);
 
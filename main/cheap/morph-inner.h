@@ -145,6 +145,10 @@ private:
 
 
 
+/** A node of the trie that is built while the morphological rules are
+ *  added. It is compiled into the flat representation of morph_trie before
+ *  it is used for analysis.
+ */
 class trie_node {
   typedef std::map<MChar, trie_node *> tn_map;
   typedef tn_map::iterator tn_iterator;
@@ -178,13 +182,15 @@ private:
   tn_map _s;
 
   std::vector<morph_subrule *> _rules;
+
+  friend class morph_trie;
 };
 
 class morph_trie
 {
 public:
   morph_trie(tMorphAnalyzer *a, bool suffix) :
-    _analyzer(a), _suffix(suffix), _root()
+    _analyzer(a), _suffix(suffix), _root(), _compiled(false)
   {};
 
   void add_subrule(grammar_rule *rule, std::string subrule);
@@ -194,9 +200,41 @@ public:
   void print(std::ostream &) const;
 
 private:
+  /** A node of the compiled trie: its outgoing arcs are
+   *  _arcs[first_arc .. end_arc), sorted by label, and the subrules that are
+   *  completely matched when reaching it are _rules[first_rule .. end_rule).
+   */
+  struct flat_node {
+    int first_arc, end_arc;
+    int first_rule, end_rule;
+  };
+
+  struct flat_arc {
+    MChar label;
+    int target;
+    bool operator<(const flat_arc &other) const {
+      return label < other.label;
+    }
+  };
+
+  /** Copy the trie rooted in _root breadth first into the contiguous arrays
+   *  _nodes, _arcs and _rules. Node 0 is the root.
+   */
+  void compile();
+
+  /** Return the node reached from \a node with an arc labeled \a c, or -1
+   *  if there is no such arc.
+   */
+  int follow(int node, MChar c) const;
+
   tMorphAnalyzer *_analyzer;
   bool _suffix;
   trie_node _root;
+
+  bool _compiled;
+  std::vector<flat_node> _nodes;
+  std::vector<flat_arc> _arcs;
+  std::vector<morph_subrule *> _rules;
 };
 
 inline std::ostream &operator<<(std::ostream &out, const morph_lettersets &ml) {
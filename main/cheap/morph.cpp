@@ -31,6 +31,7 @@
 #include "settings.h"
 #include "configs.h"
 #include "logging.h"
+#include "tsdb++.h"
 
 #include <boost/graph/transitive_closure.hpp>
 #include <boost/graph/adjacency_list.hpp>
@@ -49,6 +50,9 @@ Converter *Conv = &Convert;
 
 #define LETTERSET_CHAR ((MChar) '\x8')
 
+/** The default number of surface forms whose analyses are cached */
+#define DEFAULT_MORPH_CACHE_SIZE 10000
+
 bool operator==(const tMorphAnalysis &a, const tMorphAnalysis &b) {
   if (a.base() != b.base()) return false;
   ruleiter ar, ae, br, be;
@@ -558,7 +562,52 @@ void morph_trie::add_subrule(grammar_rule *rule, string subrule)
   morph_subrule *sr = new morph_subrule(_analyzer, rule, left, right);
   _analyzer->add_subrule(sr);
   _root.add_path(right, sr, _analyzer->_lettersets);
+  _compiled = false;
+}
+
+void morph_trie::compile()
+{
+  _nodes.clear();
+  _arcs.clear();
+  _rules.clear();
+
+  // the nodes are numbered in the order in which they are copied, so the
+  // arcs of a node can point to nodes that are copied later
+  std::vector<const trie_node *> queue;
+  queue.push_back(&_root);
+  for(size_t i = 0; i < queue.size(); ++i) {
+    const trie_node *node = queue[i];
+    flat_node flat;
+    flat.first_arc = _arcs.size();
+    for(trie_node::tn_const_iterator it = node->_s.begin();
+        it != node->_s.end(); ++it) {
+      flat_arc arc;
+      arc.label = it->first;
+      arc.target = queue.size();
+      _arcs.push_back(arc);
+      queue.push_back(it->second);
+    }
+    flat.end_arc = _arcs.size();
+    flat.first_rule = _rules.size();
+    _rules.insert(_rules.end(), node->_rules.begin(), node->_rules.end());
+    flat.end_rule = _rules.size();
+    _nodes.push_back(flat);
+  }
 
+  _compiled = true;
+}
+
+int morph_trie::follow(int node, MChar c) const
+{
+  flat_arc key;
+  key.label = c;
+  std::vector<flat_arc>::const_iterator begin
+    = _arcs.begin() + _nodes[node].first_arc;
+  std::vector<flat_arc>::const_iterator end
+    = _arcs.begin() + _nodes[node].end_arc;
+  std::vector<flat_arc>::const_iterator it = lower_bound(begin, end, key);
+  if(it == end || it->label != c) return -1;
+  return it->target;
 }
 
 /** Remove all possible prefixes (or suffixes) encoded in this trie from the
@@ -567,12 +616,14 @@ void morph_trie::add_subrule(grammar_rule *rule, string subrule)
 list<tMorphAnalysis> morph_trie::analyze(tMorphAnalysis analysis) {
   list<tMorphAnalysis> res;
 
+  if(! _compiled) compile();
+
   MString s = Conv->convert(analysis.base());
   if(_suffix) s.reverse();
 
   MString matched;
 
-  const trie_node *node = &_root;
+  int node = 0;
 
   while(s.length() > 0)
   {
@@ -582,13 +633,16 @@ list<tMorphAnalysis> morph_trie::analyze(tMorphAnalysis analysis) {
 
     // is there a branch at this trie node labeled with character c?
     // If not so, we are done
-    if (! node->has_subnode(c)) return res;
-    node = node->get_node(c);
+    node = follow(node, c);
+    if (node < 0) return res;
 
     // Iterate through all subrules that have been matched completedly when
     // arriving at the current trie node.
-    for(vector<morph_subrule *>::const_iterator r = node->rules().begin();
-        r != node->rules().end(); ++r)
+    vector<morph_subrule *>::const_iterator rules_end
+      = _rules.begin() + _nodes[node].end_rule;
+    for(vector<morph_subrule *>::const_iterator r
+          = _rules.begin() + _nodes[node].first_rule;
+        r != rules_end; ++r)
     {
       MString base;
       // Can the rule reduce the string "matched + s" to a valid base form ?
@@ -695,7 +749,8 @@ tMorphAnalyzer::tMorphAnalyzer()
     _suffixrules(this, true),
     _prefixrules(this, false),
     _irregs_only(false),
-    _duplicate_filter_p(false), _maximal_depth(0), _minimal_stem_length(0) {
+    _duplicate_filter_p(false), _maximal_depth(0), _minimal_stem_length(0),
+    _cache_size(DEFAULT_MORPH_CACHE_SIZE), _cache_hits(0), _cache_misses(0) {
   const char *md = cheap_settings->value("orthographemics-maximum-chain-depth");
   if(md != 0)
     _maximal_depth
@@ -705,6 +760,13 @@ tMorphAnalyzer::tMorphAnalyzer()
       = strtoint(md, "as value of orthographemics-minimum-stem-length");
   if(cheap_settings->lookup("orthographemics-duplicate-filter"))
     _duplicate_filter_p = true;
+  if((md = cheap_settings->value("orthographemics-cache-size")) != 0) {
+    int size = strtoint(md, "as value of orthographemics-cache-size");
+    if(size < 0)
+      throw tError(string("negative integer `") + md
+                   + "' as value of orthographemics-cache-size");
+    _cache_size = size;
+  }
 }
 
 tMorphAnalyzer::~tMorphAnalyzer()
@@ -1029,6 +1091,41 @@ void debug_morph(list<tMorphAnalysis> results) {
 
 
 list<tMorphAnalysis> tMorphAnalyzer::analyze(string form)
+{
+  if(_cache_size == 0)
+    return compute_analyses(form);
+
+  analysis_cache_index::iterator it = _cache_index.find(form);
+  if(it != _cache_index.end()) {
+    ++_cache_hits;
+    ++stats.morph_cache_hits;
+    // move the entry to the front
+    _cache.splice(_cache.begin(), _cache, it->second);
+    LOG(logMorph, DEBUG, "tMorphAnalyzer::analyze(" << form << "): cached ("
+        << _cache_hits << " hits, " << _cache_misses << " misses)");
+    return it->second->second;
+  }
+
+  ++_cache_misses;
+  ++stats.morph_cache_misses;
+  if(_cache_index.size() >= _cache_size) {
+    // forget the least recently used entry
+    _cache_index.erase(_cache.back().first);
+    _cache.pop_back();
+  }
+  _cache.push_front(make_pair(form, compute_analyses(form)));
+  _cache_index[form] = _cache.begin();
+  return _cache.front().second;
+}
+
+void tMorphAnalyzer::set_cache_size(unsigned int size)
+{
+  _cache.clear();
+  _cache_index.clear();
+  _cache_size = size;
+}
+
+list<tMorphAnalysis> tMorphAnalyzer::compute_analyses(const string &form)
 {
   LOG(logMorph, DEBUG, "tMorphAnalyzer::analyze(" << form << ")");
 
@@ -175,7 +175,9 @@ class tMorphAnalyzer
    */
   void undo_letterset_bindings();
 
-  /** Take a surface form and return a list of morphological analyses */
+  /** Take a surface form and return a list of morphological analyses.
+   *  The results for the most recently analyzed forms are cached.
+   */
   std::list<tMorphAnalysis> analyze(std::string form);
   /** Generate a surface form from a morphological analysis */
   std::string generate(tMorphAnalysis);
@@ -183,6 +185,17 @@ class tMorphAnalyzer
   /** Print the contents of this analyzer for debugging purposes */
   void print(std::ostream &) const;
 
+  /** The number of calls to analyze() answered from the cache */
+  unsigned long cache_hits() const { return _cache_hits; }
+  /** The number of calls to analyze() that had to do the analysis */
+  unsigned long cache_misses() const { return _cache_misses; }
+  /** The maximal number of forms in the cache */
+  unsigned int cache_size() const { return _cache_size; }
+  /** Empty the cache and keep at most \a size forms from now on, none if
+   *  \a size is zero.
+   */
+  void set_cache_size(unsigned int size);
+
   /** Initialize the special filter for morphology analysis */
   void initialize_lexrule_filter();
 
@@ -201,6 +214,9 @@ class tMorphAnalyzer
 
   void parse_rule(grammar_rule *, std::string rule, bool suffix);
 
+  /** Compute the morphological analyses of \a form, bypassing the cache */
+  std::list<tMorphAnalysis> compute_analyses(const std::string &form);
+
   void analyze1(tMorphAnalysis form, std::list<tMorphAnalysis> &result);
   bool matching_irreg_form(tMorphAnalysis a);
 
@@ -234,6 +250,20 @@ class tMorphAnalyzer
   std::multimap<std::string, tMorphAnalysis *> _irregs_by_stem;
   std::multimap<std::string, tMorphAnalysis *> _irregs_by_form;
 
+  typedef std::list< std::pair< std::string, std::list<tMorphAnalysis> > >
+    analysis_cache;
+  typedef HASH_SPACE::hash_map< std::string, analysis_cache::iterator,
+                                standard_string_hash > analysis_cache_index;
+  /** The analyses of the most recently analyzed forms, the most recently used
+   *  one first. It survives from one input to the next.
+   */
+  analysis_cache _cache;
+  analysis_cache_index _cache_index;
+  /** The maximal number of forms in the cache, zero disables caching.
+   *  Gets the value of the setting \c orthographemics-cache-size.
+   */
+  unsigned int _cache_size;
+  unsigned long _cache_hits, _cache_misses;
 
   friend class morph_trie;
 };
@@ -258,6 +288,9 @@ public:
 
   virtual std::string description() { return "LKB style morphology"; }
 
+  /** The analyzer doing the work, e.g., to control its cache */
+  tMorphAnalyzer &analyzer() { return _morph; }
+
 private:
   tLKBMorphology() {}
   void undump_inflrs(class dumper &dmp);
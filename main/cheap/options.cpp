@@ -105,6 +105,19 @@ void usage(FILE *f)
           "enable chart pruning. Strategy can be (a)ll, (s)uccessful and (p)assive (default).\n");
   fprintf(f, "  `-inputfile=file' --- "
           "name of input file to read from instead of standard input\n");
+  fprintf(f, "  `-jobs=n' --- "
+          "parse batch input with n worker processes (output in input order)\n");
+  fprintf(f, "  `-server-items=n' --- "
+          "in server mode with -jobs, replace a worker after n items\n");
+  fprintf(f, "  `-server-memory=n' --- "
+          "in server mode with -jobs, replace a worker after it grew by n MB\n");
+  fprintf(f, "  `-best-first[=n]' --- "
+          "parse best-first by parse selection scores, keeping at most n "
+          "phrasal tasks\n");
+  fprintf(f, "  `-cell-beam=w' --- "
+          "in best-first mode, drop tasks scoring w below the best in their cell\n");
+  fprintf(f, "  `-profile=file' --- "
+          "append per-item profiles of parser phases and rules to file (JSON)\n");
 }
 
 #define OPTION_TSDB 0
@@ -152,6 +165,12 @@ void usage(FILE *f)
 #define OPTION_REPP 45
 #define OPTION_TAGGER 46
 #define OPTION_PREPROCESS_ONLY 47
+#define OPTION_JOBS 48
+#define OPTION_SERVER_ITEMS 49
+#define OPTION_SERVER_MEMORY 50
+#define OPTION_PROFILE 51
+#define OPTION_BEST_FIRST 52
+#define OPTION_CELL_BEAM 53
 
 #ifdef YY
 #define OPTION_ONE_MEANING 100
@@ -217,6 +236,12 @@ char* parse_options(int argc, char* argv[])
     {"cp", required_argument, 0, OPTION_CHART_PRUNING},
     {"inputfile", required_argument, 0, OPTION_INPUT_FILE},
     {"take", optional_argument, 0, OPTION_TAKE},
+    {"jobs", required_argument, 0, OPTION_JOBS},
+    {"server-items", required_argument, 0, OPTION_SERVER_ITEMS},
+    {"server-memory", required_argument, 0, OPTION_SERVER_MEMORY},
+    {"profile", required_argument, 0, OPTION_PROFILE},
+    {"best-first", optional_argument, 0, OPTION_BEST_FIRST},
+    {"cell-beam", required_argument, 0, OPTION_CELL_BEAM},
     {0, 0, 0, 0}
   }; /* struct option */
 
@@ -465,6 +490,26 @@ char* parse_options(int argc, char* argv[])
           set_opt("opt_take",
                   (optarg != NULL) ? std::string(optarg) : std::string("b"));
           break;
+      case OPTION_JOBS:
+          set_opt_from_string("opt_jobs", optarg);
+          break;
+      case OPTION_SERVER_ITEMS:
+          set_opt_from_string("opt_server_items", optarg);
+          break;
+      case OPTION_SERVER_MEMORY:
+          set_opt_from_string("opt_server_memory", optarg);
+          break;
+      case OPTION_PROFILE:
+          set_opt("opt_profile", std::string(optarg));
+          break;
+      case OPTION_BEST_FIRST:
+          set_opt("opt_best_first", true);
+          if(optarg != NULL)
+            set_opt_from_string("opt_beam", optarg);
+          break;
+      case OPTION_CELL_BEAM:
+          set_opt_from_string("opt_cell_beam", optarg);
+          break;
       case OPTION_REPP:
       {
         if(optarg != NULL) set_opt_from_string("opt_repp", optarg);
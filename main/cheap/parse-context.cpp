@@ -0,0 +1,102 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* per-parse state of the chart parser */
+
+#include "parse-context.h"
+#include "parse.h"
+#include "dag.h"
+
+// defined in parse.cpp
+extern chart *Chart;
+extern tAbstractAgenda *Agenda;
+
+tParseContext tParseContext::_initial;
+tParseContext *tParseContext::_current = &tParseContext::_initial;
+
+tParseContext::tParseContext()
+  : _chart(NULL), _agenda(NULL), _owner(NULL), _stats(),
+    _timeout(0), _timestamp(0), _heap(CHUNK_SIZE, false),
+    _generation(0), _generation_max(-1)
+{
+}
+
+tParseContext::~tParseContext()
+{
+  if(_current == this && this != &_initial)
+    _initial.activate();
+}
+
+void
+tParseContext::activate()
+{
+  if(_current == this) return;
+
+  _current->save();
+  _current = this;
+  restore();
+}
+
+void
+tParseContext::save()
+{
+  _chart = Chart;
+  _agenda = Agenda;
+  _owner = tItem::default_owner();
+  _stats = stats;
+  _timeout = timeout;
+  _timestamp = timestamp;
+  t_alloc.swap(_heap);
+#ifdef DAG_TOMABECHI
+  _generation = unify_generation;
+  _generation_max = unify_generation_max;
+#endif
+}
+
+void
+tParseContext::restore()
+{
+  Chart = _chart;
+  Agenda = _agenda;
+  tItem::default_owner(_owner);
+  stats = _stats;
+  timeout = _timeout;
+  timestamp = _timestamp;
+  t_alloc.swap(_heap);
+#ifdef DAG_TOMABECHI
+  // the generation protected slots of our temporary dags are only intact if
+  // no other unification happened in the meantime, otherwise start afresh.
+  // items with temporary feature structures will recreate them on demand.
+  if(_generation_max == unify_generation_max)
+    unify_generation = _generation;
+  else
+    dag_invalidate_changes();
+#endif
+}
+
+chart *
+tParseContext::get_chart() const
+{
+  return active() ? Chart : _chart;
+}
+
+const statistics &
+tParseContext::get_stats() const
+{
+  return active() ? stats : _stats;
+}
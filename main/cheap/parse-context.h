@@ -0,0 +1,132 @@
+/* -*- Mode: C++ -*- */
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** \file parse-context.h
+ * The per-parse state of the chart parser.
+ */
+
+#ifndef _PARSE_CONTEXT_H_
+#define _PARSE_CONTEXT_H_
+
+#include "task.h"
+#include "tsdb++.h"
+#include "chunk-alloc.h"
+#include <ctime>
+
+/** The state the parser keeps for one analysis: chart, agenda, statistics,
+ *  resource limit counters, the heap of temporary dags and the generation
+ *  counter of the unifier.
+ *
+ *  The parser itself still works on the process globals (\c Chart, \c Agenda,
+ *  \c stats, \c timeout, \c timestamp, \c t_alloc and \c unify_generation),
+ *  which keeps the inner loops free of indirections. A context owns a private
+ *  copy of this state and installs it in the globals when it is activated, and
+ *  puts the globals' contents back into itself when another context is
+ *  activated. Thus, the chart and the feature structures of one analysis stay
+ *  valid while other analyses are run in the same process, e.g., for several
+ *  open sessions of the SessionManager. Only one context is active at a
+ *  time.
+ *
+ *  Contexts are switched, they do not run concurrently in threads. The state
+ *  above is not all a parse changes: the unifier sets forward pointers and
+ *  copies in the generation protected slots of every dag node it visits,
+ *  including the nodes of the rule and type dags of the grammar, and glb()
+ *  fills the type caches on demand. Sharing one grammar between threads
+ *  would need a unifier that leaves the input dags alone. This is why
+ *  cheap parses in parallel with forked processes instead (parallel_batch()
+ *  and the worker pool of the server), which share the grammar
+ *  copy-on-write.
+ */
+class tParseContext {
+public:
+  /** Create a new, inactive context with an empty temporary heap. */
+  tParseContext();
+
+  /** Destroy the context. If it is the active one, the initial context is
+   *  activated first. The chart is not deleted, it belongs to the caller of
+   *  analyze().
+   */
+  ~tParseContext();
+
+  /** Make this the context the parser operates on, saving the state of the
+   *  currently active context into that one.
+   */
+  void activate();
+
+  /** Is this the context the parser currently operates on? */
+  bool active() const { return _current == this; }
+
+  /** The context the parser currently operates on. Before the first call to
+   *  activate(), this is a context representing the initial process state.
+   */
+  static tParseContext *current() { return _current; }
+
+  /** The chart of the last analysis run in this context */
+  class chart *get_chart() const;
+
+  /** The statistics of the last analysis run in this context */
+  const statistics &get_stats() const;
+
+private:
+  /** Copy the parser globals into this context */
+  void save();
+  /** Install the state of this context in the parser globals */
+  void restore();
+
+  class chart *_chart;
+  tAbstractAgenda *_agenda;
+  class item_owner *_owner;
+  statistics _stats;
+  clock_t _timeout, _timestamp;
+
+  /** Holds the temporary heap of this context while it is inactive, and an
+   *  unused one while the context is active and its heap is \c t_alloc .
+   */
+  chunk_allocator _heap;
+
+  /** The unifier's generation counter when this context was deactivated */
+  int _generation;
+  /** The process wide maximal generation at that time. If it has not changed
+   *  since, no unification has taken place in between and the temporary
+   *  dags of this context are still valid.
+   */
+  int _generation_max;
+
+  static tParseContext _initial;
+  static tParseContext *_current;
+
+  // not copyable
+  tParseContext(const tParseContext &);
+  tParseContext &operator=(const tParseContext &);
+};
+
+/** Activate a context for the lifetime of this object and reactivate the
+ *  previous one afterwards.
+ */
+class tParseContextSwitch {
+public:
+  tParseContextSwitch(tParseContext &ctx)
+    : _previous(tParseContext::current()) { ctx.activate(); }
+  ~tParseContextSwitch() { _previous->activate(); }
+
+private:
+  tParseContext *_previous;
+};
+
+#endif
@@ -33,11 +33,16 @@
 #include "configs.h"
 #include "settings.h"
 #include "logging.h"
+#include "profiler.h"
+#include "sm.h"
 
+#include <algorithm>
+#include <functional>
 #include <sstream>
 #include <iostream>
 #include <sys/times.h>
 #include <unistd.h>
+#include <math.h>
 
 using namespace std;
 
@@ -62,6 +67,7 @@ static bool parser_init();
 //options managed by configuration subsystem
 bool opt_hyper = parser_init();
 int  opt_nsolutions, opt_packing;
+bool opt_best_first;
 
 #ifdef YY
 int opt_nth_meaning;
@@ -82,6 +88,18 @@ static bool parser_init() {
                 "2:proactive 4:retroactive packing; "
                 "8:selective 128:no unpacking", opt_packing);
   opt_packing = 0;
+  reference_opt("opt_best_first",
+                "parse best-first, ordering the agenda by the scores of the "
+                "parse selection model; with -nsolutions, stop as soon as "
+                "no task left can beat the best readings (if the model bounds "
+                "the scores, else after the first ones)", opt_best_first);
+  opt_best_first = false;
+  managed_opt("opt_beam",
+              "in best-first mode, the maximal number of phrasal tasks on "
+              "the agenda (0: no limit)", (int) 0);
+  managed_opt("opt_cell_beam",
+              "in best-first mode, drop tasks that score this much below the "
+              "best passive item of their cell (0: keep all)", (double) 0.0);
   managed_opt("opt_pedgelimit", "maximum number of passive edges",
               (int) 0);
   managed_opt("opt_memlimit", "memory limit (in MB) for parsing and unpacking",
@@ -111,6 +129,9 @@ clock_t timestamp;
 // filtering
 //
 
+/** Apply the quick check to the combination of rule \a R and \a passive.
+ *  The rule filter is applied by the rule index already, see postulate().
+ */
 bool
 filter_rule_task(grammar_rule *R, tItem *passive)
 {
@@ -119,21 +140,11 @@ filter_rule_task(grammar_rule *R, tItem *passive)
     LOG(logParse, DEBUG, "trying " << R << " & passive " << passive << " ==> ");
 #endif
 
-    if(!Grammar->filter_compatible(R, R->nextarg(), passive->rule()))
-    {
-        stats.ftasks_fi++;
-
-#ifdef PETDEBUG
-        LOG(logParse, DEBUG, "filtered (rf)");
-#endif
-
-        return false;
-    }
-
     if(!fs::qc_compatible_unif(R->qc_vector_unif(R->nextarg()),
                                passive->qc_vector_unif()))
     {
         stats.ftasks_qc++;
+        if(Profiler.active()) Profiler.rule(R->id()).filtered_qc++;
 
 #ifdef PETDEBUG
         LOG(logParse, DEBUG, "filtered (qc)");
@@ -165,6 +176,7 @@ filter_combine_task(tItem *active, tItem *passive)
 #endif
 
         stats.ftasks_fi++;
+        if(Profiler.active()) Profiler.rule(active->rule()->id()).filtered_rf++;
         return false;
     }
 
@@ -176,6 +188,7 @@ filter_combine_task(tItem *active, tItem *passive)
 #endif
 
         stats.ftasks_qc++;
+        if(Profiler.active()) Profiler.rule(active->rule()->id()).filtered_qc++;
         return false;
     }
 
@@ -190,15 +203,36 @@ filter_combine_task(tItem *active, tItem *passive)
 // parser control
 //
 
+/** Charge the active rules that are not in [\a begin, \a end), i.e., that
+ *  the rule filter excluded, to the profiler. Both ranges are in the order of
+ *  rules().
+ */
+static void
+profile_rule_filter(grammar_rule * const *begin, grammar_rule * const *end)
+{
+    grammar_rule * const *rule, * const *all_end;
+    Grammar->filtered_rules(NULL, rule, all_end);
+    for(; rule != all_end; ++rule) {
+      if(begin != end && *begin == *rule)
+        ++begin;
+      else
+        Profiler.rule((*rule)->id()).filtered_rf++;
+    }
+}
+
 /** Add all tasks to the agenda that try to combine the specified (passive)
  *  item with a suitable rule.
  */
 void
 postulate(tItem *passive) {
   assert(!passive->blocked());
-  // iterate over all the rules in the grammar
-  for(ruleiter rule = Grammar->rules().begin(); rule != Grammar->rules().end();
-      ++rule) {
+  // iterate over the active rules that pass the rule filter with the passive
+  // item's rule, the others are skipped without creating tasks
+  grammar_rule * const *rule, * const *end;
+  Grammar->filtered_rules(passive->rule(), rule, end);
+  stats.rules_skipped += Grammar->nactive_rules() - (end - rule);
+  if(Profiler.active()) profile_rule_filter(rule, end);
+  for(; rule != end; ++rule) {
     grammar_rule *R = *rule;
 
     if(passive->compatible(R, Chart->rightmost()))
@@ -249,6 +283,10 @@ packed_edge(tItem *newitem) {
        || (olditem->trait() == INPUT_TRAIT))
       continue;
 
+    // a frosted item can neither take up the new item nor be packed into it
+    if(olditem->frosted())
+      continue;
+
     // YZ 2007-07-25: avoid packing item with its offspring edges
     // (both forward and backward)
     if (newitem->contains_p(olditem))
@@ -277,9 +315,19 @@ packed_edge(tItem *newitem) {
 
       if(forward ==false && backward == false)
         stats.fsubs_qc++;
-      else
-        subsumes(olditem->get_fs(), newitem->get_fs(),
-                 forward, backward);
+      else {
+        // the signatures only rule out what subsumes() would reject, too
+        bool f2 = forward, b2 = backward;
+        fs::signature_compatible_subs(olditem->subs_signature(),
+                                      newitem->subs_signature(), f2, b2);
+        if(f2 == false && b2 == false) {
+          forward = backward = false;
+          stats.subsumptions_fail++;
+        }
+        else
+          subsumes(olditem->get_fs(), newitem->get_fs(),
+                   forward, backward);
+      }
 
 #ifdef PETDEBUG_SUBSFAILS
       uf = stop_recording_failures();
@@ -333,6 +381,7 @@ packed_edge(tItem *newitem) {
           stats.p_proactive++;
 
         olditem->packed.push_back(newitem);
+        newitem->release_subs_signature();
         return true;
       }
     }
@@ -356,6 +405,45 @@ packed_edge(tItem *newitem) {
   return false;
 }
 
+/** @name Best-first parsing
+ * The best scores of the trees found so far, in descending order and at most
+ * \c opt_nsolutions of them.
+ */
+//@{
+static vector<double> best_first_scores;
+
+static void best_first_tree(tItem *tree) {
+  vector<double>::iterator pos
+    = lower_bound(best_first_scores.begin(), best_first_scores.end(),
+                  tree->score(), greater<double>());
+  best_first_scores.insert(pos, tree->score());
+  if(best_first_scores.size() > (size_t) opt_nsolutions)
+    best_first_scores.pop_back();
+}
+
+/** Is this a best-first parse that stops on the scores of the trees? The
+ *  task priorities are upper bounds for the scores of the trees they can
+ *  lead to only if the model bounds the rest of a tree, cf.
+ *  tSM::outsideBound(); without such a bound, the parser stops after \c
+ *  opt_nsolutions trees, as it does without a model.
+ */
+static bool best_first_bounded() {
+  return opt_best_first && Grammar->sm()
+    && Grammar->sm()->outsideBound(0, 1) != HUGE_VAL;
+}
+
+/** In best-first mode, return \c true if \c opt_nsolutions trees have been
+ *  found and none of the tasks left could produce a better one.
+ */
+static bool best_first_done() {
+  if(! best_first_bounded() || opt_packing || opt_nsolutions == 0
+     || best_first_scores.size() < (size_t) opt_nsolutions
+     || Agenda->empty())
+    return false;
+  return Agenda->top()->priority() <= best_first_scores.back();
+}
+//@}
+
 /** return \c true if parsing should be stopped because enough results have
  *  been found
  */
@@ -367,7 +455,9 @@ inline bool result_limits() {
   // in (non-packing) best-first mode, is the number of trees found equal to
   // the number of requested solutions?
   // opt_packing w/unpacking implies exhaustive parsing
-  if ((! opt_packing
+  // in best-first mode with a model that bounds the scores, stopping is left
+  // to best_first_done()
+  if ((! opt_packing && ! best_first_bounded()
        && opt_nsolutions != 0 && stats.trees >= opt_nsolutions)
 #ifdef YY
       || (opt_nth_meaning != 0 && stats.nmeanings >= opt_nth_meaning)
@@ -402,6 +492,8 @@ bool add_item(tItem *it) {
       if(stats.first == -1) {
         stats.first = ParseTime.convert2ms(ParseTime.elapsed());
       }
+      if(opt_best_first && opt_nsolutions != 0 && Grammar->sm())
+        best_first_tree(it);
       if (result_limits()) return true;
     }
 
@@ -487,10 +579,13 @@ parse_loop(fs_alloc_state &FSAS, list<tError> &errors, clock_t timeout) {
   //
   // run the core parser loop until either (a) we empty out the agenda, (b) we
   // hit a resource limit, or (c) in (non-packing) best-first mode, the number
-  // of trees found equals the number of requested solutions.
+  // of trees found equals the number of requested solutions; with a parse
+  // selection model, these also have to be better than anything left on the
+  // agenda.
   //
   while(! Agenda->empty() &&
-        ! resources_exhausted(pedgelimit, memlimit, timeout, timestamp)) {
+        ! resources_exhausted(pedgelimit, memlimit, timeout, timestamp)
+        && ! best_first_done()) {
 
     basic_task* t = Agenda->pop();
 #ifdef PETDEBUG
@@ -614,6 +709,7 @@ collect_readings(fs_alloc_state &FSAS, list<tError> &errors,
     // \todo What if there are already valid solutions but the edge limit has
     // been hit? Why is there no unpacking at all
     if (pedgelimit == 0 || Chart->pedges() < pedgelimit) {
+      tProfilePhase phase(PHASE_UNPACKING);
       timer *UnpackTime = new timer();
       stats.trees = 0; // We want to recount the trees in case some
                        // are blocked or don't unpack.
@@ -743,6 +839,8 @@ analyze(string input, chart *&C, fs_alloc_state &FSAS
   FSAS.clear_stats();
   stats.reset();
   stats.id = id;
+  Profiler.start_item(id);
+  best_first_scores.clear();
 
   Chart = C;
   auto_ptr<item_owner> owner(new item_owner);
@@ -774,7 +872,10 @@ analyze(string input, chart *&C, fs_alloc_state &FSAS
     errors.push_back(e);
   } // catch
 
-  if (get_opt_int("opt_chart_pruning") != 0) {
+  if (opt_best_first && Grammar->sm()) {
+    Agenda = new tBestFirstAgenda (get_opt_int("opt_beam"),
+                                   get_opt<double>("opt_cell_beam"), max_pos);
+  } else if (get_opt_int("opt_chart_pruning") != 0) {
     Agenda = new tLocalCapAgenda (get_opt_int ("opt_chart_pruning"), max_pos);
   } else {
     Agenda = new tExhaustiveAgenda;
@@ -790,7 +891,10 @@ analyze(string input, chart *&C, fs_alloc_state &FSAS
 
     // during lexical processing, the appropriate tasks for the syntactic stage
     // are already created
-    if(!(get_opt_int("opt_tsdb") & 32)) parse_loop(FSAS, errors, timeout);
+    if(!(get_opt_int("opt_tsdb") & 32)) {
+      tProfilePhase phase(PHASE_SYNTACTIC_PARSING);
+      parse_loop(FSAS, errors, timeout);
+    }
   } //if
 
   ParseTime.stop();
@@ -808,4 +912,5 @@ analyze(string input, chart *&C, fs_alloc_state &FSAS
   if(input_items.size()) Lexparser.reset();
   // clear_dynamic_types(); // too early
   delete Agenda;
+  basic_task::release_pool();
 }
@@ -0,0 +1,134 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* per-phase and per-rule profiling */
+
+#include "pet-config.h"
+#include "profiler.h"
+#include "cheap.h"
+#include "grammar.h"
+#include "errors.h"
+#include "logging.h"
+#include "options.h"
+#include "tsdb++.h"
+#include "utility.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sstream>
+
+using namespace std;
+
+tProfiler Profiler;
+
+static bool init();
+static bool profiler_init = init();
+static bool init() {
+  managed_opt("opt_profile",
+    "append a profile of the parser phases and rules of every item as one "
+    "line of JSON to this file",
+    string());
+  return true;
+}
+
+static const char *phase_names[N_PROFILE_PHASES] = {
+  "other", "tokenization", "chart_mapping", "morphology", "lexical_parsing",
+  "syntactic_parsing", "unpacking", "mrs"
+};
+
+tProfiler::tProfiler()
+  : unify_cycles(0), copy_cycles(0), _active(false), _fd(-1), _item(false),
+    _id(0), _since(0) {
+  _stack.push_back(PHASE_OTHER);
+  for(int i = 0; i < N_PROFILE_PHASES; ++i) _phases[i] = 0;
+}
+
+void tProfiler::open(const string &name) {
+  if(_fd >= 0) close(_fd);
+  _fd = -1;
+  _active = false;
+  if(name.empty()) return;
+  // with O_APPEND, every write(2) goes to the end of the file, also if
+  // parallel workers write to it
+  if((_fd = ::open(name.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0666)) < 0)
+    throw tError("could not open profile file `" + name + "'");
+  _active = true;
+}
+
+void tProfiler::start_item(int id) {
+  if(! _active) return;
+  _item = true;
+  _id = id;
+  unify_cycles = copy_cycles = 0;
+  for(int i = 0; i < N_PROFILE_PHASES; ++i) _phases[i] = 0;
+  for(vector<tRuleProfile>::iterator it = _rules.begin(); it != _rules.end();
+      ++it) {
+    tRuleProfile empty = { 0, 0, 0, 0, 0, 0 };
+    *it = empty;
+  }
+  _stack.clear();
+  _stack.push_back(PHASE_OTHER);
+  _since = cycle_count();
+}
+
+void tProfiler::finish_item() {
+  if(! _active || ! _item) return;
+  _item = false;
+  leave();
+
+  cycle_count_t total = 0;
+  for(int i = 0; i < N_PROFILE_PHASES; ++i) total += _phases[i];
+
+  ostringstream out;
+#if defined(__i386__) || defined(__x86_64__)
+  out << "{\"item\": " << _id << ", \"clock\": \"cycles\"";
+#else
+  out << "{\"item\": " << _id << ", \"clock\": \"ns\"";
+#endif
+  out << ", \"total\": " << total << ", \"phases\": {";
+  for(int i = 0; i < N_PROFILE_PHASES; ++i) {
+    if(i > 0) out << ", ";
+    out << "\"" << phase_names[i] << "\": " << _phases[i];
+  }
+  out << "}, \"unify\": " << unify_cycles << ", \"copy\": " << copy_cycles
+      << ", \"morph_cache\": {\"hits\": " << stats.morph_cache_hits
+      << ", \"misses\": " << stats.morph_cache_misses << "}, \"rules\": [";
+  bool first = true;
+  for(ruleiter it = Grammar->rules().begin(); it != Grammar->rules().end();
+      ++it) {
+    int id = (*it)->id();
+    if(id >= (int) _rules.size()) continue;
+    const tRuleProfile &R = _rules[id];
+    if(R.executed == 0 && R.filtered_rf == 0 && R.filtered_qc == 0) continue;
+    if(! first) out << ", ";
+    first = false;
+    out << "{\"rule\": " << json_string((*it)->printname())
+        << ", \"executed\": " << R.executed
+        << ", \"succeeded\": " << R.succeeded
+        << ", \"failed\": " << R.executed - R.succeeded
+        << ", \"filtered_rf\": " << R.filtered_rf
+        << ", \"filtered_qc\": " << R.filtered_qc
+        << ", \"unify\": " << R.unify << ", \"copy\": " << R.copy << "}";
+  }
+  out << "]}\n";
+
+  // a single write(2) per record keeps the lines of parallel workers intact
+  string record = out.str();
+  if(write(_fd, record.data(), record.size()) != (ssize_t) record.size())
+    LOG(logAppl, WARN, "could not write the profile of item " << _id);
+}
@@ -0,0 +1,155 @@
+/* -*- Mode: C++ -*- */
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** \file profiler.h
+ * Per-phase and per-rule profiling of the parser.
+ *
+ * The profiler is switched on with \c -profile=file. It then measures, for
+ * every item, the time spent in the processing phases and, for every rule,
+ * the tasks executed and filtered and the time spent in unification and
+ * copying, as well as the hits and misses of the morphology cache. Times are
+ * taken with the processor's cycle counter where there is one, and in
+ * nanoseconds otherwise. After an item has been processed, one
+ * line of JSON describing it is appended to the file, in all modes of cheap
+ * (interactive, -tsdb, -server and the XML-RPC server).
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <string>
+#include <vector>
+#if !defined(__i386__) && !defined(__x86_64__)
+#include <time.h>
+#endif
+
+typedef unsigned long long cycle_count_t;
+
+/** Read the cycle counter (or a nanosecond clock if there is none) */
+inline cycle_count_t cycle_count() {
+#if defined(__i386__) || defined(__x86_64__)
+  unsigned int lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((cycle_count_t) hi << 32) | lo;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (cycle_count_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/** The processing phases the profiler distinguishes. The time of a phase
+ *  does not include the time of phases nested in it, e.g., morphology during
+ *  lexical parsing.
+ */
+enum profile_phase {
+  PHASE_OTHER, PHASE_TOKENIZATION, PHASE_CHART_MAPPING, PHASE_MORPHOLOGY,
+  PHASE_LEXICAL_PARSING, PHASE_SYNTACTIC_PARSING, PHASE_UNPACKING, PHASE_MRS,
+  N_PROFILE_PHASES
+};
+
+/** What the profiler records for a single rule */
+struct tRuleProfile {
+  /** tasks executed and tasks that produced an item */
+  int executed, succeeded;
+  /** tasks filtered by the rule filter and by the quick check */
+  int filtered_rf, filtered_qc;
+  /** time spent in unification and in copying the results */
+  cycle_count_t unify, copy;
+};
+
+class tProfiler {
+public:
+  tProfiler();
+
+  /** Is profiling switched on? Everything else is a no-op if it is not. */
+  bool active() { return _active; }
+
+  /** Open the output file \a name, or switch profiling off if \a name is
+   *  empty.
+   */
+  void open(const std::string &name);
+
+  /** Reset all counters at the start of item \a id */
+  void start_item(int id);
+
+  /** Append the record of the current item to the output file. Does nothing
+   *  if no item was started since the last call.
+   */
+  void finish_item();
+
+  /** Start charging time to \a phase, until the matching leave() */
+  void enter(profile_phase phase) {
+    if(! _active) return;
+    cycle_count_t now = cycle_count();
+    _phases[_stack.back()] += now - _since;
+    _since = now;
+    _stack.push_back(phase);
+  }
+
+  /** Return to the phase that was active before the last enter() */
+  void leave() {
+    if(! _active) return;
+    cycle_count_t now = cycle_count();
+    _phases[_stack.back()] += now - _since;
+    _since = now;
+    if(_stack.size() > 1) _stack.pop_back();
+  }
+
+  /** The profile of the rule with id \a id */
+  tRuleProfile &rule(int id) {
+    if(id >= (int) _rules.size()) {
+      tRuleProfile empty = { 0, 0, 0, 0, 0, 0 };
+      _rules.resize(id + 1, empty);
+    }
+    return _rules[id];
+  }
+
+  /** @name Unifier timing
+   * The unifier adds the time spent in unification and copying here; the
+   * parser charges the difference before and after a task to the task's
+   * rule.
+   */
+  /*@{*/
+  cycle_count_t unify_cycles, copy_cycles;
+  /*@}*/
+
+private:
+  bool _active;
+  /** The output file, opened for appending */
+  int _fd;
+  /** Has an item been started and not finished yet? */
+  bool _item;
+  int _id;
+  cycle_count_t _since;
+  std::vector<profile_phase> _stack;
+  cycle_count_t _phases[N_PROFILE_PHASES];
+  std::vector<tRuleProfile> _rules;
+};
+
+extern tProfiler Profiler;
+
+/** Charge the time of the enclosing block to \a phase */
+class tProfilePhase {
+public:
+  tProfilePhase(profile_phase phase) { Profiler.enter(phase); }
+  ~tProfilePhase() { Profiler.leave(); }
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "mrs-printer.h"
 #include "options.h"
 #include "parse.h"
+#include "profiler.h"
 #include "tsdb++.h"
 #include "vpm.h"
 
@@ -41,11 +42,13 @@
 #include <cstring>
 #include <iostream>
 #include <map>
+#include <new>
 #include <sstream>
 #include <vector>
 #include <arpa/inet.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/girerr.hpp>
@@ -99,6 +102,152 @@ struct info_method : public xmlrpc_c::method
 };
 
 
+/**
+ * Return the derivation of \a item in format \a derivformat (`udf' or
+ * `compact').
+ */
+static string
+derivation_string(tItem *item, const string &derivformat)
+{
+  ostringstream osstream;
+  if (derivformat == "udf")
+    tTSDBDerivationPrinter(osstream, 1).print(item);
+  else if (derivformat == "compact")
+    tCompactDerivationPrinter(osstream).print(item);
+  return osstream.str();
+}
+
+/**
+ * Return the MRS of \a item in the format selected with the `-mrs' option.
+ */
+static string
+mrs_string(tItem *item, const string &opt_mrs)
+{
+  tProfilePhase phase(PHASE_MRS);
+  string mrs_str;
+  if ((opt_mrs == "new") || (opt_mrs == "simple")) {
+    ostringstream osstream;
+    fs f = item->get_fs();
+    mrs::tPSOA* mrs = new mrs::tPSOA(f.dag());
+    if (mrs->valid()) {
+      mrs::tPSOA* mapped_mrs = vpm->map_mrs(mrs, true);
+      if (mapped_mrs->valid()) {
+        if (opt_mrs == "new") {
+          MrxMRSPrinter ptr(osstream);
+          ptr.print(mapped_mrs);
+        } else if (opt_mrs == "simple") {
+          SimpleMRSPrinter ptr(osstream);
+          ptr.print(mapped_mrs);
+        }
+      }
+      delete mapped_mrs;
+    }
+    delete mrs;
+    mrs_str = osstream.str();
+  } else {
+#ifdef HAVE_MRS
+    mrs_str = ecl_cpp_extract_mrs(item->get_fs().dag(), opt_mrs.c_str());
+#else
+    mrs_str = "";
+#endif
+  }
+  return mrs_str;
+}
+
+/** The parts of an analysis result that are sent to the client */
+struct result_fields
+{
+  result_fields() : surface(true), derivation(true), mrs(true),
+                    derivformat("udf") {}
+
+  bool surface, derivation, mrs;
+  /** the derivation printing format, `udf' or `compact' */
+  string derivformat;
+};
+
+/**
+ * Analyze \a input and return the requested \a fields of the result, i.e.,
+ * a struct with the surface string and an array of readings. The MRS is only
+ * included if the `-mrs' option is set. If the analysis fails, a
+ * girerr::error is thrown.
+ */
+static xmlrpc_c::value
+analyze_input(const string &input, const result_fields &fields, int id)
+{
+  // Define a string that will hold the error message for errors that
+  // occurred during parsing or be empty if there were no errors.
+  // This kind of error handling is a bit clumsy. But it makes it easier
+  // to cleanup the resources acquired during analyze(). A better solution
+  // would be to use the RAII pattern for all required resources.
+  string error;
+
+  // analyze string:
+  chart *Chart = 0;
+  fs_alloc_state FSAS;
+  try {
+    list<tError> errors;
+    analyze(input, Chart, FSAS, errors, id);
+    // this looks rather strange, but it seems to be the current paradigm
+    if (!errors.empty())
+      throw errors.front();
+  } catch (tError e) {
+    error = e.getMessage();
+  }
+
+  // collect readings:
+  xmlrpc_c::value result;
+  if (error.empty()) {
+    // release the chart if printing the readings fails, too:
+    try {
+      string opt_mrs = fields.mrs ? get_opt_string("opt_mrs") : string();
+      vector<xmlrpc_c::value> readings_helper;
+      list<tItem*> readings(Chart->readings().begin(), Chart->readings().end());
+      for (list<tItem*>::iterator it=readings.begin(); it!=readings.end(); ++it)
+      {
+        tItem *item = *it;
+        std::map<std::string, xmlrpc_c::value> reading_helper;
+
+        // get derivation:
+        if (fields.derivation)
+          reading_helper["derivation"] =
+            xmlrpc_c::value_string(derivation_string(item, fields.derivformat));
+
+        // get MRS:
+        if (!opt_mrs.empty())
+          reading_helper["mrs"] =
+            xmlrpc_c::value_string(mrs_string(item, opt_mrs));
+
+        // store reading:
+        readings_helper.push_back(xmlrpc_c::value_struct(reading_helper));
+      }
+
+      // prepare return value:
+      std::map<std::string, xmlrpc_c::value> results_helper;
+      if (fields.surface)
+        results_helper["surface"] =
+          xmlrpc_c::value_string(Chart->get_surface_string());
+      results_helper["readings"] = xmlrpc_c::value_array(readings_helper);
+      result = xmlrpc_c::value_struct(results_helper);
+    } catch (...) {
+      delete Chart;
+      throw;
+    }
+  }
+
+  Profiler.finish_item();
+
+  // delete resources:
+  if (Chart != 0)
+    delete Chart;
+
+  if (!error.empty()) {
+    // rethrow as girerr::error to make the message available to the client
+    throw girerr::error(error);
+  }
+  return result;
+}
+
+
 struct analyze_method : public xmlrpc_c::method
 {
   analyze_method()
@@ -116,109 +265,125 @@ struct analyze_method : public xmlrpc_c::method
   {
     // get method parameters:
     string input(params.getString(0));
-    string derivformat("udf");
+    result_fields fields;
     if (params.size() > 1) {
-      derivformat = params.getString(1);
+      fields.derivformat = params.getString(1);
       params.verifyEnd(2);
     } else {
       params.verifyEnd(1);
     }
 
-    // Define a string that will hold the error message for errors that
-    // occurred during parsing or be empty if there were no errors.
-    // This kind of error handling is a bit clumsy. But it makes it easier
-    // to cleanup the resources acquired during analyze(). A better solution
-    // would be to use the RAII pattern for all required resources.
-    string error;
+    *retval = analyze_input(input, fields, 1);
+  }
+};
 
-    // analyze string:
-    chart *Chart = 0;
-    fs_alloc_state FSAS;
-    int id = 1;
-    try {
-      list<tError> errors;
-      analyze(input, Chart, FSAS, errors, id);
-      // this looks rather strange, but it seems to be the current paradigm
-      if (!errors.empty())
-        throw errors.front();
-    } catch (tError e) {
-      error = e.getMessage();
-    }
 
-    // collect readings:
-    if (error.empty()) {
-      vector<xmlrpc_c::value> readings_helper;
-      list<tItem*> readings(Chart->readings().begin(), Chart->readings().end());
-      for (list<tItem*>::iterator it=readings.begin(); it!=readings.end(); ++it)
-      {
-        tItem *item = *it;
+/**
+ * Remembers the value of an integer option and restores it when this object
+ * goes out of scope, also if an exception is thrown.
+ */
+class tTemporaryOption
+{
+public:
+  tTemporaryOption(const string &key) : _key(key), _old(get_opt_int(key)) {}
+  ~tTemporaryOption() { set_opt(_key, _old); }
 
-        // get derivation:
-        std::map<std::string, xmlrpc_c::value> reading_helper;
-        ostringstream osstream;
-        tTSDBDerivationPrinter printer(osstream, 1);
-        if (derivformat == "udf")
-          tTSDBDerivationPrinter(osstream, 1).print(item);
-        else if (derivformat == "compact")
-          tCompactDerivationPrinter(osstream).print(item);
-        reading_helper["derivation"] = xmlrpc_c::value_string(osstream.str());
+  /** Set the option to \a value until this object goes out of scope */
+  void set(int value) { set_opt(_key, value); }
 
-        // get MRS:
-        string opt_mrs = get_opt_string("opt_mrs");
-        if (!opt_mrs.empty()) {
-          string mrs_str;
-          if ((opt_mrs == "new") || (opt_mrs == "simple")) {
-            osstream.clear(); // reset state
-            osstream.str(""); // reset underlying buffer
-            fs f = item->get_fs();
-            mrs::tPSOA* mrs = new mrs::tPSOA(f.dag());
-            if (mrs->valid()) {
-              mrs::tPSOA* mapped_mrs = vpm->map_mrs(mrs, true);
-              if (mapped_mrs->valid()) {
-                if (opt_mrs == "new") {
-                  MrxMRSPrinter ptr(osstream);
-                  ptr.print(mapped_mrs);
-                } else if (opt_mrs == "simple") {
-                  SimpleMRSPrinter ptr(osstream);
-                  ptr.print(mapped_mrs);
-                }
-              }
-              delete mapped_mrs;
-            }
-            delete mrs;
-            mrs_str = osstream.str();
-          } else {
-#ifdef HAVE_MRS
-            mrs_str = ecl_cpp_extract_mrs(item->get_fs().dag(), opt_mrs.c_str());
-#else
-            mrs_str = "";
-#endif
-          }
-          reading_helper["mrs"] = xmlrpc_c::value_string(mrs_str);
-        }
+private:
+  string _key;
+  int _old;
+};
 
-        // store reading:
-        readings_helper.push_back(xmlrpc_c::value_struct(reading_helper));
-      }
+analyze_batch_method::analyze_batch_method()
+{
+  _signature = "A:A,A:AS";
+  _help = "Analyze each of the inputs in the specified array and return "
+      "an array with one result per input. A result is a struct as "
+      "returned by cheap.analyze or, if the input could not be analyzed, "
+      "a struct with the error message in `error'. "
+      "The optional second parameter is a struct with settings for this "
+      "request: the limits `timeout' (in s), `pedgelimit' and `nsolutions', "
+      "the derivation printing format `derivformat' "
+      "(either `udf' or `compact'; default: `udf') and `fields', an array "
+      "naming the parts of the results to return "
+      "(any of `surface', `derivation' and `mrs'; default: all).";
+}
 
-      // prepare return value:
-      std::map<std::string, xmlrpc_c::value> results_helper;
-      results_helper["surface"] =
-        xmlrpc_c::value_string(Chart->get_surface_string());
-      results_helper["readings"] = xmlrpc_c::value_array(readings_helper);
-      *retval = xmlrpc_c::value_struct(results_helper);
-    }
+void
+analyze_batch_method::execute(xmlrpc_c::paramList const& params,
+                              xmlrpc_c::value* const retval)
+{
+  // get method parameters:
+  vector<xmlrpc_c::value> inputs(params.getArray(0));
+  std::map<std::string, xmlrpc_c::value> settings;
+  if (params.size() > 1) {
+    settings = params.getStruct(1);
+    params.verifyEnd(2);
+  } else {
+    params.verifyEnd(1);
+  }
 
-    // delete resources:
-    if (Chart != 0)
-      delete Chart;
+  result_fields fields;
+  std::map<std::string, xmlrpc_c::value>::const_iterator it;
+  if ((it = settings.find("derivformat")) != settings.end())
+    fields.derivformat = xmlrpc_c::value_string(it->second).cvalue();
+  if ((it = settings.find("fields")) != settings.end()) {
+    fields.surface = fields.derivation = fields.mrs = false;
+    vector<xmlrpc_c::value> names =
+      xmlrpc_c::value_array(it->second).vectorValueValue();
+    for (vector<xmlrpc_c::value>::iterator name = names.begin();
+         name != names.end(); ++name) {
+      string field = xmlrpc_c::value_string(*name).cvalue();
+      if (field == "surface")
+        fields.surface = true;
+      else if (field == "derivation")
+        fields.derivation = true;
+      else if (field == "mrs")
+        fields.mrs = true;
+      else
+        throw girerr::error("unknown result field `" + field + "'");
+    }
+  }
 
+  // the limits only apply to this request:
+  tTemporaryOption timeout("opt_timeout"), pedgelimit("opt_pedgelimit"),
+    nsolutions("opt_nsolutions");
+  if ((it = settings.find("timeout")) != settings.end())
+    timeout.set((int) (sysconf(_SC_CLK_TCK)
+                       * xmlrpc_c::value_int(it->second).cvalue()));
+  if ((it = settings.find("pedgelimit")) != settings.end())
+    pedgelimit.set(xmlrpc_c::value_int(it->second).cvalue());
+  if ((it = settings.find("nsolutions")) != settings.end())
+    nsolutions.set(xmlrpc_c::value_int(it->second).cvalue());
+
+  // analyze inputs, each with its own fs_alloc_state; a failing input
+  // only gets an error as its result, the others are still analyzed:
+  vector<xmlrpc_c::value> results;
+  for (unsigned int i = 0; i < inputs.size(); ++i) {
+    string error;
+    try {
+      string input = xmlrpc_c::value_string(inputs[i]).cvalue();
+      results.push_back(analyze_input(input, fields, i + 1));
+    } catch (tError e) {
+      error = e.getMessage();
+    } catch (std::bad_alloc &) {
+      error = "out of memory";
+    } catch (const std::exception &e) {
+      // girerr::error is a std::exception, too
+      error = e.what();
+    }
     if (!error.empty()) {
-      // rethrow as girerr::error to make the message available to the client
-      throw girerr::error(error);
+      std::map<std::string, xmlrpc_c::value> error_helper;
+      error_helper["error"] = xmlrpc_c::value_string(error);
+      results.push_back(xmlrpc_c::value_struct(error_helper));
     }
   }
-};
+
+  // prepare return value:
+  *retval = xmlrpc_c::value_array(results);
+}
 
 
 struct parsable_method : public xmlrpc_c::method
@@ -258,6 +423,7 @@ struct parsable_method : public xmlrpc_c::method
 
     bool result = error.empty() && !Chart->readings().empty();
     *retval = xmlrpc_c::value_boolean(result);
+    Profiler.finish_item();
 
     // delete resources:
     if (Chart != 0)
@@ -296,10 +462,12 @@ tXMLRPCServer::run()
   xmlrpc_c::methodPtr const alive_method_ptr(new alive_method);
   xmlrpc_c::methodPtr const info_method_ptr(new info_method);
   xmlrpc_c::methodPtr const analyze_method_ptr(new analyze_method);
+  xmlrpc_c::methodPtr const analyze_batch_method_ptr(new analyze_batch_method);
   xmlrpc_c::methodPtr const parsable_method_ptr(new parsable_method);
   reg.addMethod("cheap.alive", alive_method_ptr);
   reg.addMethod("cheap.info", info_method_ptr);
   reg.addMethod("cheap.analyze", analyze_method_ptr);
+  reg.addMethod("cheap.analyze_batch", analyze_batch_method_ptr);
   reg.addMethod("cheap.parsable", parsable_method_ptr);
 
   xmlrpc_c::serverAbyss server(xmlrpc_c::serverAbyss::constrOpt()
@@ -25,6 +25,22 @@
 
 #include "pet-config.h"
 
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+
+/**
+ * The method cheap.analyze_batch: analyze an array of inputs, each on its
+ * own, with the settings of an optional struct, and return an array with
+ * one result or error per input. Declared here for the unit tests.
+ */
+struct analyze_batch_method : public xmlrpc_c::method
+{
+  analyze_batch_method();
+
+  void execute(xmlrpc_c::paramList const& params,
+               xmlrpc_c::value* const retval);
+};
+
 /**
  * An XML-RPC server for cheap.
  */
@@ -17,16 +17,17 @@ SessionManager *SessionManager::_instance = NULL;
 typedef list<SessionManager::Session *>::iterator session_it;
 
 SessionManager::Session::~Session() {
+  // release the session's dags in its own heap, then go back to the session
+  // that was active before
+  tParseContextSwitch in_session(context);
   delete chart;
+  delete FSAS;
 }
 
 SessionManager::Session *SessionManager::new_session(const string &input) {
-  if (_sessions.empty()) {
-    Session* new_session = new Session(input);
-    _sessions.push_back(new_session);
-    return new_session;
-  }
-  return NULL;
+  Session* new_session = new Session(input);
+  _sessions.push_back(new_session);
+  return new_session;
 }
 
 SessionManager::Session *SessionManager::find_session(int session_id) {
@@ -57,12 +58,7 @@ SessionManager::~SessionManager() {
 }
 
 int SessionManager::start_parse(const string &input) {
-  if (_sessions.empty()) {
-    Session* new_session = new Session(input);
-    _sessions.push_back(new_session);
-    return new_session->id;
-  }
-  return NO_SUCH_SESSION;
+  return new_session(input)->id;
 }
 
 /** Run the parser and collect the results according to the specified options
@@ -73,8 +69,12 @@ int SessionManager::start_parse(const string &input) {
 int SessionManager::run_parser(int session_id) {
   Session *curr = find_session(session_id);
   if (curr == NULL) return NO_SUCH_SESSION;
+  // the session's context stays active after parsing, so that the global
+  // statistics describe this session until another one is run
+  curr->context.activate();
+  if (curr->FSAS == NULL) curr->FSAS = new fs_alloc_state;
   try {
-    analyze(curr->input, curr->chart, curr->FSAS, curr->errors, curr->id);
+    analyze(curr->input, curr->chart, *curr->FSAS, curr->errors, curr->id);
   }
   catch(tError err) {
     //LOG(logAppl, ERROR, err.getMessage());
@@ -110,6 +110,7 @@ class tItem * SessionManager::get_result_item(int session_id, size_t no) {
 string SessionManager::get_result(int session_id, size_t no, string format) {
   tItem *result = get_result_item(session_id, no);
   if (result != NULL) {
+    find_session(session_id)->context.activate();
     ostringstream out;
     print_result_as(format, result, out);
     return out.str();
@@ -4,6 +4,7 @@
 #define _SESSIONMANAGER_H
 
 #include "fs.h"
+#include "parse-context.h"
 #include <list>
 
 #define NO_SUCH_SESSION -2
@@ -19,18 +20,26 @@ private:
 
     int id;
     struct chart *chart;
-    fs_alloc_state FSAS;
+    /** The parser state of this session, which keeps its chart and feature
+     *  structures intact while other sessions are parsed.
+     */
+    tParseContext context;
+    /** Allocation state of the session's temporary heap, created when the
+     *  parser is first run in this session's context.
+     */
+    fs_alloc_state *FSAS;
     std::list<tError> errors;
     std::string input;
 
-    Session(const std::string &in) : id(++next_id), chart(NULL), input(in) { }
+    Session(const std::string &in)
+      : id(++next_id), chart(NULL), FSAS(NULL), input(in) { }
 
     ~Session();
   };
 
   std::list<Session *> _sessions;
 
-  /** return a new session, or NULL, if there are no more sessions available */
+  /** return a new session */
   Session *new_session(const std::string &input);
 
   /** return the session with the given \c session_id, or NULL, if there is no
@@ -175,7 +175,8 @@ tSMMap::stringToSubfeature(const string &s)
 }
 
 tSM::tSM(tGrammar *G, const char *fileName, const char *basePath)
-    : _G(G), _map(0) {
+    : _G(G), _map(0), _max_branching_gain(-1.0),
+      _max_unary_gain(-1.0) {
   _fileName = find_file(fileName, SM_EXT, basePath);
   if(_fileName.empty())
     throw tError(string("Could not open SM file \"") + fileName + "\"");
@@ -231,7 +232,7 @@ tSM::findFile(const char *fileName, const char *basePath)
 */
 
 double
-tSM::scoreLocalTree(grammar_rule *R, vector<tItem *> dtrs)
+tSM::scoreLocalTree(grammar_rule *R, const vector<tItem *> &dtrs)
 {
   vector<int> v1, v2;
   v1.push_back(map()->intToSubfeature(1));
@@ -242,7 +243,7 @@ tSM::scoreLocalTree(grammar_rule *R, vector<tItem *> dtrs)
   v2.push_back(map()->typeToSubfeature(R->type()));
   double total = neutralScore();
 
-  for(vector<tItem *>::iterator dtr = dtrs.begin();
+  for(vector<tItem *>::const_iterator dtr = dtrs.begin();
       dtr != dtrs.end(); ++dtr)
     {
       v1.push_back((*dtr)->identity());
@@ -259,7 +260,7 @@ tSM::scoreLocalTree(grammar_rule *R, vector<tItem *> dtrs)
 }
 
 double
-tSM::scoreLocalTree(grammar_rule *R, list<tItem *> dtrs)
+tSM::scoreLocalTree(grammar_rule *R, const list<tItem *> &dtrs)
 {
   vector<int> v1, v2;
   v1.push_back(map()->intToSubfeature(1));
@@ -270,7 +271,7 @@ tSM::scoreLocalTree(grammar_rule *R, list<tItem *> dtrs)
   v2.push_back(map()->typeToSubfeature(R->type()));
   double total = neutralScore();
   int i = 1;
-  for(list<tItem *>::iterator dtr = dtrs.begin();
+  for(list<tItem *>::const_iterator dtr = dtrs.begin();
       dtr != dtrs.end(); ++dtr, ++i)
     {
       v1.push_back((*dtr)->identity());
@@ -301,11 +302,103 @@ tSM::scoreLeaf(tLexItem *it)
 }
 
 double
-tSM::score_hypothesis(tHypothesis* hypo, list<tItem*> path, unsigned int gplevel)
+tSM::maxLocalTreeGain(grammar_rule *R)
+{
+  return HUGE_VAL;
+}
+
+double
+tSM::maxLeafScore()
+{
+  return HUGE_VAL;
+}
+
+/** Return an upper bound for the amount by which a chain of local trees of
+ *  the \a unary rules can raise a score, or \c HUGE_VAL if it can go round
+ *  a cycle that raises it. Which rule can take the result of which other one
+ *  as its daughter is taken from the rule filter of \a G; without the filter,
+ *  every one of them can.
+ */
+static double
+max_unary_chain_gain(tSM *sm, tGrammar *G,
+                     const vector<grammar_rule *> &unary)
+{
+  // best[i] is the best gain of a chain that ends with unary[i]; a chain
+  // without cycles has at most n rules, so the gains of such chains settle
+  // after n rounds, and a gain that grows beyond that comes from a cycle
+  size_t n = unary.size();
+  vector<double> gain(n), best(n);
+  for(size_t i = 0; i < n; ++i) {
+    gain[i] = best[i] = sm->maxLocalTreeGain(unary[i]);
+    if(gain[i] == HUGE_VAL)
+      return HUGE_VAL;
+  }
+  bool changed = true;
+  for(size_t round = 0; changed; ++round) {
+    if(round > n)
+      return HUGE_VAL;
+    changed = false;
+    for(size_t i = 0; i < n; ++i)
+      for(size_t j = 0; j < n; ++j)
+        if(best[j] > 0.0 && gain[i] + best[j] > best[i]
+           && G->filter_compatible(unary[i], 1, unary[j])) {
+          best[i] = gain[i] + best[j];
+          changed = true;
+        }
+  }
+  double result = 0.0;
+  for(size_t i = 0; i < n; ++i)
+    if(best[i] > result)
+      result = best[i];
+  return result;
+}
+
+double
+tSM::outsideBound(int positions, int subtrees)
+{
+  if(_max_branching_gain < 0.0) {
+    _max_branching_gain = (maxLeafScore() == HUGE_VAL ? HUGE_VAL : 0.0);
+    vector<grammar_rule *> unary;
+    for(ruleiter rule = _G->rules().begin(); rule != _G->rules().end();
+        ++rule) {
+      if((*rule)->arity() == 1) {
+        unary.push_back(*rule);
+        continue;
+      }
+      double gain = maxLocalTreeGain(*rule);
+      if(gain > _max_branching_gain)
+        _max_branching_gain = gain;
+    }
+    _max_unary_gain = max_unary_chain_gain(this, _G, unary);
+  }
+  if(_max_branching_gain == HUGE_VAL || _max_unary_gain == HUGE_VAL)
+    return HUGE_VAL;
+
+  // every leaf covers at least one position, and a tree whose local trees
+  // have two or more daughters has fewer of them than leaves; a chain of
+  // unary local trees can sit on top of every leaf, of every one of these
+  // local trees and of every subtree in hand
+  double bound = 0.0;
+  int branching = (positions + subtrees > 1 ? positions + subtrees - 1 : 0);
+  if(positions > 0)
+    bound += positions * maxLeafScore();
+  bound += branching * _max_branching_gain;
+  bound += (positions + branching + subtrees) * _max_unary_gain;
+  return bound;
+}
+
+/** Compute the scores of the features of the local tree of \a hypo in the
+ *  context of \a path, in the same order as score_hypothesis() always did.
+ */
+static tLocalTreeScores
+local_tree_scores(tSM *sm, tHypothesis* hypo, tPathId path,
+                  unsigned int gplevel)
 {
   vector<int> v1, v2;
-  double total = neutralScore();
-  size_t level = path.size();
+  tLocalTreeScores result;
+  result.context = result.key = result.local = sm->neutralScore();
+  const item_list &ancestors = tUnpackPaths::items(path);
+  size_t level = ancestors.size();
   if (level > gplevel)  // we can only those levels we have ancestors for
     level = gplevel;
   // collect grand-parenting features
@@ -313,15 +406,15 @@ tSM::score_hypothesis(tHypothesis* hypo, list<tItem*> path, unsigned int gplevel
     v1.clear();
     v2.clear();
 
-    v1.push_back(map()->intToSubfeature(1));
-    v2.push_back(map()->intToSubfeature(2));
+    v1.push_back(sm->map()->intToSubfeature(1));
+    v2.push_back(sm->map()->intToSubfeature(2));
 
-    v1.push_back(map()->intToSubfeature(i));
-    v2.push_back(map()->intToSubfeature(i));
+    v1.push_back(sm->map()->intToSubfeature(i));
+    v2.push_back(sm->map()->intToSubfeature(i));
     // push down appropriate number of ancestors
-    unsigned int j = path.size();
-    for (list<tItem*>::iterator gp = path.begin();
-         gp != path.end(); ++gp, --j)
+    unsigned int j = ancestors.size();
+    for (item_citer gp = ancestors.begin();
+         gp != ancestors.end(); ++gp, --j)
       if (j <= (unsigned int)i) {
         if (*gp == NULL) {
           v1.push_back(INT_MAX);
@@ -333,49 +426,122 @@ tSM::score_hypothesis(tHypothesis* hypo, list<tItem*> path, unsigned int gplevel
         }
       }
 
+    double key = sm->neutralScore();
+    bool binary = false;
     if (hypo->edge->rule() == NULL) { // tLexItem
       // push down the lexical type and orth
       tLexItem *lex = (tLexItem*)hypo->edge;
-      v1.push_back(map()->typeToSubfeature(lex->identity()));
-      v1.push_back(map()->stringToSubfeature(lex->orth()));
+      v1.push_back(sm->map()->typeToSubfeature(lex->identity()));
+      v1.push_back(sm->map()->stringToSubfeature(lex->orth()));
     } else { // tPhrasalItem
       tPhrasalItem *phrase = (tPhrasalItem*)hypo->edge;
-      v1.push_back(map()->typeToSubfeature(phrase->identity()));
-      v2.push_back(map()->typeToSubfeature(phrase->identity()));
-      int key = phrase->rule()->nextarg();
-      list<tItem*> newpath = path;
-      newpath.push_back(hypo->edge);
-      if (newpath.size() > gplevel)
-        newpath.pop_front();
+      v1.push_back(sm->map()->typeToSubfeature(phrase->identity()));
+      v2.push_back(sm->map()->typeToSubfeature(phrase->identity()));
+      int keyarg = phrase->rule()->nextarg();
       for (list<tHypothesis*>::iterator hypo_dtr = hypo->hypo_dtrs.begin();
            hypo_dtr != hypo->hypo_dtrs.end(); ++hypo_dtr) {
         v1.push_back((*hypo_dtr)->edge->identity());
-        if (i == 0) { // combine the scores of daughters only once
-          (*hypo_dtr)->scores.size(); //debug
-          if ((*hypo_dtr)->scores.find(newpath) == (*hypo_dtr)->scores.end())
-            score_hypothesis(*hypo_dtr, newpath, gplevel);
-          total = combineScores(total, (*hypo_dtr)->scores[newpath]);
-        }
-        if (--key == 0)
+        if (--keyarg == 0)
           v2.push_back((*hypo_dtr)->edge->identity());
-
       }
       if (phrase->rule()->arity() > 1) {
-        total = combineScores(total, score(tSMFeature(v2)));
+        binary = true;
+        key = sm->score(tSMFeature(v2));
       }
     }
-    total = combineScores(total, score(tSMFeature(v1)));
+    double local = sm->score(tSMFeature(v1));
+
+    if (i > 0) {
+      if (binary)
+        result.context = sm->combineScores(result.context, key);
+      result.context = sm->combineScores(result.context, local);
+    } else {
+      result.key = key;
+      result.local = local;
+    }
+  }
+  return result;
+}
+
+double
+tSM::score_hypothesis(tHypothesis* hypo, tPathId path, unsigned int gplevel)
+{
+  // All hypotheses with the same decomposition have the same local tree, they
+  // only differ in the hypotheses of the daughters, so its feature scores are
+  // computed only once per path
+  tLocalTreeScores local;
+  if (hypo->decomposition == NULL) { // tLexItem
+    local = local_tree_scores(this, hypo, path, gplevel);
+  } else {
+    std::map<tPathId, tLocalTreeScores>::iterator cached
+      = hypo->decomposition->scores.find(path);
+    if (cached == hypo->decomposition->scores.end())
+      cached = hypo->decomposition->scores.insert(
+        make_pair(path, local_tree_scores(this, hypo, path, gplevel))).first;
+    local = cached->second;
+  }
+
+  // combine the scores in order of decreasing grandparenting level,
+  // with the daughters' scores just before the level 0 features
+  double total = local.context;
+  if (hypo->edge->rule() != NULL) { // tPhrasalItem
+    tPhrasalItem *phrase = (tPhrasalItem*)hypo->edge;
+    tPathId newpath = tUnpackPaths::extend(path, hypo->edge);
+    for (list<tHypothesis*>::iterator hypo_dtr = hypo->hypo_dtrs.begin();
+         hypo_dtr != hypo->hypo_dtrs.end(); ++hypo_dtr) {
+      const double *dtr_score = (*hypo_dtr)->scores.find(newpath);
+      total = combineScores(total, dtr_score != NULL
+                            ? *dtr_score
+                            : score_hypothesis(*hypo_dtr, newpath, gplevel));
+    }
+    if (phrase->rule()->arity() > 1)
+      total = combineScores(total, local.key);
   }
+  total = combineScores(total, local.local);
   hypo->scores[path] = total;
-  return hypo->scores[path];
+  return total;
 }
 
 tMEM::tMEM(tGrammar *G, const char *fileNameIn, const char *basePath)
-  : tSM(G, fileNameIn, basePath), _format(0)
+  : tSM(G, fileNameIn, basePath), _max_weight(0.0), _format(0)
 {
     readModel(fileName());
 }
 
+double
+tMEM::maxLocalTreeGain(grammar_rule *R)
+{
+    int rule = map()->typeToSubfeature(R->type());
+    double gain = 0.0;
+    std::map<pair<int, int>, double>::const_iterator it
+      = _max_rule_weights.find(make_pair(1, rule));
+    if(it != _max_rule_weights.end())
+        gain += it->second;
+    if(R->arity() > 1) {
+        it = _max_rule_weights.find(make_pair(2, rule));
+        if(it != _max_rule_weights.end())
+            gain += it->second;
+    }
+    return gain;
+}
+
+void
+tMEM::noteWeight(const vector<int> &v, double w)
+{
+    if(w <= 0.0)
+        return;
+    if(w > _max_weight)
+        _max_weight = w;
+    // local tree features are [1 0 rule dtrs...] and [2 0 rule dtr]
+    if(v.size() >= 3 && v[1] == map()->intToSubfeature(0)
+       && (v[0] == map()->intToSubfeature(1)
+           || v[0] == map()->intToSubfeature(2))) {
+        double &best = _max_rule_weights[make_pair(v[0], v[2])];
+        if(w > best)
+            best = w;
+    }
+}
+
 tMEM::~tMEM()
 {
 }
@@ -632,6 +798,7 @@ tMEM::parseFeature(int n)
         assert(code >= 0);
         if(code >= (int) _weights.size()) _weights.resize(code + 1);
         _weights[code] = w;
+        noteWeight(v, w);
     }
 }
 
@@ -732,6 +899,7 @@ tMEM::parseFeature2(int n)
         assert(code >= 0);
         if(code >= (int) _weights.size()) _weights.resize(code + 1);
         _weights[code] = w;
+        noteWeight(v, w);
     }
 
     //skip the rest part of the feature
@@ -1042,11 +1210,11 @@ tPCFG::score(std::vector<type_t> rule) {
 
 
 double
-tPCFG::scoreLocalTree(class grammar_rule * R, std::list<class tItem*> dtrs) {
+tPCFG::scoreLocalTree(class grammar_rule * R, const std::list<class tItem*> &dtrs) {
   vector<type_t> r;
   r.push_back(R->type());
   double total = 0.0;
-  for (list<tItem*>::iterator dtr = dtrs.begin();
+  for (list<tItem*>::const_iterator dtr = dtrs.begin();
        dtr != dtrs.end(); ++dtr) {
     r.push_back((*dtr)->identity());
     double dscore = (*dtr)->score();
@@ -1092,7 +1260,7 @@ tPCFG::scoreLeaf(class tLexItem *it) {
 }
 
 double
-tPCFG::score_hypothesis(struct tHypothesis* hypo, std::list<class tItem*> path, int gplevel) {
+tPCFG::score_hypothesis(struct tHypothesis* hypo, tPathId path, int gplevel) {
   vector<type_t> r;
   double total = 0.0;
 
@@ -1101,16 +1269,14 @@ tPCFG::score_hypothesis(struct tHypothesis* hypo, std::list<class tItem*> path,
   else { // tPhrasalItem
     tPhrasalItem *phrase = (tPhrasalItem*)hypo->edge;
     r.push_back(phrase->identity());
-    list<tItem*> newpath = path;
-    newpath.push_back(hypo->edge);
-    if (newpath.size() > (unsigned)gplevel)
-      newpath.pop_front();
+    tPathId newpath = tUnpackPaths::extend(path, hypo->edge);
     for (list<tHypothesis*>::iterator hypo_dtr = hypo->hypo_dtrs.begin();
          hypo_dtr != hypo->hypo_dtrs.end(); ++hypo_dtr) {
       r.push_back((*hypo_dtr)->edge->identity());
-      if ((*hypo_dtr)->scores.find(newpath) == (*hypo_dtr)->scores.end())
-        score_hypothesis(*hypo_dtr, newpath, gplevel);
-      total = combineScores(total, (*hypo_dtr)->scores[newpath]);
+      const double *dtr_score = (*hypo_dtr)->scores.find(newpath);
+      total = combineScores(total, dtr_score != NULL
+                            ? *dtr_score
+                            : score_hypothesis(*hypo_dtr, newpath, gplevel));
     }
 
 #if 0
@@ -1129,7 +1295,7 @@ tPCFG::score_hypothesis(struct tHypothesis* hypo, std::list<class tItem*> path,
     total = combineScores(total, score(r));
   }
   hypo->scores[path] = total;
-  return hypo->scores[path];
+  return total;
 }
 
 void
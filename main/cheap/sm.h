@@ -31,6 +31,9 @@
 
 #define SM_EXT ".sm"
 
+/** An interned grandparenting path, cf. tUnpackPaths in item.h */
+typedef long long tPathId;
+
 /** A feature in a stochastic model. 
  *  This class represents one feature in a stochastic model. Features are
  *  tupels of integers. The tSMMap class efficiently maps features to
@@ -91,16 +94,43 @@ class tSM
     { return _G; }
 
     virtual double
-    scoreLocalTree(class grammar_rule *, std::list<class tItem *>);
+    scoreLocalTree(class grammar_rule *, const std::list<class tItem *> &);
     virtual double
-    scoreLocalTree(class grammar_rule *, std::vector<class tItem *>);
+    scoreLocalTree(class grammar_rule *, const std::vector<class tItem *> &);
 
     virtual double
     scoreLeaf(class tLexItem *);
+
+    /** @name Score bounds
+     * Upper bounds for what the rest of a tree can add to the score of the
+     * items it is built from, for the early stop of best-first parsing. A
+     * model without such bounds returns \c HUGE_VAL.
+     */
+    /*@{*/
+    /** Return an upper bound for the amount by which scoreLocalTree() for
+     *  rule \a R can raise the combined scores of the daughters.
+     */
+    virtual double
+    maxLocalTreeGain(class grammar_rule *R);
+
+    /** Return an upper bound for scoreLeaf() */
+    virtual double
+    maxLeafScore();
+
+    /** Return an upper bound for the amount by which the \a subtrees items
+     *  spanning all but \a positions chart positions can be raised when
+     *  they are combined with the leaves of these positions into one tree.
+     *  This is \c HUGE_VAL if one of the bounds is unknown or if a cycle
+     *  of unary rules permitted by the rule filter can raise a score, since
+     *  there is no limit to the number of unary local trees then.
+     */
+    double
+    outsideBound(int positions, int subtrees);
+    /*@}*/
   
     /** Return the score for the hypothesis */
     virtual double 
-    score_hypothesis(struct tHypothesis* hypo, std::list<tItem*> path,
+    score_hypothesis(struct tHypothesis* hypo, tPathId path,
                      unsigned int gplevel);
     
     /** Return the best predicted lexical (entry) types for the given
@@ -126,6 +156,17 @@ class tSM
     std::string _fileName;
 
     class tSMMap *_map;
+
+    /** The largest maxLocalTreeGain() of the rules, or \c HUGE_VAL if
+     *  outsideBound() has none. It is computed on the first call of
+     *  outsideBound() and negative before.
+     */
+    double _max_branching_gain;
+
+    /** The largest gain of a chain of unary local trees, or \c HUGE_VAL if
+     *  there is none. It is computed along with \c _max_branching_gain.
+     */
+    double _max_unary_gain;
 };
 
 /** A Maximum Entropy model.
@@ -153,6 +194,16 @@ class tMEM : public tSM
     combineScores(double a, double b)
     { return a + b; }
 
+    /** A local tree adds at most the largest positive weights of its two
+     *  features without grandparenting.
+     */
+    virtual double
+    maxLocalTreeGain(class grammar_rule *R);
+
+    virtual double
+    maxLeafScore()
+    { return _max_weight; }
+
     /** Return a description string suitable for printing.*/
     virtual std::string
     description();
@@ -162,6 +213,18 @@ class tMEM : public tSM
     
     std::vector<double> _weights;
 
+    /** The largest positive weights of the local tree features without
+     *  grandparenting, by feature kind (1 or 2) and rule subfeature.
+     */
+    std::map<std::pair<int, int>, double> _max_rule_weights;
+
+    /** The largest weight of all features, and at least zero */
+    double _max_weight;
+
+    /** Record weight \a w of feature \a v for the score bounds */
+    void
+    noteWeight(const std::vector<int> &v, double w);
+
     /** Number of contexts this model was trained on. For reporting
         purposes only. */
     std::string _ctxts;
@@ -222,14 +285,14 @@ class tPCFG : public tSM
     description();
     
     virtual double
-    scoreLocalTree(class grammar_rule *, std::list<class tItem *>);
+    scoreLocalTree(class grammar_rule *, const std::list<class tItem *> &);
 
     virtual double
     scoreLeaf(class tLexItem *);
   
     /** Return the score for the hypothesis */
     virtual double 
-    score_hypothesis(struct tHypothesis* hypo, std::list<tItem*> path, int gplevel);
+    score_hypothesis(struct tHypothesis* hypo, tPathId path, int gplevel);
     
 
  private:
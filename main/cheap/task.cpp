@@ -26,22 +26,102 @@
 #include "tsdb++.h"
 #include "sm.h"
 #include "logging.h"
+#include "profiler.h"
+#include <algorithm>
 #include <iomanip>
+#include <vector>
+#include <math.h>
 
 using namespace std;
 
 // defined in parse.cpp
 extern bool opt_hyper;
 extern int  opt_packing;
+extern bool opt_best_first;
 
 int basic_task::next_id = 0;
 
+/** The size of the slots of the task pool. It has to be a multiple of the
+ *  alignment of pointers and doubles. Larger tasks go to the general heap.
+ */
+#define TASK_SLOT_SIZE 64
+/** The number of slots that are allocated at once */
+#define TASK_BLOCK_SLOTS 1024
+
+/** A slot of the task pool, linked into the free list while unused */
+union task_slot {
+  task_slot *next;
+  double align;
+  char data[TASK_SLOT_SIZE];
+};
+
+static task_slot *free_task_slots = NULL;
+static std::vector<task_slot *> task_blocks;
+static long live_tasks = 0;
+
+void *
+basic_task::operator new(size_t n) {
+  if(n > sizeof(task_slot))
+    return ::operator new(n);
+  if(free_task_slots == NULL) {
+    task_slot *block = new task_slot[TASK_BLOCK_SLOTS];
+    task_blocks.push_back(block);
+    for(int i = 0; i < TASK_BLOCK_SLOTS - 1; ++i)
+      block[i].next = &block[i + 1];
+    block[TASK_BLOCK_SLOTS - 1].next = NULL;
+    free_task_slots = block;
+  }
+  task_slot *slot = free_task_slots;
+  free_task_slots = slot->next;
+  ++live_tasks;
+  return slot;
+}
+
+void
+basic_task::operator delete(void *p, size_t n) {
+  if(p == NULL) return;
+  if(n > sizeof(task_slot)) {
+    ::operator delete(p);
+    return;
+  }
+  task_slot *slot = static_cast<task_slot *>(p);
+  slot->next = free_task_slots;
+  free_task_slots = slot;
+  --live_tasks;
+}
+
+void
+basic_task::release_pool() {
+  // tasks of other parse contexts may still be waiting on their agendas
+  if(live_tasks != 0) return;
+  for(std::vector<task_slot *>::iterator it = task_blocks.begin();
+      it != task_blocks.end(); ++it)
+    delete[] *it;
+  task_blocks.clear();
+  free_task_slots = NULL;
+}
+
+/** Charge a task of rule \a R to the profiler. \a unify and \a copy are the
+ *  profiler's unifier counters at the start of the task.
+ */
+static void
+profile_task(grammar_rule *R, bool success,
+             cycle_count_t unify, cycle_count_t copy)
+{
+    tRuleProfile &P = Profiler.rule(R->id());
+    ++P.executed;
+    if(success) ++P.succeeded;
+    P.unify += Profiler.unify_cycles - unify;
+    P.copy += Profiler.copy_cycles - copy;
+}
+
 tItem *
 build_rule_item(chart *C, tAbstractAgenda *A, grammar_rule *R, tItem *passive)
 {
     fs_alloc_state FSAS(false);
     
     stats.etasks++;
+    cycle_count_t unify = Profiler.unify_cycles, copy = Profiler.copy_cycles;
     
     fs res;
     
@@ -77,6 +157,7 @@ build_rule_item(chart *C, tAbstractAgenda *A, grammar_rule *R, tItem *passive)
     if(!res.valid())
     {
         FSAS.release();
+        if(Profiler.active()) profile_task(R, false, unify, copy);
         return 0;
     }
     else
@@ -96,6 +177,7 @@ build_rule_item(chart *C, tAbstractAgenda *A, grammar_rule *R, tItem *passive)
             it = new tPhrasalItem(R, passive, res);
         }
         
+        if(Profiler.active()) profile_task(R, true, unify, copy);
         return it;
     }
 }
@@ -106,6 +188,7 @@ build_combined_item(chart *C, tItem *active, tItem *passive)
     fs_alloc_state FSAS(false);
     
     stats.etasks++;
+    cycle_count_t unify = Profiler.unify_cycles, copy = Profiler.copy_cycles;
     
     fs res;
     
@@ -145,6 +228,8 @@ build_combined_item(chart *C, tItem *active, tItem *passive)
     if(!res.valid())
     {
         FSAS.release();
+        if(Profiler.active())
+            profile_task(active->rule(), false, unify, copy);
         return 0;
     }
     else
@@ -166,6 +251,8 @@ build_combined_item(chart *C, tItem *active, tItem *passive)
                                   passive, res);
         }
         
+        if(Profiler.active())
+            profile_task(active->rule(), true, unify, copy);
         return it;
     }
 }
@@ -178,12 +265,46 @@ double packingscore(int start, int end, int n, bool active)
   //    - (active ? 0.0 : double(end - start) / n) ;
 }
 
+/** Are the task priorities parse selection scores? In best-first mode, a
+ *  task keeps the score of the item it would build: the score of the local
+ *  tree for a task that completes a rule, the combined scores of the
+ *  daughters found so far otherwise. Its priority is computed by
+ *  best_first_priority().
+ */
+static inline bool best_first() {
+  return opt_best_first && Grammar->sm();
+}
+
+/** The best-first priority of a task that builds an item with score \a
+ *  score from \a subtrees daughters in hand, spanning \a start to \a end:
+ *  the score plus the model's bound for what the rest of a tree can add to
+ *  it. No tree built from a task scores better than its priority then, and
+ *  the parser may stop once the best trees beat every task that is left.
+ *  Without a bound, the priority is the score alone.
+ */
+static double
+best_first_priority(chart *C, double score, int start, int end,
+                    int subtrees) {
+  double outside = Grammar->sm()->outsideBound(C->rightmost() - (end - start),
+                                               subtrees);
+  return outside == HUGE_VAL ? score : score + outside;
+}
+
 rule_and_passive_task::rule_and_passive_task(chart *C, tAbstractAgenda *A,
                                              grammar_rule *R, tItem *passive)
-    : basic_task(C, A), _R(R), _passive(passive)
+    : basic_task(C, A), _R(R), _passive(passive), _score(0.0)
 {
 
-  if (Grammar->gm()) {
+  if (best_first()) {
+    if (R->arity() == 1) {
+      item_list dtrs(1, passive);
+      _score = Grammar->sm()->scoreLocalTree(R, dtrs);
+    } else {
+      _score = passive->score();
+    }
+    priority(best_first_priority(C, _score, passive->start(), passive->end(),
+                                 1));
+  } else if (Grammar->gm()) {
     double prior = Grammar->gm()->prior(R);
     if (R->arity() == 1) {
       // Priority(R, X) = P(R) P(R->X) P(X)
@@ -214,6 +335,7 @@ rule_and_passive_task::execute()
     _A->feedback (this, result);
     if(result) 
     {
+      if (best_first()) result->score(_score);
       LOG (logChartPruning, DEBUG, "SUCCESS    rule_and_passive: " << id() << " (" << start() << ", " << end() << ") " << _R->printname() << "  " << _p);
       if (Grammar->gm()) {
         if (_R->arity() == 1) {
@@ -239,9 +361,28 @@ rule_and_passive_task::execute()
 
 active_and_passive_task::active_and_passive_task(chart *C, tAbstractAgenda *A,
                                                  tItem *act, tItem *passive)
-    : basic_task(C, A), _active(act), _passive(passive)
+    : basic_task(C, A), _active(act), _passive(passive), _score(0.0)
 {
-  if (Grammar->gm()) {
+  if (best_first()) {
+    tPhrasalItem *active = dynamic_cast<tPhrasalItem *>(act);
+    int subtrees = 1;
+    if (active->restargs() == 0) {
+      item_list dtrs(active->daughters());
+      if (active->left_extending())
+        dtrs.push_front(passive);
+      else
+        dtrs.push_back(passive);
+      _score = Grammar->sm()->scoreLocalTree(active->rule(), dtrs);
+    } else {
+      _score = Grammar->sm()->combineScores(active->score(),
+                                            passive->score());
+      subtrees = active->daughters().size() + 1;
+    }
+    priority(best_first_priority(C, _score,
+                                 min(active->start(), passive->start()),
+                                 max(active->end(), passive->end()),
+                                 subtrees));
+  } else if (Grammar->gm()) {
     // Priority(R, X, Y) = P(R) P(R->XY) P(X) P(Y)
     tPhrasalItem *active = dynamic_cast<tPhrasalItem *>(act); 
     double prior = Grammar->gm()->prior(active->rule());
@@ -286,6 +427,7 @@ active_and_passive_task::execute()
     _A->feedback (this, result);
     if(result) 
     {
+      if (best_first()) result->score(_score);
       LOG (logChartPruning, DEBUG, "EX SUCCESS active_and_passive: " << id() << " ("
                                                            << _active->start()  << ", " << _active->end()  << ")  (" 
                                                            << _passive->start() << ", " << _passive->end() << ")  "
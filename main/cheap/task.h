@@ -26,6 +26,7 @@
 #define _TASK_H_
 
 #include "agenda.h"
+#include <cstddef>
 #include <functional>
 #include <iosfwd>
 
@@ -33,6 +34,7 @@
 typedef abstract_agenda< class basic_task, class task_priority_less > tAbstractAgenda;
 typedef exhaustive_agenda< class basic_task, class task_priority_less > tExhaustiveAgenda;
 typedef local_cap_agenda< class basic_task, class task_priority_less > tLocalCapAgenda;
+typedef best_first_agenda< class basic_task, class task_priority_less > tBestFirstAgenda;
 
 /** Pure virtual base class for tasks */
 class basic_task {
@@ -50,6 +52,20 @@ public:
   /** Execute the task */
   virtual class tItem * execute() = 0;
 
+  /** @name Task Pool
+   * Tasks are created and deleted by the hundreds of thousands for long
+   * inputs, so they are allocated from a free list of fixed size slots
+   * instead of the general heap. The memory of the pool is given back by
+   * release_pool() when no task is left.
+   */
+  /*@{*/
+  void *operator new(size_t n);
+  void operator delete(void *p, size_t n);
+
+  /** Free all memory of the task pool if there are no tasks anymore */
+  static void release_pool();
+  /*@}*/
+
   /** Return ID counter */
   inline int id() {return _id;}
     
@@ -116,6 +132,8 @@ class rule_and_passive_task : public basic_task
  private:
     grammar_rule *_R;
     class tItem *_passive;
+    /** The score of the item this task builds in best-first mode */
+    double _score;
 };
 
 /** Combination of active and passive item */
@@ -145,6 +163,8 @@ class active_and_passive_task : public basic_task
  private:
     class tItem *_active;
     class tItem *_passive;
+    /** The score of the item this task builds in best-first mode */
+    double _score;
 };
 
 /** Comparison predicate for tasks based on their priority */
@@ -158,6 +178,14 @@ class task_priority_less
     {
         return x->priority() < y->priority();
     }
+
+    /** The same for agenda entries, which carry a copy of the priority */
+    inline bool
+    operator() (const agenda_entry<basic_task> &x,
+                const agenda_entry<basic_task> &y) const
+    {
+        return x.priority < y.priority;
+    }
 };
 
 inline std::ostream & operator<<(std::ostream &out, basic_task *t) {
@@ -0,0 +1,582 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** \file benchmark.cpp
+ * Micro- and macro-benchmarks of the parser's hot paths.
+ *
+ * Usage: benchmark [cheap options] grammar < inputs
+ *
+ * The microbenchmarks time the type hierarchy (glb(), also on the types at
+ * the quick check paths and on a skewed sample of all non-leaf types, both
+ * without and with the dense glb table, and the bitcode operations behind
+ * it, core_glb() and core_subtype()), the unifier
+ * (unify_restrict(), unify_np(), subsumes(), copy()), the unification quick
+ * check, the morphological analyzer (with and without its cache) and token
+ * mapping on the feature structures of the grammar's rules and lexicon
+ * entries, and the TDL lexer on a synthetic lexicon file, whose throughput is
+ * given in MB/s. Then every input line is parsed end to end. Each benchmark
+ * is repeated until it has run for a fixed minimum time; the results are
+ * written to stdout as one JSON object whose layout only depends on the
+ * grammar and the inputs. The `result' fields (successful unifications,
+ * readings, ...) do not depend on the machine and should only change if the
+ * behaviour of the code does.
+ */
+
+#include "pet-config.h"
+#include "cheap.h"
+#include "chart.h"
+#include "chart-mapping.h"
+#include "fs.h"
+#include "fs-chart.h"
+#include "grammar.h"
+#include "grammar-dump.h"
+#include "item.h"
+#include "lex-tdl.h"
+#include "lexicon.h"
+#include "lexparser.h"
+#include "lingo-tokenizer.h"
+#include "morph.h"
+#include "options.h"
+#include "parse.h"
+#include "parsenodes.h"
+#include "settings.h"
+#include "tsdb++.h"
+#include "types.h"
+#include "utility.h"
+#include "yy-tokenizer.h"
+
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// required global settings from cheap.cpp
+const char * version_string = VERSION ;
+FILE* ferr = stderr;
+FILE* fstatus = stderr;
+FILE* flog = NULL;
+int verbosity = 0;
+bool XMLServices = false;
+tGrammar *Grammar;
+ParseNodes pn;
+settings *cheap_settings;
+
+/** Every benchmark runs at least this long (in nanoseconds) */
+static const long long BENCH_MIN_NS = 200000000LL;
+
+static long long now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/** A microbenchmark: does one round of operations, returns their number and
+ *  adds the number of successful ones to \a result.
+ */
+typedef int (*bench_function)(long long &result);
+
+/** The feature structures of all rules and lexicon entries */
+static vector<fs> bench_fss;
+/** The quick check vectors of \c bench_fss */
+static vector<qc_vec> bench_qcs;
+/** The word forms for the morphology */
+static vector<string> bench_forms;
+/** The inputs of the end to end benchmarks */
+static vector<string> bench_inputs;
+/** The grammar's LKB style morphology, if it has one */
+static tLKBMorphology *bench_morphology = 0;
+/** The tokenizer of the lexical parser */
+static tTokenizer *bench_tokenizer = 0;
+/** The synthetic TDL lexicon file for the lexer benchmark, and its size */
+static string bench_lexicon;
+static long long bench_lexicon_size = 0;
+
+static int bench_glb(long long &result) {
+  int n = nstatictypes < 256 ? nstatictypes : 256;
+  for(int i = 0; i < n; ++i)
+    for(int j = 0; j < n; ++j)
+      if(glb(i, j) != T_BOTTOM) ++result;
+  return n * n;
+}
+
+/** The glbs the quick check asks for: the types at every quick check path
+ *  of the rules' arguments and of the sample feature structures. Unlike
+ *  bench_glb(), this follows the distribution of the real queries, which is
+ *  what the dense glb table is built for.
+ */
+static int bench_glb_qc(long long &result) {
+  int ops = 0, len = fs::get_unif_qc_length();
+  for(ruleiter it = Grammar->rules().begin(); it != Grammar->rules().end();
+      ++it) {
+    grammar_rule *R = *it;
+    const qc_vec &arg = R->qc_vector_unif(R->nextarg());
+    for(vector<qc_vec>::iterator d = bench_qcs.begin(); d != bench_qcs.end();
+        ++d)
+      for(int i = 0; i < len; ++i) {
+        if(glb(arg[i], (*d)[i]) != T_BOTTOM) ++result;
+        ++ops;
+      }
+  }
+  return ops;
+}
+
+/** Pairs of distinct static non-leaf types for bench_glb_sample() */
+static vector<pair<type_t, type_t> > bench_glb_pairs;
+
+/** A 64 bit linear congruential generator (Knuth, TAOCP 3.3.4), so that the
+ *  samples are the same everywhere. Returns 31 random bits.
+ */
+static unsigned long bench_random(unsigned long long &seed) {
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (unsigned long) (seed >> 33);
+}
+
+/** Draw \a n pairs for bench_glb_sample(). The static non-leaf types other
+ *  than \c BI_TOP are shuffled, and the type at position i is drawn with a
+ *  probability that falls with i, so that a few hundred types get most of
+ *  the queries, as in a real grammar, without these being the ones with the
+ *  lowest codes. The pairs only depend on the grammar.
+ */
+static void make_glb_pairs(int n) {
+  vector<type_t> types;
+  for(type_t t = 0; t < first_leaftype; ++t)
+    if(t != BI_TOP) types.push_back(t);
+  if(types.size() < 2) return;
+  unsigned long long seed = 42;
+  for(size_t i = types.size() - 1; i > 0; --i)
+    swap(types[i], types[bench_random(seed) % (i + 1)]);
+  while((int) bench_glb_pairs.size() < n) {
+    double u = bench_random(seed) / (double) (1ULL << 31);
+    double v = bench_random(seed) / (double) (1ULL << 31);
+    type_t a = types[(size_t) (u * u * u * types.size())];
+    type_t b = types[(size_t) (v * v * v * types.size())];
+    if(a != b) bench_glb_pairs.push_back(make_pair(a, b));
+  }
+}
+
+/** glb() on a fixed sample of pairs of non-leaf types, see make_glb_pairs().
+ *  Unlike bench_glb_qc(), this needs no quick check paths, and unlike
+ *  bench_glb(), it covers all types of a large hierarchy.
+ */
+static int bench_glb_sample(long long &result) {
+  for(vector<pair<type_t, type_t> >::iterator p = bench_glb_pairs.begin();
+      p != bench_glb_pairs.end(); ++p)
+    if(glb(p->first, p->second) != T_BOTTOM) ++result;
+  return bench_glb_pairs.size();
+}
+
+static int bench_core_glb(long long &result) {
+  int n = first_leaftype < 256 ? first_leaftype : 256;
+  for(int i = 0; i < n; ++i)
+    for(int j = 0; j < n; ++j)
+      if(core_glb(i, j) != T_BOTTOM) ++result;
+  return n * n;
+}
+
+static int bench_core_subtype(long long &result) {
+  int n = first_leaftype < 256 ? first_leaftype : 256;
+  for(int i = 0; i < n; ++i)
+    for(int j = 0; j < n; ++j)
+      if(core_subtype(i, j)) ++result;
+  return n * n;
+}
+
+static int bench_unify(long long &result) {
+  int ops = 0;
+  for(ruleiter it = Grammar->rules().begin(); it != Grammar->rules().end();
+      ++it) {
+    grammar_rule *R = *it;
+    for(vector<fs>::iterator d = bench_fss.begin(); d != bench_fss.end();
+        ++d) {
+      fs_alloc_state FSAS;
+      fs rule = R->instantiate();
+      fs arg = R->nextarg(rule);
+      fs res = unify_restrict(rule, *d, arg,
+                              R->arity() == 1
+                              ? Grammar->deleted_daughters() : 0);
+      if(res.valid()) ++result;
+      ++ops;
+    }
+  }
+  return ops;
+}
+
+static int bench_unify_np(long long &result) {
+  int ops = 0;
+  for(ruleiter it = Grammar->rules().begin(); it != Grammar->rules().end();
+      ++it) {
+    grammar_rule *R = *it;
+    for(vector<fs>::iterator d = bench_fss.begin(); d != bench_fss.end();
+        ++d) {
+      fs_alloc_state FSAS;
+      fs rule = R->instantiate();
+      fs arg = R->nextarg(rule);
+      fs res = unify_np(rule, *d, arg);
+      if(res.valid()) ++result;
+      ++ops;
+    }
+  }
+  return ops;
+}
+
+static int bench_subsumes(long long &result) {
+  int ops = 0;
+  for(vector<fs>::iterator a = bench_fss.begin(); a != bench_fss.end(); ++a)
+    for(vector<fs>::iterator b = bench_fss.begin(); b != bench_fss.end();
+        ++b) {
+      bool forward = true, backward = true;
+      subsumes(*a, *b, forward, backward);
+      if(forward) ++result;
+      ++ops;
+    }
+  return ops;
+}
+
+static int bench_qc_unif(long long &result) {
+  int ops = 0;
+  for(ruleiter it = Grammar->rules().begin(); it != Grammar->rules().end();
+      ++it) {
+    grammar_rule *R = *it;
+    const qc_vec &arg = R->qc_vector_unif(R->nextarg());
+    for(vector<qc_vec>::iterator d = bench_qcs.begin(); d != bench_qcs.end();
+        ++d) {
+      if(fs::qc_compatible_unif(arg, *d)) ++result;
+      ++ops;
+    }
+  }
+  return ops;
+}
+
+static int bench_copy(long long &result) {
+  fs_alloc_state FSAS;
+  for(vector<fs>::iterator f = bench_fss.begin(); f != bench_fss.end(); ++f)
+    if(copy(*f).valid()) ++result;
+  return bench_fss.size();
+}
+
+/** Analyze the word forms; the analyzer's cache decides whether this
+ *  measures the analysis or the cache
+ */
+static int bench_morph(long long &result) {
+  for(vector<string>::iterator f = bench_forms.begin();
+      f != bench_forms.end(); ++f)
+    result += (*bench_morphology)(*f).size();
+  return bench_forms.size();
+}
+
+static int bench_chart_mapping(long long &result) {
+  item_owner *owner = tItem::default_owner();
+  for(vector<string>::iterator in = bench_inputs.begin();
+      in != bench_inputs.end(); ++in) {
+    item_owner items;
+    tItem::default_owner(&items);
+    inp_list tokens;
+    bench_tokenizer->tokenize(*in, tokens);
+    tChart chart;
+    tChartUtil::map_chart(tokens, chart);
+    tChartMappingEngine mapper(Grammar->tokmap_rules(), "token mapping");
+    mapper.process(chart);
+    inp_list mapped;
+    tChartUtil::map_chart(chart, mapped);
+    result += mapped.size();
+  }
+  tItem::default_owner(owner);
+  return bench_inputs.size();
+}
+
+/** Tokenize the synthetic lexicon once; the operations are its bytes */
+static int bench_tdl_lexer(long long &result) {
+  push_file(bench_lexicon, NULL);
+  for(; LA(0)->tag != T_EOF; consume(1)) ++result;
+  consume(1);
+  return bench_lexicon_size;
+}
+
+/** Write a TDL lexicon of \a n entries with comments to a temporary file */
+static void make_lexicon(int n) {
+  char name[] = "/tmp/pet-lexicon-XXXXXX";
+  int fd = mkstemp(name);
+  if(fd >= 0) bench_lexicon = name;
+  FILE *f = fd < 0 ? NULL : fdopen(fd, "w");
+  if(f == NULL) throw tError("could not create the benchmark lexicon");
+  for(int i = 0; i < n; ++i) {
+    if(i % 100 == 0)
+      fprintf(f, "#|\n  entries %d to %d of the benchmark lexicon\n|#\n\n",
+              i, i + 99);
+    fprintf(f, "; entry %d\nw%d_n := noun-lxm &\n"
+            "  [ ORTH <! \"w%d\" !>,\n    SYNSEM.LKEYS.KEYREL.PRED "
+            "\"_w%d_n_rel\" ].\n\n", i, i, i, i);
+  }
+  bench_lexicon_size = ftell(f);
+  fclose(f);
+}
+
+/** Run \a f for at least \c BENCH_MIN_NS and print its JSON record */
+static void run_micro(const char *name, bench_function f, bool last) {
+  long long result = 0, ops = 0, rounds = 0;
+  long long start = now_ns(), elapsed;
+  do {
+    result = 0;
+    ops += f(result);
+    ++rounds;
+    elapsed = now_ns() - start;
+  } while(elapsed < BENCH_MIN_NS);
+  printf("    {\"name\": \"%s\", \"ops\": %lld, \"result\": %lld, "
+         "\"ns_per_op\": %.1f}%s\n", name, ops / rounds, result,
+         ops > 0 ? (double) elapsed / ops : 0.0, last ? "" : ",");
+}
+
+/** The number of queries of one round of bench_glb_qc() that glb() counts
+ *  for the ranking of the dense glb table
+ */
+static long glb_qc_queries() {
+  long queries = 0, len = fs::get_unif_qc_length();
+  for(ruleiter it = Grammar->rules().begin(); it != Grammar->rules().end();
+      ++it) {
+    const qc_vec &arg = (*it)->qc_vector_unif((*it)->nextarg());
+    for(vector<qc_vec>::iterator d = bench_qcs.begin(); d != bench_qcs.end();
+        ++d)
+      for(int i = 0; i < len; ++i)
+        if(arg[i] != (*d)[i] && arg[i] != BI_TOP && (*d)[i] != BI_TOP
+           && arg[i] >= 0 && (*d)[i] >= 0
+           && arg[i] < first_leaftype && (*d)[i] < first_leaftype)
+          ++queries;
+  }
+  return queries;
+}
+
+/** Time the glb benchmark \a f without a dense glb table (as \a name) and
+ *  with a table of \a n types (as \a name_table) that is ranked by one
+ *  round of \a f, which makes \a queries counted queries.
+ */
+static void run_glb_table(const char *name, const char *name_table,
+                          bench_function f, long queries, int n) {
+  free_glb_table();
+  run_micro(name, f, false);
+  long long result = 0;
+  init_glb_table(n, queries);
+  f(result);
+  run_micro(name_table, f, false);
+  free_glb_table();
+}
+
+/** Time the glb benchmarks without and with a dense glb table of \a n
+ *  types, then restore the grammar's own glb table settings.
+ */
+static void run_glb_tables(int n) {
+  run_glb_table("glb_qc", "glb_qc_table", bench_glb_qc, glb_qc_queries(), n);
+  run_glb_table("glb_sample", "glb_sample_table", bench_glb_sample,
+                bench_glb_pairs.size(), n);
+  const char *glbtable = cheap_settings->value("glb-table-types");
+  if(glbtable != NULL) {
+    const char *warmup = cheap_settings->value("glb-table-warmup");
+    init_glb_table(strtoint(glbtable, "as value of glb-table-types"),
+                   warmup != NULL
+                   ? strtoint(warmup, "as value of glb-table-warmup")
+                   : 100000);
+  }
+}
+
+/** Time the morphology without its cache (cold), then with the grammar's
+ *  cache size after one round has filled it (warm).
+ */
+static void run_morph(bool last) {
+  tMorphAnalyzer &analyzer = bench_morphology->analyzer();
+  unsigned int size = analyzer.cache_size();
+  analyzer.set_cache_size(0);
+  run_micro("morph_analyze_cold", bench_morph, false);
+  analyzer.set_cache_size(size);
+  long long result = 0;
+  bench_morph(result);
+  run_micro("morph_analyze_warm", bench_morph, last);
+}
+
+/** Run the lexer benchmark for at least \c BENCH_MIN_NS and print its JSON
+ *  record, with the throughput in MB/s.
+ */
+static void run_lexer(bool last) {
+  long long result = 0, bytes = 0, rounds = 0;
+  long long start = now_ns(), elapsed;
+  do {
+    result = 0;
+    bytes += bench_tdl_lexer(result);
+    ++rounds;
+    elapsed = now_ns() - start;
+  } while(elapsed < BENCH_MIN_NS);
+  printf("    {\"name\": \"tdl_lexer\", \"bytes\": %lld, \"result\": %lld, "
+         "\"mb_per_s\": %.1f}%s\n", bytes / rounds, result,
+         bytes / 1e6 / (elapsed / 1e9), last ? "" : ",");
+}
+
+/** Parse \a input until at least \c BENCH_MIN_NS have passed and print its
+ *  JSON record. Items that fail with an error are timed all the same.
+ */
+static void run_parse(const string &input, int id, bool last) {
+  long long rounds = 0;
+  long long start = now_ns(), elapsed;
+  int nerrors;
+  do {
+    chart *C = 0;
+    fs_alloc_state FSAS;
+    list<tError> errors;
+    try {
+      analyze(input, C, FSAS, errors, id);
+      nerrors = errors.size();
+    }
+    catch(tError &e) {
+      nerrors = 1;
+    }
+    delete C;
+    ++rounds;
+    elapsed = now_ns() - start;
+  } while(elapsed < BENCH_MIN_NS);
+  printf("    {\"input\": %s, \"words\": %d, \"readings\": %d, "
+         "\"pedges\": %d, \"errors\": %d, \"runs\": %lld, "
+         "\"ms_per_parse\": %.3f}%s\n",
+         json_string(input).c_str(), stats.words, stats.readings,
+         stats.pedges, nerrors, rounds, elapsed / 1e6 / rounds,
+         last ? "" : ",");
+}
+
+/** Set up the lexical processing like cheap does, with the internal
+ *  lexicon, the grammar's morphology and the string or yy tokenizer.
+ */
+static void load_grammar(const string &grampath) {
+  cheap_settings = new settings(raw_name(grampath), grampath, "reading");
+  Grammar = new tGrammar(grampath.c_str());
+#ifdef DYNAMIC_SYMBOLS
+  init_characterization();
+#endif
+  Lexparser.init();
+
+  dumper dmp(grampath.c_str());
+  tFullformMorphology *ff = tFullformMorphology::create(dmp);
+  if(ff != NULL) Lexparser.register_morphology(ff);
+  bench_morphology = tLKBMorphology::create(dmp);
+  if(bench_morphology != NULL)
+    Lexparser.register_morphology(bench_morphology);
+  else if(ff == NULL)
+    Lexparser.register_morphology(new tNullMorphology());
+  Lexparser.register_lexicon(new tInternalLexicon());
+
+  switch(get_opt<tokenizer_id>("opt_tok")) {
+  case TOKENIZER_STRING:
+    bench_tokenizer = new tLingoTokenizer(); break;
+  case TOKENIZER_YY:
+    bench_tokenizer = new tYYTokenizer(STANDOFF_POINTS); break;
+  case TOKENIZER_YY_COUNTS:
+    bench_tokenizer = new tYYTokenizer(STANDOFF_COUNTS); break;
+  default:
+    throw tError("the benchmark supports the string and yy tokenizers only");
+  }
+  Lexparser.register_tokenizer(bench_tokenizer);
+  pn.initialize();
+}
+
+/** Collect the feature structures and word forms of the grammar */
+static void collect_samples() {
+  for(ruleiter it = Grammar->rules().begin(); it != Grammar->rules().end();
+      ++it)
+    bench_fss.push_back((*it)->instantiate());
+  for(type_t t = 0; t < nstatictypes; ++t) {
+    lex_stem *stem = Grammar->find_stem(t);
+    if(stem == NULL) continue;
+    bench_fss.push_back(stem->instantiate());
+    string orth = stem->orth(stem->inflpos());
+    bench_forms.push_back(orth);
+    bench_forms.push_back(orth + "s");
+    bench_forms.push_back(orth + "ed");
+  }
+  for(vector<fs>::iterator f = bench_fss.begin(); f != bench_fss.end(); ++f)
+    bench_qcs.push_back(f->get_unif_qc_vector());
+}
+
+static void init_main_options() {
+  // options of cheap.cpp the library depends on
+  managed_opt("opt_tsdb", "", 0);
+  managed_opt("opt_mrs", "", string());
+  managed_opt("opt_yy", "", false);
+  managed_opt("opt_preprocess_only", "", string());
+}
+
+int
+main(int argc, char **argv)
+{
+  setlocale(LC_ALL, "C");
+  init_main_options();
+  const char *grammar_name = parse_options(argc, argv);
+  if(grammar_name == NULL) {
+    fprintf(ferr, "usage: %s [cheap options] <grammar-name> < inputs\n",
+            argv[0]);
+    return 2;
+  }
+  string grampath = find_file(grammar_name, GRAMMAR_EXT);
+  if(grampath.empty()) {
+    fprintf(ferr, "Grammar not found\n");
+    return 3;
+  }
+
+  int status = 0;
+  try {
+    load_grammar(grampath);
+
+    string input;
+    while(Lexparser.next_input(cin, input))
+      if(! input.empty()) bench_inputs.push_back(input);
+
+    collect_samples();
+    make_glb_pairs(100000);
+    make_lexicon(20000);
+
+    printf("{\n  \"grammar\": %s,\n  \"types\": %d,\n  \"rules\": %d,\n"
+           "  \"feature_structures\": %d,\n  \"micro\": [\n",
+           json_string(grammar_name).c_str(), nstatictypes,
+           (int) Grammar->rules().size(), (int) bench_fss.size());
+    bool morph = bench_morphology != NULL && ! bench_forms.empty();
+    bool tokmap = ! Grammar->tokmap_rules().empty() && ! bench_inputs.empty();
+    run_lexer(false);
+    run_micro("glb", bench_glb, false);
+    run_glb_tables(1000);
+    run_micro("core_glb", bench_core_glb, false);
+    run_micro("core_subtype", bench_core_subtype, false);
+    run_micro("unify_restrict", bench_unify, false);
+    run_micro("unify_np", bench_unify_np, false);
+    run_micro("subsumes", bench_subsumes, false);
+    run_micro("qc_compatible_unif", bench_qc_unif, false);
+    run_micro("copy", bench_copy, ! morph && ! tokmap);
+    if(morph) run_morph(! tokmap);
+    if(tokmap) run_micro("chart_mapping", bench_chart_mapping, true);
+    printf("  ],\n  \"parse\": [\n");
+    for(size_t i = 0; i < bench_inputs.size(); ++i)
+      run_parse(bench_inputs[i], i + 1, i + 1 == bench_inputs.size());
+    printf("  ]\n}\n");
+  }
+  catch(tError &e) {
+    fprintf(ferr, "%s\n", e.getMessage().c_str());
+    status = 1;
+  }
+  if(! bench_lexicon.empty()) unlink(bench_lexicon.c_str());
+  return status;
+}
@@ -0,0 +1,217 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file best-first-test.cpp
+ * Unit tests for best-first parsing with a parse selection model.
+ */
+
+#include "pet-config.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "chart.h"
+#include "fs.h"
+#include "grammar.h"
+#include "item.h"
+#include "sm.h"
+#include "tester.h"
+#include "tsdb++.h"
+
+#include <cmath>
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+extern tGrammar* Grammar;
+extern int opt_nsolutions, opt_packing;
+extern bool opt_best_first;
+
+/** The test model, except that unary rules add a fixed gain to the scores
+ *  of their daughters. It has bounds for the rest of a tree then, as long as
+ *  the unary rules of the grammar do not form a cycle.
+ */
+class tBoundedTestSM : public tTestSM {
+public:
+  tBoundedTestSM(double unary_gain = 0.0) : _unary_gain(unary_gain) {}
+
+  virtual string description() { return "bounded test model"; }
+
+  virtual double
+  scoreLocalTree(grammar_rule *R, const list<tItem *> &dtrs) {
+    if(R->arity() > 1)
+      return tSM::scoreLocalTree(R, dtrs);
+    return dtrs.front()->score() + _unary_gain;
+  }
+  virtual double
+  scoreLocalTree(grammar_rule *R, const vector<tItem *> &dtrs) {
+    if(R->arity() > 1)
+      return tSM::scoreLocalTree(R, dtrs);
+    return dtrs.front()->score() + _unary_gain;
+  }
+
+  virtual double maxLocalTreeGain(grammar_rule *R) {
+    return R->arity() > 1 ? 4.0 : _unary_gain;
+  }
+  virtual double maxLeafScore() { return 2.0; }
+
+private:
+  double _unary_gain;
+};
+
+class tBestFirstTest : public tParserTest
+{
+  CPPUNIT_TEST_SUITE(tBestFirstTest);
+  CPPUNIT_TEST(test_best_reading);
+  CPPUNIT_TEST(test_unary_gain);
+  CPPUNIT_TEST(test_unbounded);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  tSM *_sm;
+
+  /** Inputs from the words of the grammar's lexicon: every word six times,
+   *  which is highly ambiguous for a rule that combines two phrases of the
+   *  same kind, and all words, each one twice.
+   */
+  vector<string> inputs()
+  {
+    vector<string> words = lexicon_words();
+    vector<string> result;
+    string all;
+    for(size_t w = 0; w < words.size(); ++w) {
+      string repeated;
+      for(int i = 0; i < 6; ++i)
+        repeated += words[w] + " ";
+      result.push_back(repeated);
+      all += words[w] + " " + words[w] + " ";
+    }
+    result.push_back(all);
+    return result;
+  }
+
+  /** Parse \a input exhaustively and best-first with one solution, and
+   *  return the scores of the best readings of both. Add the passive edges
+   *  of the parses to \a exhaustive and \a best_first.
+   */
+  void compare(const string &input, double &best, double &first,
+               int &exhaustive, int &best_first)
+  {
+    fs_alloc_state FSAS;
+    chart *C = NULL;
+    opt_packing = 0;
+    opt_best_first = true;
+    opt_nsolutions = 0;
+    parse(input, C, FSAS);
+    best = C->readings().front()->score();
+    exhaustive += stats.pedges;
+    delete C;
+    C = NULL;
+
+    opt_nsolutions = 1;
+    parse(input, C, FSAS);
+    first = C->readings().front()->score();
+    best_first += stats.pedges;
+    delete C;
+  }
+
+  /** Replace the model of the grammar with \a sm */
+  void model(tSM *sm)
+  {
+    delete _sm;
+    _sm = sm;
+    Grammar->sm(_sm);
+  }
+
+public:
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started before each test.
+   */
+  void setUp()
+  {
+    tParserTest::setUp();
+    _sm = NULL;
+    model(new tBoundedTestSM());
+  }
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started after each test.
+   */
+  void tearDown()
+  {
+    tParserTest::tearDown();
+    delete _sm;
+  }
+
+  /** The first reading of a best-first parse that stops after one solution
+   *  scores as well as the first of all readings, which are sorted by their
+   *  scores when the parse goes on until the agenda is empty. The parse
+   *  stops before that, with fewer passive edges.
+   */
+  void test_best_reading()
+  {
+    vector<string> input = inputs();
+    int exhaustive = 0, best_first = 0;
+    CPPUNIT_ASSERT(_sm->outsideBound(0, 1) != HUGE_VAL);
+    for(size_t i = 0; i < input.size(); ++i) {
+      double best, first;
+      compare(input[i], best, first, exhaustive, best_first);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(best, first, 1e-9);
+    }
+    CPPUNIT_ASSERT(best_first < exhaustive);
+  }
+
+  /** Unary rules that raise the scores of their daughters still bound the
+   *  scores, since the unary rules of the test grammar form no cycle.
+   */
+  void test_unary_gain()
+  {
+    model(new tBoundedTestSM(1.0));
+    CPPUNIT_ASSERT(_sm->outsideBound(0, 1) != HUGE_VAL);
+    vector<string> input = inputs();
+    int exhaustive = 0, best_first = 0;
+    for(size_t i = 0; i < input.size(); ++i) {
+      double best, first;
+      compare(input[i], best, first, exhaustive, best_first);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(best, first, 1e-9);
+    }
+    CPPUNIT_ASSERT(best_first < exhaustive);
+  }
+
+  /** A model without bounds stops after the first tree */
+  void test_unbounded()
+  {
+    model(new tTestSM());
+    CPPUNIT_ASSERT(_sm->outsideBound(0, 1) == HUGE_VAL);
+    vector<string> input = inputs();
+    int exhaustive = 0, best_first = 0;
+    for(size_t i = 0; i < input.size(); ++i) {
+      double best, first;
+      compare(input[i], best, first, exhaustive, best_first);
+      CPPUNIT_ASSERT(stats.trees == 1);
+    }
+    CPPUNIT_ASSERT(best_first < exhaustive);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(tBestFirstTest);
@@ -0,0 +1,120 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file chart-mapping-test.cpp
+ * Unit tests for the literal prefixes of the regular expressions in chart
+ * mapping rules.
+ */
+
+#include "pet-config.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "chart-mapping.h"
+
+#include <string>
+
+using namespace std;
+
+class tLiteralPrefixTest : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(tLiteralPrefixTest);
+  CPPUNIT_TEST(test_literals);
+  CPPUNIT_TEST(test_anchors);
+  CPPUNIT_TEST(test_escapes);
+  CPPUNIT_TEST(test_alternation);
+  CPPUNIT_TEST(test_quantifiers);
+  CPPUNIT_TEST(test_groups);
+  CPPUNIT_TEST(test_classes);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  /** A plain string is its own prefix */
+  void test_literals()
+  {
+    CPPUNIT_ASSERT(regex_literal_prefix("") == "");
+    CPPUNIT_ASSERT(regex_literal_prefix("dog") == "dog");
+    CPPUNIT_ASSERT(regex_literal_prefix("dog.") == "dog");
+  }
+
+  /** A leading anchor is skipped, an anchor after it ends the prefix */
+  void test_anchors()
+  {
+    CPPUNIT_ASSERT(regex_literal_prefix("^dog") == "dog");
+    CPPUNIT_ASSERT(regex_literal_prefix("dog$") == "dog");
+    CPPUNIT_ASSERT(regex_literal_prefix("^dog$") == "dog");
+    CPPUNIT_ASSERT(regex_literal_prefix("^") == "");
+    CPPUNIT_ASSERT(regex_literal_prefix("^?dog") == "");
+    CPPUNIT_ASSERT(regex_literal_prefix("do^g") == "do");
+  }
+
+  /** An escaped character ends the prefix, even if it is a literal one */
+  void test_escapes()
+  {
+    CPPUNIT_ASSERT(regex_literal_prefix("dog\\.s") == "dog");
+    CPPUNIT_ASSERT(regex_literal_prefix("\\dog") == "");
+    CPPUNIT_ASSERT(regex_literal_prefix("dog\\|cat") == "");
+  }
+
+  /** There is no prefix if the expression has an alternation anywhere */
+  void test_alternation()
+  {
+    CPPUNIT_ASSERT(regex_literal_prefix("dog|cat") == "");
+    CPPUNIT_ASSERT(regex_literal_prefix("dogs|dog") == "");
+    CPPUNIT_ASSERT(regex_literal_prefix("do(g|t)") == "");
+    CPPUNIT_ASSERT(regex_literal_prefix("^(dog|cat)s$") == "");
+  }
+
+  /** A character that may be left out is not part of the prefix, one that
+   *  occurs at least once is
+   */
+  void test_quantifiers()
+  {
+    CPPUNIT_ASSERT(regex_literal_prefix("dogs*") == "dog");
+    CPPUNIT_ASSERT(regex_literal_prefix("dogs?") == "dog");
+    CPPUNIT_ASSERT(regex_literal_prefix("dogs{0,2}") == "dog");
+    CPPUNIT_ASSERT(regex_literal_prefix("dogs+") == "dogs");
+    CPPUNIT_ASSERT(regex_literal_prefix("d*og") == "");
+    // all bytes of an optional multibyte character are left out
+    CPPUNIT_ASSERT(regex_literal_prefix("caf\xc3\xa9?") == "caf");
+  }
+
+  /** Plain groups are part of the prefix, unless they may be left out */
+  void test_groups()
+  {
+    CPPUNIT_ASSERT(regex_literal_prefix("(do)g") == "dog");
+    CPPUNIT_ASSERT(regex_literal_prefix("d((o)g)s") == "dogs");
+    CPPUNIT_ASSERT(regex_literal_prefix("d(og)?s") == "d");
+    CPPUNIT_ASSERT(regex_literal_prefix("d(og)*") == "d");
+    CPPUNIT_ASSERT(regex_literal_prefix("d(og") == "d");
+    CPPUNIT_ASSERT(regex_literal_prefix("d(o(g)?)s") == "d");
+    CPPUNIT_ASSERT(regex_literal_prefix("d(?:og)") == "d");
+  }
+
+  /** A character class ends the prefix */
+  void test_classes()
+  {
+    CPPUNIT_ASSERT(regex_literal_prefix("do[gt]") == "do");
+    CPPUNIT_ASSERT(regex_literal_prefix("[dD]og") == "");
+    CPPUNIT_ASSERT(regex_literal_prefix("do[^a-z]s") == "do");
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(tLiteralPrefixTest);
@@ -24,6 +24,7 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 #include <unistd.h>
+#include <algorithm>
 
 #include "errors.h"
 #include "fs.h"
@@ -40,6 +41,7 @@ class tChartTest : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE(tChartTest);
   CPPUNIT_TEST(test_initialization);
   CPPUNIT_TEST(test_lattice);
+  CPPUNIT_TEST(test_cached_neighbours);
   CPPUNIT_TEST_SUITE_END();
   
 private:
@@ -53,6 +55,34 @@ private:
   tItem *_i2;
   tItem *_i3;
   tItem *_i4;
+
+  /**
+   * Check that the cached is_succeeding_item() and is_preceding_item()
+   * agree with succeeding_items() and preceding_items() for \a items and
+   * all vertices and small distances.
+   */
+  void check_neighbours(const std::list<tItem*> &items)
+  {
+    std::list<tChartVertex*> vertices = _chart.vertices();
+    for (std::list<tChartVertex*>::iterator vit = vertices.begin();
+         vit != vertices.end(); ++vit) {
+      for (int min = 0; min <= 3; ++min) {
+        for (int max = min; max <= 3; ++max) {
+          std::list<tItem*> succ = _chart.succeeding_items(*vit, min, max);
+          std::list<tItem*> prec = _chart.preceding_items(*vit, min, max);
+          for (std::list<tItem*>::const_iterator it = items.begin();
+               it != items.end(); ++it) {
+            CPPUNIT_ASSERT(_chart.is_succeeding_item(*it, *vit, min, max)
+                           == (find(succ.begin(), succ.end(), *it)
+                               != succ.end()));
+            CPPUNIT_ASSERT(_chart.is_preceding_item(*it, *vit, min, max)
+                           == (find(prec.begin(), prec.end(), *it)
+                               != prec.end()));
+          }
+        }
+      }
+    }
+  }
   
 public:
   
@@ -171,6 +201,29 @@ public:
     expected_items.push_back(_i3);
     CPPUNIT_ASSERT(_chart.succeeding_items(_v1, 0, 42) == expected_items);
   }
+
+  void test_cached_neighbours()
+  {
+    std::list<tItem*> items = _chart.items();
+    check_neighbours(items);
+
+    // the cached results must follow changes of the chart:
+    tItem *i5 = _chart.add_item(
+      new tInputItem("id",-1,-1,-1,-1,"f","s"), _v0, _v2);
+    items.push_back(i5);
+    check_neighbours(items);
+    CPPUNIT_ASSERT(_chart.is_succeeding_item(i5, _v0, 0, 0));
+    CPPUNIT_ASSERT(_chart.is_preceding_item(i5, _v2, 0, 0));
+
+    _chart.remove_item(_i1);
+    check_neighbours(items);
+    CPPUNIT_ASSERT(!_chart.is_succeeding_item(_i1, _v1, 0, 0));
+    CPPUNIT_ASSERT(!_chart.is_preceding_item(_i1, _v2, 0, 0));
+    CPPUNIT_ASSERT(_chart.is_succeeding_item(_i2, _v0, 1, 1)); // via i5
+    _chart.remove_item(i5);
+    check_neighbours(items);
+    CPPUNIT_ASSERT(!_chart.is_succeeding_item(_i2, _v0, 1, 1));
+  }
   
 };
 
@@ -0,0 +1,3 @@
+(in-package :common-lisp-user)
+
+(defparameter *grammar-version* "PET unit tests")
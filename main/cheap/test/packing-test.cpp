@@ -0,0 +1,114 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file packing-test.cpp
+ * Unit tests for the filters in front of the packing subsumption check.
+ */
+
+#include "pet-config.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "chart.h"
+#include "fs.h"
+#include "grammar.h"
+#include "item.h"
+#include "tester.h"
+#include "tsdb++.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+extern int opt_packing;
+
+class tPackingTest : public tParserTest
+{
+  CPPUNIT_TEST_SUITE(tPackingTest);
+  CPPUNIT_TEST(test_signature_sound);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  /** Check that the subsumption signatures of \a a and \a b do not rule out
+   *  a direction of subsumption that holds between them.
+   */
+  void check_signatures(tItem *a, tItem *b)
+  {
+    bool forward = true, backward = true;
+    subsumes(a->get_fs(), b->get_fs(), forward, backward);
+    bool sig_forward = true, sig_backward = true;
+    fs::signature_compatible_subs(a->subs_signature(), b->subs_signature(),
+                                  sig_forward, sig_backward);
+    CPPUNIT_ASSERT(sig_forward || !forward);
+    CPPUNIT_ASSERT(sig_backward || !backward);
+  }
+
+public:
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started before each test.
+   */
+  void setUp()
+  {
+    tParserTest::setUp();
+  }
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started after each test.
+   */
+  void tearDown()
+  {
+    tParserTest::tearDown();
+  }
+
+  /** The subsumption signatures never rule out a pair of passive items
+   *  where one subsumes the other, and they leave items to pack. The items
+   *  carry their restricted feature structures, as in packed_edge().
+   */
+  void test_signature_sound()
+  {
+    // an input from the words of the grammar's lexicon, each one twice
+    vector<string> words = lexicon_words();
+    string input;
+    for(size_t i = 0; i < words.size(); ++i)
+      input += words[i] + " " + words[i] + " ";
+
+    // the tester loads the grammar with packing
+    CPPUNIT_ASSERT(opt_packing != 0);
+    fs_alloc_state FSAS;
+    chart *C = NULL;
+    parse(input, C, FSAS);
+    CPPUNIT_ASSERT(stats.p_equivalent + stats.p_proactive
+                   + stats.p_retroactive > 0);
+
+    vector<tItem *> items;
+    for(chart_iter it(C); it.valid(); ++it)
+      if(it.current()->passive() && it.current()->trait() != INPUT_TRAIT)
+        items.push_back(it.current());
+    for(size_t i = 0; i < items.size(); ++i)
+      for(size_t j = 0; j < items.size(); ++j)
+        check_signatures(items[i], items[j]);
+    delete C;
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(tPackingTest);
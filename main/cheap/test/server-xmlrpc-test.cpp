@@ -0,0 +1,228 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file server-xmlrpc-test.cpp
+ * Unit tests for the XML-RPC method cheap.analyze_batch, called directly
+ * without the network layer.
+ */
+
+#include "pet-config.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "configs.h"
+#include "grammar.h"
+#include "server-xmlrpc.h"
+#include "tester.h"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <xmlrpc-c/girerr.hpp>
+
+using namespace std;
+
+extern tGrammar* Grammar;
+
+typedef map<string, xmlrpc_c::value> value_map;
+
+class tXMLRPCTest : public tParserTest
+{
+  CPPUNIT_TEST_SUITE(tXMLRPCTest);
+  CPPUNIT_TEST(test_error_per_input);
+  CPPUNIT_TEST(test_fields);
+  CPPUNIT_TEST(test_limits_restored);
+  CPPUNIT_TEST(test_limits_restored_on_fault);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  /** An input with two readings and one the grammar does not know */
+  string _ambiguous, _unknown;
+
+  /** A model, so that `nsolutions' limits the readings */
+  tTestSM *_sm;
+
+  /** Call cheap.analyze_batch on \a inputs with \a settings, if not NULL,
+   *  and return the results
+   */
+  vector<xmlrpc_c::value> analyze_batch(const vector<xmlrpc_c::value> &inputs,
+                                        const value_map *settings = NULL)
+  {
+    xmlrpc_c::paramList params;
+    params.add(xmlrpc_c::value_array(inputs));
+    if(settings != NULL) params.add(xmlrpc_c::value_struct(*settings));
+    xmlrpc_c::value result;
+    analyze_batch_method().execute(params, &result);
+    vector<xmlrpc_c::value> results =
+      xmlrpc_c::value_array(result).vectorValueValue();
+    CPPUNIT_ASSERT(results.size() == inputs.size());
+    return results;
+  }
+
+  /** A batch of the single input \a input */
+  vector<xmlrpc_c::value> batch(const string &input)
+  {
+    return vector<xmlrpc_c::value>(1, xmlrpc_c::value_string(input));
+  }
+
+  value_map fields(const xmlrpc_c::value &result)
+  {
+    return xmlrpc_c::value_struct(result).cvalue();
+  }
+
+  /** The readings of \a result, which must not be an error */
+  vector<xmlrpc_c::value> readings(const xmlrpc_c::value &result)
+  {
+    value_map f = fields(result);
+    CPPUNIT_ASSERT(f.count("error") == 0);
+    CPPUNIT_ASSERT(f.count("readings") == 1);
+    return xmlrpc_c::value_array(f["readings"]).vectorValueValue();
+  }
+
+  bool is_error(const xmlrpc_c::value &result)
+  {
+    value_map f = fields(result);
+    return f.size() == 1 && f.count("error") == 1;
+  }
+
+public:
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started before each test.
+   */
+  void setUp()
+  {
+    tParserTest::setUp();
+    vector<string> words = lexicon_words(2);
+    CPPUNIT_ASSERT(words.size() == 2);
+    _ambiguous = words[0] + " " + words[1] + " " + words[0];
+    _unknown = words[0] + words[1] + "unknown";
+    _sm = new tTestSM();
+  }
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started after each test.
+   */
+  void tearDown()
+  {
+    tParserTest::tearDown();
+    delete _sm;
+  }
+
+  /** An input that fails gets an error as its result, the others parse */
+  void test_error_per_input()
+  {
+    vector<xmlrpc_c::value> inputs;
+    inputs.push_back(xmlrpc_c::value_string(_ambiguous));
+    inputs.push_back(xmlrpc_c::value_string(_unknown));
+    inputs.push_back(xmlrpc_c::value_int(42));
+    inputs.push_back(xmlrpc_c::value_string(_ambiguous));
+    vector<xmlrpc_c::value> results = analyze_batch(inputs);
+    CPPUNIT_ASSERT(readings(results[0]).size() == 2);
+    CPPUNIT_ASSERT(is_error(results[1]));
+    CPPUNIT_ASSERT(is_error(results[2]));
+    CPPUNIT_ASSERT(readings(results[3]).size() == 2);
+
+    // an exhausted edge limit is an error of the input, too
+    value_map settings;
+    settings["pedgelimit"] = xmlrpc_c::value_int(1);
+    results = analyze_batch(inputs, &settings);
+    for(size_t i = 0; i < results.size(); ++i)
+      CPPUNIT_ASSERT(is_error(results[i]));
+
+    CPPUNIT_ASSERT(analyze_batch(vector<xmlrpc_c::value>()).empty());
+  }
+
+  /** The `fields' setting selects the parts of the results */
+  void test_fields()
+  {
+    value_map all = fields(analyze_batch(batch(_ambiguous))[0]);
+    CPPUNIT_ASSERT(all.count("surface") == 1);
+    vector<xmlrpc_c::value> udf = readings(analyze_batch(batch(_ambiguous))[0]);
+    CPPUNIT_ASSERT(fields(udf[0]).count("derivation") == 1);
+
+    vector<xmlrpc_c::value> names(1, xmlrpc_c::value_string("surface"));
+    value_map settings;
+    settings["fields"] = xmlrpc_c::value_array(names);
+    xmlrpc_c::value result = analyze_batch(batch(_ambiguous), &settings)[0];
+    CPPUNIT_ASSERT(fields(result).count("surface") == 1);
+    vector<xmlrpc_c::value> r = readings(result);
+    CPPUNIT_ASSERT(r.size() == 2);
+    for(size_t i = 0; i < r.size(); ++i)
+      CPPUNIT_ASSERT(fields(r[i]).empty());
+
+    names[0] = xmlrpc_c::value_string("derivation");
+    settings["fields"] = xmlrpc_c::value_array(names);
+    settings["derivformat"] = xmlrpc_c::value_string("compact");
+    result = analyze_batch(batch(_ambiguous), &settings)[0];
+    CPPUNIT_ASSERT(fields(result).count("surface") == 0);
+    r = readings(result);
+    CPPUNIT_ASSERT(r.size() == 2);
+    value_map reading = fields(r[0]);
+    CPPUNIT_ASSERT(reading.size() == 1 && reading.count("derivation") == 1);
+    CPPUNIT_ASSERT(xmlrpc_c::value_string(reading["derivation"]).cvalue()
+                   != xmlrpc_c::value_string(fields(udf[0])["derivation"])
+                      .cvalue());
+
+    names[0] = xmlrpc_c::value_string("trees");
+    settings["fields"] = xmlrpc_c::value_array(names);
+    CPPUNIT_ASSERT_THROW(analyze_batch(batch(_ambiguous), &settings),
+                         girerr::error);
+  }
+
+  /** The limits of a request do not outlast it */
+  void test_limits_restored()
+  {
+    int timeout = get_opt_int("opt_timeout");
+    int pedgelimit = get_opt_int("opt_pedgelimit");
+    int nsolutions = get_opt_int("opt_nsolutions");
+
+    value_map settings;
+    settings["timeout"] = xmlrpc_c::value_int(60);
+    settings["pedgelimit"] = xmlrpc_c::value_int(1000);
+    settings["nsolutions"] = xmlrpc_c::value_int(1);
+    Grammar->sm(_sm);
+    CPPUNIT_ASSERT(readings(analyze_batch(batch(_ambiguous), &settings)[0])
+                   .size() == 1);
+    CPPUNIT_ASSERT(get_opt_int("opt_timeout") == timeout);
+    CPPUNIT_ASSERT(get_opt_int("opt_pedgelimit") == pedgelimit);
+    CPPUNIT_ASSERT(get_opt_int("opt_nsolutions") == nsolutions);
+    CPPUNIT_ASSERT(readings(analyze_batch(batch(_ambiguous))[0]).size() == 2);
+  }
+
+  /** A setting of the wrong type fails the whole request, and the limits
+   *  set before it are restored
+   */
+  void test_limits_restored_on_fault()
+  {
+    int timeout = get_opt_int("opt_timeout");
+    value_map settings;
+    settings["timeout"] = xmlrpc_c::value_int(17);
+    settings["pedgelimit"] = xmlrpc_c::value_string("many");
+    CPPUNIT_ASSERT_THROW(analyze_batch(batch(_ambiguous), &settings),
+                         std::exception);
+    CPPUNIT_ASSERT(get_opt_int("opt_timeout") == timeout);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(tXMLRPCTest);
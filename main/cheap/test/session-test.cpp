@@ -0,0 +1,140 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file session-test.cpp
+ * Unit tests for interleaved parser sessions.
+ */
+
+#include "pet-config.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "grammar.h"
+#include "sessionmanager.h"
+#include "tester.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+extern chart *Chart;
+
+class tSessionTest : public tParserTest
+{
+  CPPUNIT_TEST_SUITE(tSessionTest);
+  CPPUNIT_TEST(test_interleaved);
+  CPPUNIT_TEST(test_end_inactive);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  string _input_a, _input_b;
+
+  /** The errors and the printed results of session \a id */
+  vector<string> results(int id)
+  {
+    SessionManager &sm = SessionManager::getManager();
+    vector<string> res;
+    for(int i = 0; i < sm.errors(id); ++i)
+      res.push_back(sm.get_error(id, i));
+    for(int i = 0; i < sm.results(id); ++i)
+      res.push_back(sm.get_result(id, i, "fs-readable"));
+    return res;
+  }
+
+  /** The results of parsing \a input in a session of its own, which must
+   *  have readings
+   */
+  vector<string> parse_alone(const string &input)
+  {
+    SessionManager &sm = SessionManager::getManager();
+    int id = sm.start_parse(input);
+    sm.run_parser(id);
+    CPPUNIT_ASSERT(sm.errors(id) == 0);
+    CPPUNIT_ASSERT(sm.results(id) > 0);
+    vector<string> res = results(id);
+    sm.end_parse(id);
+    return res;
+  }
+
+public:
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started before each test.
+   */
+  void setUp()
+  {
+    tParserTest::setUp();
+    // two different inputs from the words of the grammar's lexicon
+    vector<string> words = lexicon_words(2);
+    CPPUNIT_ASSERT(words.size() == 2);
+    _input_a = words[0] + " " + words[1];
+    _input_b = words[1] + " " + words[0] + " " + words[1];
+  }
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started after each test.
+   */
+  void tearDown()
+  {
+    tParserTest::tearDown();
+  }
+
+  /** The results of two sessions that are parsed one after the other are
+   *  the same as if each had been parsed alone.
+   */
+  void test_interleaved()
+  {
+    vector<string> alone_a = parse_alone(_input_a);
+    vector<string> alone_b = parse_alone(_input_b);
+
+    SessionManager &sm = SessionManager::getManager();
+    int a = sm.start_parse(_input_a);
+    int b = sm.start_parse(_input_b);
+    sm.run_parser(a);
+    sm.run_parser(b);
+    CPPUNIT_ASSERT(results(a) == alone_a);
+    CPPUNIT_ASSERT(results(b) == alone_b);
+    CPPUNIT_ASSERT(results(a) == alone_a);
+    sm.end_parse(a);
+    sm.end_parse(b);
+  }
+
+  /** Ending a session does not change the state of the active one */
+  void test_end_inactive()
+  {
+    vector<string> alone_b = parse_alone(_input_b);
+
+    SessionManager &sm = SessionManager::getManager();
+    int a = sm.start_parse(_input_a);
+    int b = sm.start_parse(_input_b);
+    sm.run_parser(a);
+    sm.run_parser(b);
+    chart *chart_b = Chart;
+    CPPUNIT_ASSERT(chart_b != NULL);
+    CPPUNIT_ASSERT(sm.end_parse(a) == NO_ERRORS);
+    CPPUNIT_ASSERT(Chart == chart_b);
+    CPPUNIT_ASSERT(results(b) == alone_b);
+    sm.end_parse(b);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(tSessionTest);
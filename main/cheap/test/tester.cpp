@@ -6,9 +6,22 @@
 /* main module (unit test driver) */
 
 #include "pet-config.h"
+#include "chart.h"
+#include "configs.h"
+#include "errors.h"
 #include "grammar.h"
 #include "grammar-dump.h"
+#include "item.h"
+#include "lexicon.h"
+#include "lexparser.h"
+#include "lingo-tokenizer.h"
+#include "morph.h"
+#include "options.h"
+#include "parse.h"
+#include "parsenodes.h"
 #include "settings.h"
+#include "dagprinter.h"
+#include "tester.h"
 
 #include <cppunit/extensions/TestFactoryRegistry.h>
 #include <cppunit/TestResult.h>
@@ -17,19 +30,104 @@
 #include <cppunit/BriefTestProgressListener.h>
 #include <cppunit/CompilerOutputter.h>
 
+#include <list>
+#include <ostream>
 #include <string>
+#include <vector>
 
+using std::list;
 using std::string;
+using std::ostream;
+using std::vector;
 
 // required global settings from cheap.cpp
 const char * version_string = VERSION ;
 FILE* ferr = stderr;
 FILE* fstatus = stderr;
 FILE* flog = NULL;
+int verbosity = 0;
 bool XMLServices = false;
 tGrammar *Grammar;
+ParseNodes pn;
 settings *cheap_settings;
 
+extern int opt_nsolutions, opt_packing;
+extern bool opt_best_first;
+extern unsigned int opt_gplevel;
+
+// the SessionManager prints its results with this; the tests only need the
+// readable feature structure
+void print_result_as(string format, tItem *reading, ostream &out) {
+  ReadableDagPrinter rfpr;
+  rfpr.print(out, reading->get_fs().dag());
+}
+
+tTestSM::tTestSM() : tSM(Grammar, "/dev/null", "") {}
+
+double
+tTestSM::score(const tSMFeature &f) {
+  return ((f.hash() & 1023) - 512) / 256.0;
+}
+
+void
+tParserTest::setUp() {
+  _grammar_sm = Grammar->sm();
+  _grammar_gplevel = opt_gplevel;
+  _nsolutions = opt_nsolutions;
+  _packing = opt_packing;
+  _best_first = opt_best_first;
+}
+
+void
+tParserTest::tearDown() {
+  Grammar->sm(_grammar_sm);
+  opt_gplevel = _grammar_gplevel;
+  opt_nsolutions = _nsolutions;
+  opt_packing = _packing;
+  opt_best_first = _best_first;
+}
+
+void
+tParserTest::parse(const string &input, chart *&C, fs_alloc_state &FSAS) {
+  list<tError> errors;
+  try {
+    analyze(input, C, FSAS, errors, 0);
+  }
+  catch(tError &e) {
+    CPPUNIT_FAIL("can not parse `" + input + "': " + e.getMessage());
+  }
+  CPPUNIT_ASSERT_MESSAGE("errors in `" + input + "'", errors.empty());
+  CPPUNIT_ASSERT_MESSAGE("no readings for `" + input + "'",
+                         !C->readings().empty());
+}
+
+vector<string>
+lexicon_words(size_t n) {
+  vector<string> words;
+  for(type_t t = 0; t < nstatictypes && (n == 0 || words.size() < n); ++t) {
+    lex_stem *stem = Grammar->find_stem(t);
+    if(stem != NULL) words.push_back(stem->orth(0));
+  }
+  return words;
+}
+
+/** The options of cheap's main module that the grammar and the parser read */
+static void init_tester_options() {
+  managed_opt("opt_tsdb",
+    "enable [incr tsdb()] slave mode (protocol version = n)",
+    0);
+  managed_opt("opt_preprocess_only",
+    "just tokenize input, output tokens as <format> (string, YY, FSC)",
+    string());
+  managed_opt("opt_yy",
+    "lovingly designed and (once) valuable code from the YY Software "
+    "Corporation",
+    false);
+  managed_opt("opt_mrs",
+    "determines if and which kind of MRS output is generated",
+    string());
+}
+
 int
 main(int argc, char **argv)
 {
@@ -44,10 +142,21 @@ main(int argc, char **argv)
     return 3;
   }
   string gramname = raw_name(grampath.c_str());
+  init_tester_options();
+  // pack as with cheap -packing; grammars without a packing restrictor
+  // switch it off again while loading
+  set_opt("opt_packing", (int)(PACKING_EQUI | PACKING_PRO |
+                               PACKING_RETRO | PACKING_SELUNPACK));
   cheap_settings = new settings(gramname.c_str(), grampath.c_str(), "reading");
   Grammar = new tGrammar(grampath.c_str());
   fprintf(stderr, "\n");
 
+  // set up a minimal input chain for the tests that parse
+  Lexparser.init();
+  Lexparser.register_morphology(new tNullMorphology());
+  Lexparser.register_lexicon(new tInternalLexicon());
+  Lexparser.register_tokenizer(new tLingoTokenizer());
+
   // create and setup unit testing objects:
   CppUnit::TestResultCollector result;
   CppUnit::CompilerOutputter outputter(&result, std::cerr);
@@ -0,0 +1,80 @@
+/* -*- Mode: C++ -*- */
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file tester.h
+ * Helpers that are shared by the unit tests.
+ */
+
+#ifndef _TESTER_H_
+#define _TESTER_H_
+
+#include "fs.h"
+#include "sm.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+class chart;
+
+/** A model with an arbitrary, but fixed weight between -2 and 2 for every
+ *  feature, so that the scores of the readings depend on their context.
+ */
+class tTestSM : public tSM {
+public:
+  tTestSM();
+
+  virtual double score(const tSMFeature &f);
+  virtual double neutralScore() { return 0.0; }
+  virtual double combineScores(double a, double b) { return a + b; }
+  virtual std::string description() { return "test model"; }
+};
+
+/** The base of the tests that parse. setUp() saves the parse selection
+ *  model of the grammar and the options that the tests change, tearDown()
+ *  restores them.
+ */
+class tParserTest : public CppUnit::TestFixture {
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+protected:
+  /** Parse \a input into \a C. An input that can not be analyzed or that
+   *  has no readings fails the test, so that a grammar that does not cover
+   *  the test inputs can not make a test pass without checking anything.
+   */
+  void parse(const std::string &input, chart *&C, fs_alloc_state &FSAS);
+
+  tSM *_grammar_sm;
+  unsigned int _grammar_gplevel;
+
+private:
+  int _nsolutions, _packing;
+  bool _best_first;
+};
+
+/** The first \a n words of the grammar's lexicon, or all of them if \a n is
+ *  zero, to build test inputs from
+ */
+std::vector<std::string> lexicon_words(std::size_t n = 0);
+
+#endif
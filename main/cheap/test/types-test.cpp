@@ -26,6 +26,11 @@
 #include <unistd.h>
 #include "types.h"
 #include "grammar.h"
+#include "bitcode.h"
+#include "list-int.h"
+
+#include <algorithm>
+#include <vector>
 
 using namespace std;
 
@@ -33,10 +38,128 @@ class tTypesTest : public CppUnit::TestFixture
 {
   CPPUNIT_TEST_SUITE(tTypesTest);
   CPPUNIT_TEST(test_dyntypes);
+  CPPUNIT_TEST(test_bitcodes);
   CPPUNIT_TEST_SUITE_END();
   
 private:
-  
+  /** A plain bit vector to check bitcodes against */
+  typedef std::vector<bool> tBits;
+
+  unsigned int _seed;
+
+  /** A fixed sequence of pseudo random numbers below \a n */
+  int next_random(int n)
+  {
+    _seed = _seed * 1103515245 + 12345;
+    return (_seed >> 16) % n;
+  }
+
+  /** Set random bits of \a code and \a bits in a random range of words,
+   *  and clear some again, so that the zone may have zero words at either
+   *  end.
+   */
+  void random_bits(bitcode &code, tBits &bits)
+  {
+    int n = bits.size();
+    int words = n / 64 + 1;
+    int lo = next_random(words) * 64, hi = (next_random(words) + 1) * 64;
+    if(lo > hi) std::swap(lo, hi);
+    if(hi > n) hi = n;
+    for(int i = lo; i < hi; ++i) {
+      // sometimes the bits right at a word boundary, sometimes dense words
+      if((i % 64 == 0 || i % 64 == 63) ? next_random(2) : next_random(8) == 0) {
+        code.insert(i);
+        bits[i] = true;
+      }
+    }
+    for(int k = next_random(4); k > 0 && lo < hi; --k) {
+      int i = lo + next_random(hi - lo);
+      code.del(i);
+      bits[i] = false;
+    }
+  }
+
+  /** Check that \a code has exactly the bits of \a bits */
+  void check_bits(bitcode &code, const tBits &bits)
+  {
+    CPPUNIT_ASSERT(code.size() == (int) bits.size());
+    bool empty = true;
+    for(size_t i = 0; i < bits.size(); ++i) {
+      CPPUNIT_ASSERT(code.member(i) == bits[i]);
+      if(bits[i]) empty = false;
+    }
+    CPPUNIT_ASSERT(code.empty() == empty);
+
+    tBits elements(bits.size(), false);
+    list_int *l = code.get_elements();
+    for(list_int *it = l; it != NULL; it = rest(it)) {
+      CPPUNIT_ASSERT(!elements[first(it)]);
+      elements[first(it)] = true;
+    }
+    free_list(l);
+    CPPUNIT_ASSERT(elements == bits);
+  }
+
+  /** The order of bitcodes: the first word where they differ decides, as a
+   *  number, i.e., by the highest bit in which they differ there.
+   *  \return -1, 0 or 1
+   */
+  int compare_bits(const tBits &a, const tBits &b)
+  {
+    int words = a.size() / 64 + 1;
+    for(int w = 0; w < words; ++w)
+      for(int i = w * 64 + 63; i >= w * 64; --i)
+        if(i < (int) a.size() && a[i] != b[i])
+          return a[i] ? 1 : -1;
+    return 0;
+  }
+
+  /** Compare all operations on \a a and \a b with their plain bit vectors
+   *  \a abits and \a bbits.
+   */
+  void check_pair(const bitcode &a, const tBits &abits,
+                  const bitcode &b, const tBits &bbits)
+  {
+    int n = abits.size();
+    bool sub = true, super = true, disjoint = true;
+    tBits orbits(abits), andbits(abits);
+    for(int i = 0; i < n; ++i) {
+      if(abits[i] && !bbits[i]) sub = false;
+      if(bbits[i] && !abits[i]) super = false;
+      if(abits[i] && bbits[i]) disjoint = false;
+      orbits[i] = abits[i] || bbits[i];
+      andbits[i] = abits[i] && bbits[i];
+    }
+
+    bitcode c(a);
+    CPPUNIT_ASSERT(c.subset(b) == sub);
+    bool forward, backward;
+    subset_bidir(a, b, forward, backward);
+    CPPUNIT_ASSERT(forward == sub && backward == super);
+
+    int cmp = compare_bits(abits, bbits);
+    CPPUNIT_ASSERT((a == b) == (cmp == 0));
+    CPPUNIT_ASSERT((a < b) == (cmp < 0));
+    CPPUNIT_ASSERT((a > b) == (cmp > 0));
+    if(cmp == 0)
+      CPPUNIT_ASSERT(Hash(a) == Hash(b));
+
+    // a result bitcode with stale bits of its own
+    bitcode result(n);
+    tBits stale(n, false);
+    random_bits(result, stale);
+    CPPUNIT_ASSERT(intersect_empty(a, b, &result) == disjoint);
+    check_bits(result, andbits);
+
+    c |= b;
+    check_bits(c, orbits);
+    c = a;
+    c &= b;
+    check_bits(c, andbits);
+    c.find_relevant_parts();
+    check_bits(c, andbits);
+  }
+
 public:
   /**
    * Inherited from CppUnit::TestFixture .
@@ -119,6 +242,51 @@ public:
     type_t t3 = retrieve_string_instance(i);
     CPPUNIT_ASSERT(lookup_type("\"42\"") == t3);
   }
+
+  /** Random bitcodes of sizes around the word boundaries and with zones in
+   *  all places behave like plain bit vectors.
+   */
+  void test_bitcodes()
+  {
+    const int sizes[] = { 1, 63, 64, 65, 127, 128, 200, 640 };
+    _seed = 4711;
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(int); ++s) {
+      int n = sizes[s];
+      // the hash of a bitcode is that of its lowest bit
+      std::vector<int> hashes(n);
+      for(int i = 0; i < n; ++i) {
+        bitcode single(n);
+        single.insert(i);
+        hashes[i] = Hash(single);
+        for(int j = 0; j < i; ++j)
+          CPPUNIT_ASSERT(hashes[j] != hashes[i]);
+      }
+
+      for(int round = 0; round < 200; ++round) {
+        bitcode a(n), b(n);
+        tBits abits(n, false), bbits(n, false);
+        random_bits(a, abits);
+        // some pairs are equal or overlap a lot
+        switch(next_random(4)) {
+        case 0: b = a; bbits = abits; break;
+        case 1: b = a; bbits = abits; random_bits(b, bbits); break;
+        default: random_bits(b, bbits); break;
+        }
+        check_bits(a, abits);
+        check_bits(b, bbits);
+        for(int i = 0; i < n; ++i)
+          if(abits[i]) {
+            CPPUNIT_ASSERT(Hash(a) == hashes[i]);
+            break;
+          }
+        check_pair(a, abits, b, bbits);
+        check_pair(b, bbits, a, abits);
+
+        a.clear();
+        check_bits(a, tBits(n, false));
+      }
+    }
+  }
     
 };
 
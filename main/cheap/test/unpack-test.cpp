@@ -0,0 +1,116 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file unpack-test.cpp
+ * Unit tests for selective unpacking.
+ */
+
+#include "pet-config.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "chart.h"
+#include "fs.h"
+#include "grammar.h"
+#include "item.h"
+#include "sm.h"
+#include "tester.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+extern tGrammar* Grammar;
+extern unsigned int opt_gplevel;
+
+class tUnpackTest : public tParserTest
+{
+  CPPUNIT_TEST_SUITE(tUnpackTest);
+  CPPUNIT_TEST(test_unpack_twice);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  tTestSM *_sm;
+
+  /** The scores of the readings of \a C, unpacked with the test model and
+   *  grandparenting level \a gplevel
+   */
+  vector<double> unpack_readings(chart *C, unsigned int gplevel)
+  {
+    Grammar->sm(_sm);
+    opt_gplevel = gplevel;
+    item_list roots(C->readings().begin(), C->readings().end());
+    item_list results
+      = tItem::selectively_unpack(roots, 1000, C->rightmost(), 0, 0);
+    Grammar->sm(_grammar_sm);
+    opt_gplevel = _grammar_gplevel;
+
+    vector<double> scores;
+    for(item_iter it = results.begin(); it != results.end(); ++it)
+      scores.push_back((*it)->score());
+    return scores;
+  }
+
+public:
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started before each test.
+   */
+  void setUp()
+  {
+    tParserTest::setUp();
+    _sm = new tTestSM();
+  }
+
+  /**
+   * Inherited from CppUnit::TestFixture .
+   * Automatically started after each test.
+   */
+  void tearDown()
+  {
+    tParserTest::tearDown();
+    delete _sm;
+  }
+
+  /** Unpacking the readings of a chart a second time with another level of
+   *  grandparenting, as the robust PCFG fallback does, gives the same scores
+   *  as unpacking them right away with that level.
+   */
+  void test_unpack_twice()
+  {
+    // an input with many nested phrases for the test grammar
+    const string input = "x y x y x y";
+    fs_alloc_state FSAS;
+    chart *C = NULL;
+    parse(input, C, FSAS);
+    vector<double> expected = unpack_readings(C, 2);
+    CPPUNIT_ASSERT(!expected.empty());
+    delete C;
+    C = NULL;
+
+    parse(input, C, FSAS);
+    unpack_readings(C, 0);
+    CPPUNIT_ASSERT(unpack_readings(C, 2) == expected);
+    delete C;
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(tUnpackTest);
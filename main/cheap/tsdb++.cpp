@@ -34,6 +34,7 @@
 #include "settings.h"
 #include "configs.h"
 #include "logging.h"
+#include "profiler.h"
 
 #ifdef YY
 # include "yy.h"
@@ -74,10 +75,13 @@ statistics::reset()
   words = 0;
   words_pruned = 0;
   mtcpu = 0;
+  morph_cache_hits = 0;
+  morph_cache_misses = 0;
   first = -1;
   tcpu = 0;
   ftasks_fi = 0;
   ftasks_qc = 0;
+  rules_skipped = 0;
   fsubs_fi = 0;
   fsubs_qc = 0;
   etasks = 0;
@@ -124,8 +128,9 @@ statistics::print(FILE *f)
   fprintf (f,
            "id: %d\ntrees: %d\nrtrees: %d\nreadings: %d\nrreadings: %d\n"
            "words: %d\nwords_pruned: %d\n"
-           "mtcpu: %d\nfirst: %d\ntcpu: %d\nutcpu: %d\n"
-           "ftasks_fi: %d\nftasks_qc: %d\n"
+           "mtcpu: %d\nmorph_cache_hits: %d\nmorph_cache_misses: %d\n"
+           "first: %d\ntcpu: %d\nutcpu: %d\n"
+           "ftasks_fi: %d\nftasks_qc: %d\nrules_skipped: %d\n"
            "fsubs_fi: %d\nfsubs_qc: %d\n"
            "etasks: %d\nstasks: %d\n"
            "aedges: %d\npedges: %d\nupedges: %d\n"
@@ -141,8 +146,9 @@ statistics::print(FILE *f)
            "frozen: %d\nfailures: %d\nhypotheses: %d\n",
            id, trees, rtrees, readings, rreadings,
            words, words_pruned,
-           mtcpu, first, tcpu, p_utcpu,
-           ftasks_fi, ftasks_qc,
+           mtcpu, morph_cache_hits, morph_cache_misses,
+           first, tcpu, p_utcpu,
+           ftasks_fi, ftasks_qc, rules_skipped,
            fsubs_fi, fsubs_qc,
            etasks, stasks,
            aedges, pedges, p_upedges,
@@ -333,6 +339,7 @@ cheap_process_item(int i_id, const char *i_input, int parse_id,
                                   , Chart->rightmost()
                                   , treal, nderivations, T);
         T.capi_print();
+        Profiler.finish_item();
 
         delete Chart;
 
@@ -353,6 +360,7 @@ cheap_process_item(int i_id, const char *i_input, int parse_id,
         errors.push_back(e);
         cheap_tsdb_summarize_error(errors, treal, T);
         T.capi_print();
+        Profiler.finish_item();
 
     }
 
@@ -655,6 +663,7 @@ cheap_tsdb_summarize_item(chart &Chart, int length,
                 }
 
                 if(! get_opt_string("opt_mrs").empty()) {
+                  tProfilePhase phase(PHASE_MRS);
                   if ((strcmp(get_opt_string("opt_mrs").c_str(), "new") == 0) ||
                       (strcmp(get_opt_string("opt_mrs").c_str(), "simple") == 0)) {
                     fs f = (*iter)->get_fs();
@@ -960,6 +969,10 @@ void tTsdbDump::start() {
   }
 }
 
+void tTsdbDump::set_id(int id) {
+  tsdb_unique_id = id;
+}
+
 void tTsdbDump::finish(chart *Chart, const string &input) {
   if (_current != NULL) {
     _current->set_input(input);
@@ -972,10 +985,9 @@ void tTsdbDump::finish(chart *Chart, const string &input) {
 void tTsdbDump::error(class chart *Chart, const string &input,
                       const class tError & e){
   if (_current != NULL) {
-    if(Chart) {
-      _current->set_input(input);
+    _current->set_input(input);
+    if(Chart)
       _current->set_i_length(Chart->length()-1);
-    }
     list<tError> errors;
     errors.push_back(e);
     cheap_tsdb_summarize_error(errors, -1, *_current);
@@ -983,6 +995,24 @@ void tTsdbDump::error(class chart *Chart, const string &input,
   }
 }
 
+void tTsdbDump::redirect(FILE *parse, FILE *result, FILE *item) {
+  if (active()) {
+    fclose(_parse_file); fclose(_result_file); fclose(_item_file);
+    _parse_file = parse;
+    _result_file = result;
+    _item_file = item;
+  }
+}
+
+void tTsdbDump::write_rows(const string &parse, const string &result,
+                           const string &item) {
+  if (active()) {
+    fputs(parse.c_str(), _parse_file);
+    fputs(result.c_str(), _result_file);
+    fputs(item.c_str(), _item_file);
+  }
+}
+
 void tTsdbDump::dump_current() {
   if (active() && (_current != NULL)) {
     _current->file_print(_parse_file, _result_file, _item_file);
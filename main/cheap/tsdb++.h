@@ -82,6 +82,10 @@ class statistics
   int words_pruned;
   /** time for morphological processing */
   int mtcpu;
+  /** surface forms whose morphological analyses came from the cache, and
+   *  forms that had to be analyzed (cf. tMorphAnalyzer::analyze())
+   */
+  int morph_cache_hits, morph_cache_misses;
   /** time for first reading */
   int first;
   /** total cpu time */
@@ -90,6 +94,10 @@ class statistics
   int ftasks_fi;
   /** filtered tasks (by quickcheck) */
   int ftasks_qc;
+  /** rules not tried with a passive item, since the rule filter excludes
+   *  them (cf. tGrammar::filtered_rules())
+   */
+  int rules_skipped;
   /** filtered subsumptions (by rule filter) */
   int fsubs_fi;
   /** filtered subsumptions (by quickcheck) */
@@ -429,12 +437,30 @@ public:
   /** Call this method at the start of a parse */
   void start();
 
+  /** Use \a id as item and parse id of the next parse in the database,
+   *  instead of counting the parses.
+   */
+  void set_id(int id);
+
   /** Call this method at the end of a successful parse */
   void finish(class chart *Chart, const std::string &input);
 
-  /** Call this method at the end of a parse that produced an error */
+  /** Call this method at the end of a parse that produced an error.
+   *  \a Chart is \c NULL if the parse failed before it had one, \a input
+   *  is the surface string of the chart or the raw input then.
+   */
   void error(class chart *Chart, const std::string &input, const class tError &e);
 
+  /** Write the rows of subsequent items to the given files instead of the
+   *  database. The database files are closed, but their contents are left
+   *  untouched. This is used to collect the rows of a worker process.
+   */
+  void redirect(FILE *parse, FILE *result, FILE *item);
+
+  /** Append rows collected with redirect() to the database */
+  void write_rows(const std::string &parse, const std::string &result,
+                  const std::string &item);
+
 private:
   void dump_current();
   bool print_relations(std::string directory);
@@ -35,6 +35,8 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <sys/wait.h>
+#include <sys/select.h>
+#include <fcntl.h>
 #include <strings.h>
 #ifdef __SUNOS__
 #include <sys/ioctl.h>
@@ -52,6 +54,7 @@
 #include "tsdb++.h"
 #include "yy.h"
 #include "configs.h"
+#include "profiler.h"
 #ifdef HAVE_ICU
 #include "unicode.h"
 #define massageUTF8(str) Conv->convert(ConvUTF8->convert(str))
@@ -61,8 +64,16 @@
 #define massagetoUTF8(str) str
 #endif
 
+#include <cerrno>
+#include <list>
+#include <set>
+
+using namespace std;
+
 #ifdef SOCKET_INTERFACE
 
+extern FILE *ferr;
+
 //
 // socket-based server mode for cheap parser
 //
@@ -204,14 +215,291 @@ int cheap_server_initialize(int port) {
 
 } /* cheap_server_initialize() */
 
+/** Set by cheap_server_child() when a client asks the server to shut down */
+static bool _shutdown_requested = false;
+
+/** The exit status of a pool worker that saw a shutdown request */
+#define WORKER_SHUTDOWN 42
+
+/** The limits of a pool worker (see server_worker()), zero for none */
+static int _worker_max_items = 0, _worker_max_memory = 0;
+/** The number of items a pool worker served in its earlier sessions */
+static int _worker_items = 0;
+/** The dynamic memory of a pool worker when it started, in MB */
+static long long int _worker_memory = 0;
+
+static void _log_connect(struct sockaddr_in &client_address) {
+  struct hostent *host;
+
+  for(list<FILE *>::iterator log = _log_channels.begin();
+      log != _log_channels.end();
+      ++log) {
+    if((host = gethostbyaddr((char *)&client_address.sin_addr.s_addr,
+                             4, AF_INET)) != NULL
+       && host->h_name != NULL) {
+      fprintf(*log,
+              "[%d] server(): connect from `%s' (%s).\n",
+              getpid(), host->h_name, current_time().c_str());
+    } /* if */
+    else {
+      char *address = inet_ntoa(client_address.sin_addr);
+      fprintf(*log,
+              "[%d] server(): connect from `%s' (%s) .\n",
+              getpid(),
+              (address != NULL ? address : "?.?.?.?"),
+              current_time().c_str());
+    } /* else */
+    fflush(*log);
+  } /* for */
+} /* _log_connect() */
+
+/** Wait for the next client on \a server, return its socket or -1. */
+static int server_accept(int server) {
+
+  int client;
+  unsigned int n;
+  struct sockaddr_in client_address;
+  struct linger linger;
+
+#if defined(__CYGWIN__)
+#  define socklen_t int
+#endif
+
+  n = sizeof(client_address);
+  if((client = accept(server,
+                      (struct sockaddr *)&client_address,
+                      (socklen_t *)&n)) < 0) {
+
+    // a sibling in the worker pool was faster
+    if(errno == EAGAIN || errno == EWOULDBLOCK) return -1;
+
+    for(list<FILE *>::iterator log = _log_channels.begin();
+        log != _log_channels.end();
+        ++log) {
+      fprintf(*log,
+              "[%d] server(): failed (invalid) accept(2) [%d].\n",
+              getpid(), errno);
+      fflush(*log);
+    } /* for */
+    return -1;
+  } /* if */
+
+  _log_connect(client_address);
+
+  n = 1;
+  setsockopt(client, SOL_SOCKET, SO_KEEPALIVE, (char *)&n, sizeof(n));
+  setsockopt(client, SOL_SOCKET, SO_REUSEADDR, (char *)&n, sizeof(n));
+  linger.l_onoff = 1;
+  linger.l_linger = 2;
+  setsockopt(client, SOL_SOCKET, SO_LINGER,
+             (char *)&linger, sizeof(linger));
+
+  return client;
+} /* server_accept() */
+
+static long long int server_memory_mb() {
+  return p_alloc.max_usage_mb() + t_alloc.max_usage_mb();
+} /* server_memory_mb() */
+
+//
+// return the limit that a pool worker has reached after \a nitems items of
+// its current session, or NULL; outside of the worker pool there are none.
+//
+static const char *server_worker_exhausted(int nitems) {
+  if(_worker_max_items > 0 && _worker_items + nitems >= _worker_max_items)
+    return "item limit";
+  if(_worker_max_memory > 0
+     && server_memory_mb() - _worker_memory >= _worker_max_memory)
+    return "memory limit";
+  return NULL;
+} /* server_worker_exhausted() */
+
+//
+// log the throughput of a pool worker so far: \a nclients sessions with
+// \a busy seconds spent in them.
+//
+static void server_worker_summary(FILE *log, int nclients, double busy) {
+  fprintf(log,
+          "%d client(s), %d item(s); %.1fs busy (%.2f items/s) "
+          "<%lldM> (%s).\n",
+          nclients, _worker_items, busy,
+          (busy > 0.0 ? _worker_items / busy : 0.0),
+          server_memory_mb() - _worker_memory, current_time().c_str());
+  fflush(log);
+} /* server_worker_summary() */
+
+//
+// a pool worker serves clients one after the other, all of them accepted from
+// the listening socket shared with its siblings; the grammar, the type and
+// lexicon caches and the morphology cache stay warm between clients.  after
+// -server-items items or -server-memory megabytes of growth the worker exits
+// and is replaced by a fresh copy of the parent, which gives back whatever
+// memory the parses left behind.  the throughput so far is logged after
+// every session.  the limits are checked after every item: a worker that
+// reaches one closes the session once its reply to the item is complete,
+// and the client has to connect again.  SIGTERM from the parent
+// (see server_pool()) ends a worker only while it waits for a client; during
+// a session, it is held back until the session is over.
+//
+static void server_worker(int server) {
+
+  _worker_max_items = get_opt_int("opt_server_items");
+  _worker_max_memory = get_opt_int("opt_server_memory");
+  _worker_memory = server_memory_mb();
+  _worker_items = 0;
+  int nclients = 0;
+  double busy = 0.0;
+  struct timeval tstart, tend;
+  const char *reason = NULL;
+
+  sigset_t term, waiting;
+  sigemptyset(&term);
+  sigaddset(&term, SIGTERM);
+  sigprocmask(SIG_BLOCK, &term, &waiting);
+  sigdelset(&waiting, SIGTERM);
+
+  while(reason == NULL) {
+    // wait for a client with SIGTERM let through, accept it without
+    fd_set ready;
+    FD_ZERO(&ready);
+    FD_SET(server, &ready);
+    if(pselect(server + 1, &ready, NULL, NULL, NULL, &waiting) <= 0)
+      continue;
+    int client = server_accept(server);
+    if(client < 0) continue;
+    // the listening socket does not block, the sessions do
+    fcntl(client, F_SETFL, fcntl(client, F_GETFL) & ~O_NONBLOCK);
+
+    gettimeofday(&tstart, NULL);
+    int nitems = cheap_server_child(client);
+    gettimeofday(&tend, NULL);
+    double elapsed = (tend.tv_sec - tstart.tv_sec)
+      + (tend.tv_usec - tstart.tv_usec) / (double) MICROSECS_PER_SEC;
+    _worker_items += nitems;
+    busy += elapsed;
+    ++nclients;
+
+    for(list<FILE *>::iterator log = _log_channels.begin();
+        log != _log_channels.end();
+        ++log) {
+      fprintf(*log,
+              "[%d] server_worker(): client # %d: %d item(s) in %.1fs; ",
+              getpid(), nclients, nitems, elapsed);
+      server_worker_summary(*log, nclients, busy);
+    } /* for */
+
+    if(_shutdown_requested)
+      reason = "shutdown";
+    else
+      reason = server_worker_exhausted(0);
+  } /* while */
+
+  for(list<FILE *>::iterator log = _log_channels.begin();
+      log != _log_channels.end();
+      ++log) {
+    fprintf(*log, "[%d] server_worker(): %s after ", getpid(), reason);
+    server_worker_summary(*log, nclients, busy);
+  } /* for */
+
+  _exit(_shutdown_requested ? WORKER_SHUTDOWN : 0);
+} /* server_worker() */
+
+static pid_t start_server_worker(int server) {
+
+  fflush(NULL);
+  pid_t child = fork();
+  if(child < 0) {
+    throw tError("server(): unable to fork(2) worker.");
+  } /* if */
+  if(child == 0) {
+    try {
+      server_worker(server);
+    } /* try */
+    catch(tError &e) {
+      for(list<FILE *>::iterator log = _log_channels.begin();
+          log != _log_channels.end();
+          ++log) {
+        fprintf(*log, "[%d] server_worker(): error `%s'.\n",
+                getpid(), e.getMessage().c_str());
+        fflush(*log);
+      } /* for */
+    } /* catch */
+    // skip destructors and exit handlers, they belong to the parent
+    _exit(-1);
+  } /* if */
+
+  for(list<FILE *>::iterator log = _log_channels.begin();
+      log != _log_channels.end();
+      ++log) {
+    fprintf(*log, "[%d] server(): started worker # %d.\n", getpid(), child);
+    fflush(*log);
+  } /* for */
+  return child;
+} /* start_server_worker() */
+
+//
+// pre-fork a pool of warm workers on the listening socket and keep it at
+// strength until one of them reports a shutdown request from a client.  the
+// other workers are then asked to stop, and the ones in a session finish it.
+//
+static void server_pool(int server, int nworkers) {
+
+  // all workers wait for the next client; the ones that lose the race for it
+  // must not block in accept(2), where they could not be stopped
+  fcntl(server, F_SETFL, fcntl(server, F_GETFL) | O_NONBLOCK);
+
+  set<pid_t> workers;
+  for(int i = 0; i < nworkers; ++i)
+    workers.insert(start_server_worker(server));
+
+  while(!workers.empty()) {
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if(pid < 0) {
+      if(errno == EINTR) continue;
+      break;
+    } /* if */
+    if(workers.erase(pid) == 0) continue;
+
+    for(list<FILE *>::iterator log = _log_channels.begin();
+        log != _log_channels.end();
+        ++log) {
+      if(WIFEXITED(status))
+        fprintf(*log,
+                "[%d] server(): relieved worker # %d (exit: %d).\n",
+                getpid(), pid, WEXITSTATUS(status));
+      else if(WIFSIGNALED(status))
+        fprintf(*log,
+                "[%d] server(): relieved worker # %d (signal: %d).\n",
+                getpid(), pid, WTERMSIG(status));
+      fflush(*log);
+    } /* for */
+
+    if(WIFEXITED(status) && WEXITSTATUS(status) == WORKER_SHUTDOWN) {
+      // idle workers stop right away, busy ones once their client is done
+      // (see server_worker()); wait for all of them before returning
+      for(set<pid_t>::iterator it = workers.begin();
+          it != workers.end(); ++it)
+        kill(*it, SIGTERM);
+      while(!workers.empty()) {
+        pid = waitpid(-1, &status, 0);
+        if(pid < 0 && errno != EINTR) break;
+        if(pid > 0) workers.erase(pid);
+      } /* while */
+      break;
+    } /* if */
+
+    workers.insert(start_server_worker(server));
+  } /* while */
+} /* server_pool() */
+
 void cheap_server(int port) {
 
   int server, client;
 
   unsigned int n;
-  struct sockaddr_in server_address, client_address;
+  struct sockaddr_in server_address;
   struct linger linger;
-  struct hostent *host;
 
   if((server = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
     throw tError("unable to create server socket.");
@@ -243,58 +531,18 @@ void cheap_server(int port) {
 
   listen(server, SOMAXCONN);
 
-#if defined(__CYGWIN__)
-#  define socklen_t int
-#endif
+  int nworkers = get_opt_int("opt_jobs");
+  if(nworkers > 1) {
+    server_pool(server, nworkers);
+    close(server);
+    return;
+  } /* if */
 
   while(true) {
-    n = sizeof(client_address);
-    if((client = accept(server,
-                        (struct sockaddr *)&client_address,
-                        (socklen_t *)&n)) < 0) {
-
-      for(list<FILE *>::iterator log = _log_channels.begin();
-          log != _log_channels.end();
-          ++log) {
-        fprintf(*log,
-                "[%d] server(): failed (invalid) accept(2) [%d].\n",
-                getpid(), errno);
-        fflush(*log);
-      } /* for */
-      continue;
-    } /* if */
-
-    for(list<FILE *>::iterator log = _log_channels.begin();
-        log != _log_channels.end();
-        ++log) {
-      if((host = gethostbyaddr((char *)&client_address.sin_addr.s_addr,
-                               4, AF_INET)) != NULL
-         && host->h_name != NULL) {
-        fprintf(*log,
-                "[%d] server(): connect from `%s' (%s).\n",
-                getpid(), host->h_name, current_time().c_str());
-      } /* if */
-      else {
-        char *address = inet_ntoa(client_address.sin_addr);
-        fprintf(*log,
-                "[%d] server(): connect from `%s' (%s) .\n",
-                getpid(),
-                (address != NULL ? address : "?.?.?.?"),
-                current_time().c_str());
-      } /* else */
-      fflush(*log);
-    } /* for */
-
-    n = 1;
-    setsockopt(client, SOL_SOCKET, SO_KEEPALIVE, (char *)&n, sizeof(n));
-    setsockopt(client, SOL_SOCKET, SO_REUSEADDR, (char *)&n, sizeof(n));
-    linger.l_onoff = 1;
-    linger.l_linger = 2;
-    setsockopt(client, SOL_SOCKET, SO_LINGER,
-               (char *)&linger, sizeof(linger));
+    if((client = server_accept(server)) < 0) continue;
 
 #if defined(NOFORK)
-    if(!cheap_server_child(client)) {
+    if(!cheap_server_child(client) || _shutdown_requested) {
       close(client);
       break;
     } /* if */
@@ -373,9 +621,10 @@ int cheap_server_child(int socket) {
                   getpid(), current_time().c_str());
           fflush(*log);
         } /* for */
+        _shutdown_requested = true;
         fclose(stream);
         close(socket);
-        return 0;
+        return --ntsdbitems;
       } /* if */
 
       string foo = massageUTF8(string(input));
@@ -524,10 +773,28 @@ int cheap_server_child(int socket) {
     } /* else */
 
     if(!kaerb) socket_write(socket, "\f");
+    Profiler.finish_item();
 
     if(tsdbitem != 0) delete[] tsdbitem; tsdbitem = 0;
     if(Chart != 0) delete Chart; Chart = 0;
 
+    //
+    // a pool worker that is used up closes the session between two items,
+    // once the client has the complete reply to the last one.
+    //
+    const char *reason;
+    if(!kaerb && (reason = server_worker_exhausted(ntsdbitems)) != NULL) {
+      for(list<FILE *>::iterator log = _log_channels.begin();
+          log != _log_channels.end();
+          ++log) {
+        fprintf(*log,
+                "[%d] server_child(): %s, closing the session (%s).\n",
+                getpid(), reason, current_time().c_str());
+        fflush(*log);
+      } /* for */
+      kaerb = true;
+    } /* if */
+
   } /* for */
 
   fclose(stream);
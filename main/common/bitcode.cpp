@@ -31,6 +31,7 @@ bitcode::bitcode(int n)
 
   V = new CODEWORD[i];
   stop = V + i;
+  first_set = i; last_set = -1;
 
   while (i--) V[i]=0;
 }
@@ -42,6 +43,7 @@ bitcode::bitcode(const bitcode& b)
 
   V = new CODEWORD[n];
   stop = V + n;
+  first_set = b.first_set; last_set = b.last_set;
 
   while (n--) V[n] = b.V[n];
 }
@@ -59,46 +61,35 @@ bitcode& bitcode::operator=(const bitcode& b)
     }
 
   for(CODEWORD *p = V, *q = b.V; p < end(); ++p, ++q) *p = *q;
+  first_set = b.first_set; last_set = b.last_set;
 
   return *this;
 }
 
-#ifdef ZONING
 void bitcode::find_relevant_parts()
 {
-  first_set = last_set = -1;
-  for(CODEWORD *p = V; p < end() && last_set == -1; ++p)
-  {
-    if(first_set == -1)
-    {
-      if(*p != 0)
-        first_set = p - V;
-    }
-    else if(last_set == -1)
+  int n = stop - V;
+  if(first_set < 0) first_set = 0;
+  if(last_set >= n) last_set = n - 1;
+  while(first_set <= last_set && V[first_set] == 0) ++first_set;
+  while(last_set >= first_set && V[last_set] == 0) --last_set;
+  if(first_set > last_set)
     {
-       if(*p == 0)
-         last_set = p - V;
+      first_set = n; last_set = -1; // no bit set
     }
-  }
-
-  if(first_set == -1)
-    first_set = last_set = 0; // no bit set
-  if(last_set == -1)
-    last_set = stop - V;
 }
-#endif
 
 list_int *bitcode::get_elements()
 {
   // collect the positions of all bits that are 1 into the result list
-  CODEWORD *p, w;
+  CODEWORD w;
   int i;
   list_int *l = 0;
 
-  for(p = V, i = 0; p < end(); ++p, ++i)
-    if(*p)
+  for(i = first_set; i <= last_set; ++i)
+    if(V[i])
       {
-        w = *p;
+        w = V[i];
 
         for(int j = 0; j < SIZE_OF_WORD; ++j)
           {
@@ -117,14 +108,16 @@ subset_bidir(const bitcode&A, const bitcode &B, bool &a, bool &b)
     // postcondition: a == subset(A, B) && b == subset(B, A)
 
     assert(A.sz == B.sz);
-    CODEWORD *cA, *cB;
     a = b = true;
 
-    for(cA = A.V, cB = B.V; cA < A.end(); ++cA, ++cB)
+    // outside of both zones, all words are zero
+    int lo = A.first_set < B.first_set ? A.first_set : B.first_set;
+    int hi = A.last_set > B.last_set ? A.last_set : B.last_set;
+    for(int w = lo; w <= hi; ++w)
     {
-        CODEWORD join = *cA & *cB;
-        if(join != *cA) a = false;
-        if(join != *cB) b = false;
+        CODEWORD join = A.V[w] & B.V[w];
+        if(join != A.V[w]) a = false;
+        if(join != B.V[w]) b = false;
 
         if(a == false && b == false)
             return;
@@ -133,36 +126,65 @@ subset_bidir(const bitcode&A, const bitcode &B, bool &a, bool &b)
 
 bool intersect_empty(const bitcode &A, const bitcode &B, bitcode *C)
 {
-  CODEWORD *p, *q, *s;
-  bool empty;
+  // the intersection can only be nonzero where the zones of A and B overlap
+  int lo = A.first_set > B.first_set ? A.first_set : B.first_set;
+  int hi = A.last_set < B.last_set ? A.last_set : B.last_set;
 
-  for(p = A.V, q = B.V, s = C->V, empty = true; p < A.end(); ++p, ++q, ++s)
-    if((*s = *p & *q) != 0) empty = false;
+  for(int w = C->first_set; w <= C->last_set; ++w)
+    if(w < lo || w > hi) C->V[w] = 0;
 
-  return empty;
+  C->first_set = C->stop - C->V; C->last_set = -1;
+  for(int w = lo; w <= hi; ++w)
+    if((C->V[w] = A.V[w] & B.V[w]) != 0)
+      {
+        if(C->last_set == -1) C->first_set = w;
+        C->last_set = w;
+      }
+
+  return C->last_set == -1;
 }
 
 bool bitcode::subset(const bitcode &supposed_superset)
 {
   assert(sz == supposed_superset.sz);
-  CODEWORD *sub, *super;
 
-  for(sub = V, super = supposed_superset.V; sub < end(); ++sub, ++super)
-    if((*sub & *super) != *sub) return false;
+  // words outside of this zone are zero and hence a subset of anything
+  for(int w = first_set; w <= last_set; ++w)
+    if((V[w] & supposed_superset.V[w]) != V[w]) return false;
 
   return true;
 }
 
+/** @name 32 bit codewords
+ * The dump format stores the bitcodes as 32 bit words, the least significant
+ * bits first.
+ */
+/*@{*/
+static const int DUMP_WORDS_PER_CODEWORD = sizeof(CODEWORD) / 4;
+
+static inline int dump_words(int sz) { return 1 + sz/32; }
+
+static inline int get_dump_word(const CODEWORD *V, int i) {
+  return (int) (unsigned int) (V[i / DUMP_WORDS_PER_CODEWORD]
+                               >> (32 * (i % DUMP_WORDS_PER_CODEWORD)));
+}
+
+static inline void set_dump_word(CODEWORD *V, int i, int w) {
+  V[i / DUMP_WORDS_PER_CODEWORD]
+    |= (CODEWORD) (unsigned int) w << (32 * (i % DUMP_WORDS_PER_CODEWORD));
+}
+/*@}*/
+
 #ifdef NAIVE_BITCODE_DUMP
 
 void bitcode::dump(dumper *f)
 {
-  short int s = 1 + sz/SIZE_OF_WORD;
+  short int s = dump_words(sz);
 
   f->dump_short(s);
 
-  for(CODEWORD *p = V; p < end(); ++p)
-    f->dump_int(*p);
+  for(int i = 0; i < s; ++i)
+    f->dump_int(get_dump_word(V, i));
 }
 
 void bitcode::undump(dumper *f)
@@ -171,30 +193,35 @@ void bitcode::undump(dumper *f)
 
   s = f->undump_short();
 
-  if(s != (1 + sz/SIZE_OF_WORD))
+  if(s != dump_words(sz))
   {
-    LOG(logAppl, WARN, "bitcode: mismatch " << s << "!=" << 1+sz/SIZE_OF_WORD);
+    LOG(logAppl, WARN, "bitcode: mismatch " << s << "!=" << dump_words(sz));
   }
 
-  for(CODEWORD *p = V; p < end(); ++p)
-    *p = f->undump_int();
+  for(CODEWORD *p = V; p < end(); ++p) *p = 0;
+  for(int i = 0; i < s && i < dump_words(sz); ++i)
+    set_dump_word(V, i, f->undump_int());
+
+  first_set = 0; last_set = stop - V - 1;
+  find_relevant_parts();
 }
 
 #else
 
 void bitcode::dump(dumper *f)
 {
-  int n = 1 + sz/SIZE_OF_WORD;
+  int n = dump_words(sz);
   int i = 0;
 
   while(i < n)
     {
-      f->dump_int(V[i]);
-      if(V[i] == 0)
+      int w = get_dump_word(V, i);
+      f->dump_int(w);
+      if(w == 0)
         {
           int j = i + 1;
 
-          while(j < n && V[j] == 0)
+          while(j < n && get_dump_word(V, j) == 0)
             ++j;
 
           f->dump_short((short int) (j - i));
@@ -211,13 +238,16 @@ void bitcode::dump(dumper *f)
 
 void bitcode::undump(dumper *f)
 {
-  int n = 1 + sz/SIZE_OF_WORD;
+  int n = dump_words(sz);
   int i = 0;
 
+  for(CODEWORD *p = V; p < end(); ++p) *p = 0;
+
   while(i < n)
     {
-      V[i] = f->undump_int();
-      if(V[i] == 0)
+      int w = f->undump_int();
+      set_dump_word(V, i, w);
+      if(w == 0)
         {
           int l = f->undump_short();
 
@@ -226,7 +256,6 @@ void bitcode::undump(dumper *f)
               ++i;
               if(i >= n)
                 throw tError("invalid compressed bitcode (too long)");
-              V[i] = 0;
             }
         }
       ++i;
@@ -234,6 +263,9 @@ void bitcode::undump(dumper *f)
 
   if( f->undump_int() != 0 || f->undump_short() != 0)
     throw tError("invalid compressed bitcode (no end marker)");
+
+  first_set = 0; last_set = stop - V - 1;
+  find_relevant_parts();
 }
 
 #endif
@@ -241,13 +273,13 @@ void bitcode::undump(dumper *f)
 int Hash(const bitcode &C)
 {
 
-  for(CODEWORD *p = C.V; p < C.end(); ++p)
-    if(*p != 0)
+  for(int w = C.first_set; w <= C.last_set; ++w)
+    if(C.V[w] != 0)
       {
         for(int j = 0; j < C.SIZE_OF_WORD ; ++j)
           {
-            if(*p & (1 << j))
-              return (p - C.V) * C.sz + j;
+            if(C.V[w] & ((CODEWORD) 1 << j))
+              return w * C.sz + j;
           }
       }
 
@@ -22,10 +22,9 @@
  * represents set of integers in the interval [ 0 .. sz [
  * performance of some operations is critical for efficient glb computation
  *
- * \todo
- * Could try a `zoning' approach here: since most bits are 0, restrict
- * operations like subtype to just the region containing 1. Need to
- * keep track of left and right limit for this. See #ifdef ZONING
+ * Since most bits of the codes in a type hierarchy are 0, every bitcode
+ * keeps track of the region of words that may contain a 1 (`zoning'), and
+ * the operations only look at this region.
  */
 
 #ifndef _BITCODE_H_
@@ -38,7 +37,7 @@
 /** \c CODEWORD should be an unsigned numeric type that fits best into a CPU
  *  register.
  */
-typedef unsigned int CODEWORD;
+typedef unsigned long long CODEWORD;
 
 /** Implementation of efficient fixed size bit vectors.
  * \attention Most functions assume that all bit vectors are of the same size.
@@ -51,18 +50,26 @@ class bitcode {
 
   inline int wordindex(int pos) const { return pos / SIZE_OF_WORD ; }
 
-  inline CODEWORD bitmask(int pos) const { return (1 << (pos % SIZE_OF_WORD));}
+  inline CODEWORD bitmask(int pos) const {
+    return ((CODEWORD) 1 << (pos % SIZE_OF_WORD));
+  }
+
+  /** Extend the zone to contain word \a w */
+  void widen(int w) {
+    if(w < first_set) first_set = w;
+    if(w > last_set) last_set = w;
+  }
 
   /** compare this bitcode and \a S2 in lexicographic order
    *  \return 0 if \a this == \a S2, -1 if \a this < \a S2
    *  , +1 if \a this < \a S2
    */
   int compare(const bitcode &S2) const {
-    CODEWORD *p, *q;
-
-    for(p = V, q = S2.V; p < end() ; ++p, ++q) {
-      if(*p != *q) {
-        if (*p < *q) return -1; else return 1;
+    int lo = first_set < S2.first_set ? first_set : S2.first_set;
+    int hi = last_set > S2.last_set ? last_set : S2.last_set;
+    for(int w = lo; w <= hi; ++w) {
+      if(V[w] != S2.V[w]) {
+        if (V[w] < S2.V[w]) return -1; else return 1;
       }
     }
     return 0;
@@ -71,26 +78,31 @@ class bitcode {
   /** Destructive bitwise OR */
   bitcode& join(const bitcode& b) {
     assert(sz == b.sz);
-    CODEWORD *p, *q;
-    for(p = V, q = b.V; p < end(); ++p, ++q) *p |= *q;
+    if(b.first_set > b.last_set) return *this;
+    for(int w = b.first_set; w <= b.last_set; ++w) V[w] |= b.V[w];
+    widen(b.first_set); widen(b.last_set);
     return *this;
   }
 
   /** Destructive bitwise AND */
   bitcode& intersect(const bitcode& b) {
     assert(sz == b.sz);
-    CODEWORD *p, *q;
-    for(p = V, q = b.V; p < end(); ++p, ++q) *p &= *q;
+    int lo = first_set > b.first_set ? first_set : b.first_set;
+    int hi = last_set < b.last_set ? last_set : b.last_set;
+    for(int w = first_set; w <= last_set; ++w)
+      if(w < lo || w > hi) V[w] = 0; else V[w] &= b.V[w];
+    first_set = lo; last_set = hi;
     return *this;
   }
 
   CODEWORD *V, *stop;
   int sz;
 
-#ifdef ZONING
-  /** Zoning is not tested. Does it work? */
+  /** The zone: all words outside of V[first_set] ... V[last_set] are zero.
+   *  The zone of a bitcode without any bits set is empty, i.e.,
+   *  first_set > last_set.
+   */
   int first_set, last_set;
-#endif
 
  public:
 
@@ -104,7 +116,7 @@ class bitcode {
   ~bitcode() { delete[] V; }
 
   /** Set bit at position \a x to one */
-  void insert(int x) { V[ wordindex(x) ] |= bitmask(x); }
+  void insert(int x) { V[ wordindex(x) ] |= bitmask(x); widen(wordindex(x)); }
 
   /** Set bit at position \a x to zero */
   void del(int x){ V[ wordindex(x) ] &= ~ bitmask(x); }
@@ -122,29 +134,30 @@ class bitcode {
 
   /** Set all bits to zero */
   void clear() {
-    register CODEWORD *p = V;
-    while (p < end()) *p++ = 0;
+    for(int w = first_set; w <= last_set; ++w) V[w] = 0;
+    first_set = stop - V; last_set = -1;
   }
 
   /** Test if the bitvector only contains zeros */
   bool empty() const {
-    for(CODEWORD *p = V; p < end(); ++p) if(*p != 0) return false;
+    for(int w = first_set; w <= last_set; ++w) if(V[w] != 0) return false;
     return true;
   }
 
-#ifdef ZONING
-  void find_relevant_parts() const; // update first_set/last_set
-#endif
+  /** Shrink the zone to the words from the first to the last nonzero word */
+  void find_relevant_parts();
 
   /** Print bitcode for debugging purposes */
   void print(FILE *f) const {
     for(CODEWORD *p = V; p < end(); ++p)
-      fprintf(f, "%.8X", *p);
+      fprintf(f, "%.16llX", *p);
   }
 
   /** @name Serialize/Deserialize bitvector.
    * The Serialization is optimized for bitvectors containing sequences of
-   * empty codewords, which are stored using a run-length encoding.
+   * empty codewords, which are stored using a run-length encoding. The
+   * codewords are written as 32 bit integers, independent of the size of
+   * \c CODEWORD.
    *
    * Plain (naive) bitcode dumping can be used by defining the symbol
    * \c NAIVE_BITCODE_DUMP, but the same method has to be used in the undumping
@@ -180,6 +193,7 @@ class bitcode {
     --p;
     *p &= (((CODEWORD) -1) >> SIZE_OF_WORD - (sz % SIZE_OF_WORD))
     */
+    first_set = 0; last_set = stop - V - 1;
     return *this;
   }
 
@@ -210,12 +224,8 @@ class bitcode {
    *  correctly.
    */
   bool operator==(const bitcode& T) const {
-    CODEWORD *p, *q;
     assert(sz == T.sz);
-    for(p = V, q = T.V; p < end(); ++p, ++q)
-      if(*p != *q) return 0;
-
-    return 1;
+    return compare(T) == 0;
   }
 
   /** A more efficient hash function for bitcodes in type hierarchies: return
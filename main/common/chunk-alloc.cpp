@@ -33,6 +33,7 @@
 
 #include "chunk-alloc.h"
 #include "errors.h"
+#include <algorithm>
 
 chunk_allocator t_alloc(CHUNK_SIZE, false);
 chunk_allocator p_alloc(CHUNK_SIZE, true);
@@ -123,6 +124,20 @@ void chunk_allocator::reset() {
   may_shrink();
 }
 
+void chunk_allocator::swap(chunk_allocator &other) {
+  if(_core_down != other._core_down)
+    throw tError("alloc: can not swap chunk allocators of different direction");
+
+  std::swap(_chunk_pos, other._chunk_pos);
+  std::swap(_chunk_size, other._chunk_size);
+  std::swap(_curr_chunk, other._curr_chunk);
+  std::swap(_nchunks, other._nchunks);
+  std::swap(_chunk, other._chunk);
+  std::swap(_max, other._max);
+  std::swap(_stats_chunk_sum, other._stats_chunk_sum);
+  std::swap(_stats_chunk_n, other._stats_chunk_n);
+}
+
 void chunk_allocator::print_check() {
   for (int i=0; i < _nchunks; ++i) {
     printf("alloc'ed: [%x %x]\n", (ptr2uint_t) _chunk[i]
@@ -338,6 +353,7 @@ int chunk_allocator::_core_free(void *p, int size) {
 
 #pragma argsused
 int chunk_allocator::_init_core(bool down, int chunksize) {
+  _core_down = down;
   _chunk_size = chunksize;
 }
 
@@ -363,6 +379,7 @@ int chunk_allocator::_core_free(void *p, int size) {
 #pragma argsused
 #endif
 void chunk_allocator::_init_core(bool down, int chunksize) {
+  _core_down = down;
   _chunk_size = chunksize;
 }
 
@@ -125,6 +125,13 @@ class chunk_allocator
   /** Release all memory and reset all statistics */
   void reset();
 
+  /** Exchange the chunks, positions and statistics of this allocator with
+   *  those of \a other. Both allocators must grow in the same direction.
+   *  This allows to keep several independent heaps of temporary memory and
+   *  to make one of them the current one without copying.
+   */
+  void swap(chunk_allocator &other);
+
   /** The maximum amount of memory (in bytes) allocated so far */
   inline long long int max_usage()
     { return _max; }
@@ -26,6 +26,9 @@
 #include "types.h"
 #include "utility.h"
 
+#include <algorithm>
+#include <climits>
+
 dag_node *new_dag(type_t s)
 {
   dag_node *dag = dag_alloc_node();
@@ -201,6 +204,50 @@ void dag_get_qc_vector(qc_node *path, dag_node *dag, type_t *qc_vector)
       dag_get_qc_vector(qarc->val, arc->val, qc_vector);
 }
 
+static void
+dag_get_path_types_rec(dag_node *dag, unsigned long long path, int depth,
+                       size_t max_paths, path_types &result)
+{
+#ifndef DAG_TOMABECHI
+  dag = dag_deref(dag);
+#endif
+
+  // a shared node and the nodes below it are listed under the first path
+  // only
+  if(dag_set_visit(dag, dag_get_visit(dag) + 1) != 1)
+    return;
+
+  result.push_back(std::make_pair(path, dag->type));
+
+  if(depth == 0)
+    return;
+
+  for(dag_arc *arc = dag->arcs; arc != 0 && result.size() < max_paths;
+      arc = arc->next)
+    dag_get_path_types_rec(arc->val, path * (nattrs + 1) + arc->attr + 1,
+                           depth - 1, max_paths, result);
+}
+
+bool dag_get_path_types(dag_node *dag, int depth, size_t max_paths,
+                        path_types &result)
+{
+  result.clear();
+
+  // the number of the longest path must fit into 64 bits
+  const unsigned long long base = nattrs + 1;
+  unsigned long long longest = 0;
+  for(int i = 0; i < depth; ++i) {
+    if(longest > (ULLONG_MAX - nattrs) / base)
+      return false;
+    longest = longest * base + nattrs;
+  }
+
+  dag_get_path_types_rec(dag, 0, depth, max_paths, result);
+  dag_invalidate_visited();
+  std::sort(result.begin(), result.end());
+  return true;
+}
+
 void dag_size_rec(dag_node *dag, int &nodes)
 {
   dag = dag_deref(dag);
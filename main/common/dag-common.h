@@ -29,6 +29,9 @@
 #include "dumper.h"
 #include "types.h"
 
+#include <utility>
+#include <vector>
+
 struct dag_node;
 
 /** A dag node pointer representing unification failure */
@@ -389,6 +392,25 @@ qc_node *dag_read_qc_paths(dumper *f, int limit, int &qc_len);
  */
 void dag_get_qc_vector(qc_node *root, dag_node *dag, type_t *qc_vector);
 
+/** The types at the paths of a dag. Every path is encoded as one number, the
+ *  list is sorted by these numbers.
+ */
+typedef std::vector< std::pair<unsigned long long, type_t> > path_types;
+
+/** Collect the types of the nodes of \a dag that can be reached by a path of
+ *  at most \a depth arcs into \a result, sorted by path.
+ *
+ * A path \f$a_1 \ldots a_n\f$ is encoded as the number with the digits
+ * \f$a_i + 1\f$ in base \c nattrs + 1, so the same path gets the same number
+ * in all dags, and the root gets zero. A node that can be reached by several
+ * paths is listed once, with the first path that reaches it, and the
+ * collection stops after \a max_paths paths.
+ * \return \c false, with an empty \a result, if the encoding of paths of
+ *         length \a depth does not fit into 64 bits.
+ */
+bool dag_get_path_types(dag_node *dag, int depth, size_t max_paths,
+                        path_types &result);
+
 /** Release the global data structures related to the quick check tree */
 void dag_qc_free();
 
@@ -21,10 +21,18 @@
  * abstracts away from low level representation (byteorder etc)
  */
 
+#include "pet-config.h"
 #include "byteorder.h"
 #include "dumper.h"
 
 #include <cstring>
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 #define DUMP_LITTLE_ENDIAN true
 
@@ -34,6 +42,8 @@ dumper::dumper(FILE *f, bool write)
 {
   _f = f;
   _buff = 0;
+  _map = 0;
+  _map_size = _map_pos = 0;
   _coe = false;
   _write = write;
   _swap = DUMP_LITTLE_ENDIAN != cpu_little_endian();
@@ -42,27 +52,85 @@ dumper::dumper(FILE *f, bool write)
 dumper::dumper(const char *fname, bool write)
 {
   _write = write;
+  _f = 0;
+  _buff = 0;
+  _map = 0;
+  _map_size = _map_pos = 0;
+  _coe = true;
+  _swap = DUMP_LITTLE_ENDIAN != cpu_little_endian();
+
+  // the undumping functions read the file in small pieces, which is much
+  // cheaper from memory than through stdio, so files that are read are
+  // mapped into memory or, without mmap(2) or if mapping fails, read in
+  // one go
+#ifdef HAVE_SYS_MMAN_H
+  if(!_write) {
+    int fd = open(fname, O_RDONLY);
+    struct stat st;
+    if(fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(p != MAP_FAILED) {
+        _map = (const char *) p;
+        _map_size = st.st_size;
+      }
+    }
+    if(fd >= 0) close(fd);
+    if(_map != 0) return;
+  }
+#endif
+
   _f = fopen(fname, _write ? "wb" : "rb");
 
   if(_f == NULL)
     throw tError("unable to open file `" + std::string(fname) + "'");
 
+  if(!_write && fseek(_f, 0, SEEK_END) == 0) {
+    long int size = ftell(_f);
+    if(size > 0) {
+      _buff = new char[size];
+      rewind(_f);
+      if(fread(_buff, 1, size, _f) == (size_t) size) {
+        fclose(_f);
+        _f = 0;
+        _map = _buff;
+        _map_size = size;
+        return;
+      }
+      delete[] _buff;
+      _buff = 0;
+    }
+    rewind(_f);
+  }
+
   _buff = new char[BUFF_SIZE];
   setvbuf(_f, _buff, _IOFBF, BUFF_SIZE);
-
-  _coe = true;
-  _swap = DUMP_LITTLE_ENDIAN != cpu_little_endian();
 }
 
 dumper::~dumper()
 {
   if(_coe)
     {
-      fclose(_f);
+#ifdef HAVE_SYS_MMAN_H
+      if(_map != 0 && _map != _buff)
+        munmap((void *) _map, _map_size);
+#endif
+      if(_f != 0)
+        fclose(_f);
       delete[] _buff;
     }
 }
 
+bool dumper::read(void *p, size_t n)
+{
+  if(_map == 0)
+    return fread(p, 1, n, _f) == n;
+  if(_map_size - _map_pos < n)
+    return false;
+  memcpy(p, _map + _map_pos, n);
+  _map_pos += n;
+  return true;
+}
+
 void dumper::dump_char(char i)
 {
   if(!_write || fwrite(&i, sizeof(i), 1, _f) != 1)
@@ -72,7 +140,7 @@ void dumper::dump_char(char i)
 char dumper::undump_char()
 {
   char i;
-  if(_write || fread(&i, sizeof(i), 1, _f) != 1)
+  if(_write || !read(&i, sizeof(i)))
     throw tError("couldn't read character from file");
   return i;
 }
@@ -87,7 +155,7 @@ void dumper::dump_short(short i)
 short dumper::undump_short()
 {
   short i;
-  if(_write || fread(&i, sizeof(i), 1, _f) != 1)
+  if(_write || !read(&i, sizeof(i)))
     throw tError("couldn't read short from file");
   if(_swap)
     return swap_short(i);
@@ -105,7 +173,7 @@ void dumper::dump_int(int i)
 int dumper::undump_int()
 {
   int i;
-  if(_write || fread(&i, sizeof(i), 1, _f) != 1)
+  if(_write || !read(&i, sizeof(i)))
     throw tError("couldn't read integer from file");
   if(_swap)
     return swap_int(i);
@@ -148,7 +216,7 @@ char *dumper::undump_string()
 
   s = new char[len];
   
-  if(s == 0 || fread(s, sizeof(char), len, _f) != (unsigned int) len)
+  if(s == 0 || !read(s, len))
     throw tError("error reading string from file");
 
   return s;
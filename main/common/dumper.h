@@ -41,7 +41,8 @@ class dumper
    */
   dumper(FILE *f, bool write = false);
   /** Create binary serializer reading or writing data to/from file with name
-   *  \a fname.
+   *  \a fname. Where possible, files that are read are mapped into memory
+   *  instead of being read through a \c FILE stream.
    * \throws tError if the file can not be opened appropriately.
    */
   dumper(const char *fname, bool write = false);
@@ -85,14 +86,31 @@ class dumper
 
   /** Return the position of the file pointer */
   inline long int tell()
-    { return ftell(_f); }
+    { return _map != 0 ? (long int) _map_pos : ftell(_f); }
   /** Set the file pointer to position \a pos */
-  inline void seek(long int pos)
-    { if(fseek(_f, pos, SEEK_SET) != 0) throw tError("cannot seek"); }
+  inline void seek(long int pos) {
+    if(_map != 0) {
+      if(pos < 0 || (size_t) pos > _map_size) throw tError("cannot seek");
+      _map_pos = pos;
+    }
+    else if(fseek(_f, pos, SEEK_SET) != 0) throw tError("cannot seek");
+  }
 
  private:
+  /** Copy the next \a n bytes of the file to \a p
+   * \return \c false if there are not enough bytes left
+   */
+  bool read(void *p, size_t n);
+
   FILE *_f;
   char *_buff;
+  /** The contents of a file that is read, either mapped into memory or
+   *  read into \c _buff as a whole, or \c NULL
+   */
+  const char *_map;
+  size_t _map_size;
+  /** The read position in \c _map */
+  size_t _map_pos;
   /** writeable? */
   bool _write;
   /** close on exit */
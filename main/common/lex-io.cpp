@@ -25,9 +25,9 @@
    - efficient arbitrary lookahead, efficient buffer access via mark()
 */
 
-/* for unix - essentially we just mmap(2) the whole file,
-   which gives both good performance (minimizes copying) and easy use
-   for windows - read the whole file
+/* where mmap(2) is available, essentially we just map the whole file,
+   which gives both good performance (minimizes copying) and easy use;
+   otherwise, or if mapping fails, read the whole file
 */
 
 #include "pet-config.h"
@@ -43,7 +43,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#ifdef HAVE_MMAP
+#ifdef HAVE_SYS_MMAN_H
 #include <sys/mman.h>
 #endif
 
@@ -55,9 +55,29 @@ lex_file *CURR;
 
 int total_lexed_lines = 0;
 
+/** Number of locations allocated at once */
+#define LOCATION_BLOCK 1024
+
+/** The list of free locations, linked through their \c fname fields */
+static struct lex_location *free_locations = NULL;
+
 struct lex_location *new_location(const char *fname, int linenr, int colnr)
 {
-  struct lex_location *loc = (struct lex_location *) malloc(sizeof(struct lex_location));
+  struct lex_location *loc;
+
+  // the lexer creates a location for every token, most of which are freed
+  // right away, so they are recycled instead of going through malloc(3)
+  if(free_locations == NULL)
+    {
+      struct lex_location *block = (struct lex_location *)
+        malloc(LOCATION_BLOCK * sizeof(struct lex_location));
+      if(block == NULL)
+        throw tError("out of memory for lexer locations");
+      for(int i = 0; i < LOCATION_BLOCK; ++i)
+        free_location(block + i);
+    }
+  loc = free_locations;
+  free_locations = (struct lex_location *) loc->fname;
 
   loc->fname = fname;
   loc->linenr = linenr;
@@ -66,6 +86,12 @@ struct lex_location *new_location(const char *fname, int linenr, int colnr)
   return loc;
 }
 
+void free_location(struct lex_location *loc)
+{
+  loc->fname = (const char *) free_locations;
+  free_locations = loc;
+}
+
 void push_file(const string &fname, const char *info) {
   lex_file f;
   struct stat statbuf;
@@ -88,24 +114,34 @@ void push_file(const string &fname, const char *info) {
 
   f.len = statbuf.st_size;
 
-#ifdef HAVE_MMAP
-  f.buff = (char *) mmap(0, f.len, PROT_READ, MAP_SHARED, f.fd, 0);
-
-  if(f.buff == (caddr_t) -1)
-    throw tError("couldn't mmap `" + fname + "': " + string(strerror(errno)));
+  f.mapped = false;
+#ifdef HAVE_SYS_MMAN_H
+  // an empty file can not be mapped, and is read like on systems without
+  // mmap(2)
+  if(f.len > 0)
+    {
+      void *p = mmap(0, f.len, PROT_READ, MAP_PRIVATE, f.fd, 0);
+      if(p != MAP_FAILED)
+        {
+          f.buff = (char *) p;
+          f.mapped = true;
+        }
+    }
+#endif
 
-#else
-  f.buff = (char *) malloc(f.len + 1);
-  if(f.buff == 0)
-    throw tError("couldn't malloc for `" + fname + "': "
-                 + string(strerror(errno)));
+  if(!f.mapped)
+    {
+      f.buff = (char *) malloc(f.len + 1);
+      if(f.buff == 0)
+        throw tError("couldn't malloc for `" + fname + "': "
+                     + string(strerror(errno)));
 
-  if((size_t) read(f.fd,f.buff,f.len) != f.len)
-    throw tError("couldn't read from `" + fname + "': "
-                 + string(strerror(errno)));
+      if((size_t) read(f.fd,f.buff,f.len) != f.len)
+        throw tError("couldn't read from `" + fname + "': "
+                     + string(strerror(errno)));
 
-  f.buff[f.len] = '\0';
-#endif
+      f.buff[f.len] = '\0';
+    }
 
   f.fname = strdup(fname.c_str());
 
@@ -130,6 +166,7 @@ void push_string(const string &input, const char *info) {
                  + string(strerror(errno)));
 
   f.len = strlen(f.buff);
+  f.mapped = false;
   f.fname = NULL;
   f.fd = -1;
   f.pos = 0;
@@ -152,22 +189,21 @@ int pop_file() {
   else
     CURR = NULL;
 
-#ifdef HAVE_MMAP
-  if(f.fname) {
+#ifdef HAVE_SYS_MMAN_H
+  if(f.mapped) {
     if(munmap(f.buff, f.len) != 0)
       throw tError("couldn't munmap `" + string(f.fname)
                    + "': " + string(strerror(errno)));
   } // if
-  else {
+  else
+#endif
+  {
     //
-    // even when mmap() is in use, includes from strings were directly copied
-    // into the input buffer.
+    // includes from strings, and files that could not be mapped, were
+    // copied into the input buffer.
     //
     free(f.buff);
   } // else
-#else
-  free(f.buff);
-#endif
 
   if(f.fname) {
     if(close(f.fd) != 0)
@@ -200,8 +236,6 @@ char *last_info = 0;
 int LConsume(int n)
 // consume lexical input
 {
-  int i;
-
   assert(n >= 0);
 
   if(CURR->pos + n > CURR->len)
@@ -226,17 +260,18 @@ int LConsume(int n)
       CURR->info = NULL;
     }
 
-  for(i = 0; i < n; ++i)
+  // count the lines with memchr(3), the column only depends on the last one
+  const char *p = CURR->buff + CURR->pos, *end = p + n, *nl;
+  while((nl = (const char *) memchr(p, '\n', end - p)) != NULL)
     {
-      CURR->colnr++;
-
-      if(CURR->buff[CURR->pos + i] == '\n')
-        {
-          CURR->colnr = 1;
-          CURR->linenr++;
-          total_lexed_lines ++;
-        }
+      CURR->linenr++;
+      total_lexed_lines ++;
+      p = nl + 1;
     }
+  if(p == CURR->buff + CURR->pos)
+    CURR->colnr += n;
+  else
+    CURR->colnr = 1 + (end - p);
 
   CURR->pos += n;
 
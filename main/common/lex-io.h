@@ -38,6 +38,8 @@ extern int total_lexed_lines;
 typedef struct 
 {
   char *buff;
+  /** \c true if \c buff is mapped, otherwise it was allocated */
+  bool mapped;
   int fd;
   size_t len;
   size_t pos;
@@ -60,6 +62,9 @@ struct lex_location
 /** Build a new location object with the given parameters. */
 struct lex_location *new_location(const char *fname, int linenr, int colnr);
 
+/** Give back a location object built by new_location() for reuse */
+void free_location(struct lex_location *loc);
+
 /** Push file \a fname onto include stack, where \a info provides a hint in
  *  which context the function is used.
  */
@@ -104,4 +109,13 @@ int LConsume(int n);
  */
 char *LMark();
 
+/** Get the end of the current file buffer, up to which tokens starting at
+ *  LMark() may be scanned directly. The buffer is not terminated by '\0'
+ *  if the file is mapped.
+ */
+inline char *LEnd()
+{
+  return CURR->buff + CURR->len;
+}
+
 #endif
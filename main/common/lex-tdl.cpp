@@ -42,21 +42,68 @@ const char *keywords[N_KEYWORDS] = { "declare", "domain", "instance", "lisp",
 
 const char *lexer_idchars = "_+-*?";
 
+/** For every byte whether it may occur in an \c id token */
+static bool idchar_table[256];
+/** The value of \c lexer_idchars that \c idchar_table was built for */
+static const char *idchar_table_chars = NULL;
+
+/** Rebuild \c idchar_table if \c lexer_idchars was changed, as it is
+ *  temporarily for reading settings files.
+ */
+static inline void update_idchar_table()
+{
+  if(idchar_table_chars == lexer_idchars) return;
+  for(int c = 0; c < 256; ++c)
+    idchar_table[c] = isalnum(c) || c > 127
+      || (c != 0 && strchr(lexer_idchars, c) != NULL);
+  idchar_table_chars = lexer_idchars;
+}
+
 int is_idchar(int c)
 {
-  return isalnum(c) || strchr(lexer_idchars, c) || c > 127 || c < 0;
+  update_idchar_table();
+  return idchar_table[(unsigned char) c];
 }
 
 int lisp_mode = 0; // shall lexer recognize lisp expressions
 
 void print_token(std::ostream &out, lex_token *t);
 
+/** Number of tokens allocated at once */
+#define TOKEN_BLOCK 64
+
+/** The list of free tokens, linked through their \c text fields. Only the
+ *  few tokens of the lookahead buffer are alive at any time, so they are
+ *  recycled instead of going through malloc(3).
+ */
+static lex_token *free_tokens = NULL;
+
+static void free_token(lex_token *t)
+{
+  if(t->text != NULL) free(t->text);
+  if(t->loc != NULL) free_location(t->loc);
+  t->text = (char *) free_tokens;
+  free_tokens = t;
+}
+
 lex_token *make_token(enum TOKEN_TAG tag, const char *s, int len,
     int rlen = -1, bool regex = false)
 {
   lex_token *t;
 
-  t = (lex_token *) malloc(sizeof(lex_token));
+  if(free_tokens == NULL)
+    {
+      lex_token *block = (lex_token *) malloc(TOKEN_BLOCK * sizeof(lex_token));
+      if(block == NULL)
+        throw tError("out of memory for lexer tokens");
+      for(int i = 0; i < TOKEN_BLOCK; ++i)
+        {
+          block[i].text = (char *) free_tokens;
+          free_tokens = block + i;
+        }
+    }
+  t = free_tokens;
+  free_tokens = (lex_token *) t->text;
 
   if(tag != T_EOF)
     {
@@ -79,7 +126,7 @@ lex_token *make_token(enum TOKEN_TAG tag, const char *s, int len,
         rlen = len;
       char *dest = t->text = (char *) malloc(rlen + 1);
       if (rlen == len)
-        strncpy(dest, s, len);
+        memcpy(dest, s, len);
       else // s contains a string with escaped characters
         {
           int j = 0;
@@ -101,6 +148,10 @@ void check_id(lex_token *t)
 {
   int i;
 
+  // all keywords are lower case words
+  if(!islower((unsigned char) t->text[0]))
+    return;
+
   for(i = 0; i< N_KEYWORDS; ++i)
     {
       if(strcmp(t->text, keywords[i]) == 0)
@@ -111,77 +162,68 @@ void check_id(lex_token *t)
     }
 }
 
-lex_token *get_next_token()
+/** Skip the whitespace and comments at the current position of the input,
+ *  scanning the file buffer directly without building tokens for them.
+ */
+static void skip_blanks()
 {
-  int c;
-  lex_token *t;
+  if(CURR == NULL) return;
 
-  c = LLA(0);
+  char *start = CURR->buff + CURR->pos, *end = LEnd(), *p = start;
 
-  if(c == EOF)
+  while(p < end)
     {
-      t = make_token(T_EOF, NULL, 0);
-    }
-  else if(isspace(c))
-    { // whitespace
-      int i;
-
-      i = 1;
-      while(isspace(LLA(i))) i++;
-
-      t = make_token(T_WS, NULL, i);
-      LConsume(i);
-    }
-  else if(c == ';')
-    { // single line comment
-      char *start;
-      int i;
-
-      start = LMark();
-      i = 1;
-
-      while(LLA(i) != '\n' && LLA(i) != EOF) i++;
-
-      t = make_token(T_COMM, start, i);
-
+      if(isspace((unsigned char) *p))
+        p++;
+      else if(*p == ';')
+        { // single line comment
 #ifdef FLOP
-      if(t->text[1] == '%')
-        {
-          if(strncmp(t->text+2, "+redefine", 9) == 0)
-            allow_redefinitions = 1;
-          else if(strncmp(t->text, "-redefine", 9) == 0)
-            allow_redefinitions = 0;
-        }
+          if(end - p >= 11 && p[1] == '%')
+            {
+              if(strncmp(p + 2, "+redefine", 9) == 0)
+                allow_redefinitions = 1;
+              else if(strncmp(p + 2, "-redefine", 9) == 0)
+                allow_redefinitions = 0;
+            }
 #endif
+          p = (char *) memchr(p, '\n', end - p);
+          if(p == NULL) p = end;
+        }
+      else if(*p == '#' && p + 1 < end && p[1] == '|')
+        { /* block comment */
+          char *q = p + 2;
+          while((q = (char *) memchr(q, '|', end - q)) != NULL
+                && q + 1 < end && q[1] != '#')
+            q++;
+
+          if(q == NULL || q + 1 >= end)
+            { // runaway comment
+              LConsume(p - start);
+              throw tError("runaway block comment", curr_fname(),
+                           curr_line(), curr_col());
+            }
 
-      LConsume(i);
+          p = q + 2;
+        }
+      else
+        break;
     }
-  else if(c == '#' && LLA(1) == '|')
-    { /* block comment */
-      char *start;
-
-      start = LMark();
 
-      int i = 2;
+  if(p > start)
+    LConsume(p - start);
+}
 
-      while(LLA(i) != EOF)
-      {
-          if(LLA(i) == '|' && LLA(i+1) == '#')
-          {
-              break;
-          }
-          i++;
-      }
+lex_token *get_next_token()
+{
+  int c;
+  lex_token *t;
 
-      if(LLA(i) == EOF)
-      { // runaway comment
-        throw tError("runaway block comment", curr_fname(),
-                     curr_line(), curr_col());
-      }
+  update_idchar_table();
+  c = LLA(0);
 
-      i += 2;
-      t = make_token(T_COMM, start, i);
-      LConsume(i);
+  if(c == EOF)
+    {
+      t = make_token(T_EOF, NULL, 0);
     }
   else if(c == '"')
     { // string
@@ -190,23 +232,23 @@ lex_token *get_next_token()
       int l; // length of the resolved string (without escape backslashes)
 
       start = LMark();
-      i = 1;
+      char *p = start + 1, *end = LEnd();
       l = 0;
 
-      while(LLA(i) != EOF && LLA(i) != '"')
+      while(p < end && *p != '"')
         {
-          if (LLA(i) == '\\')
-            i++; // skip
-          i++;
+          if (*p == '\\')
+            p++; // skip
+          p++;
           l++;
         }
 
-      if(LLA(i) == EOF)
+      if(p >= end)
         { // runaway string
           throw tError("runaway string", curr_fname(), curr_line(), curr_col());
         }
 
-      i += 1;
+      i = p + 1 - start;
       t = make_token(T_STRING, start + 1, i - 2, l);
       LConsume(i);
     }
@@ -281,24 +323,30 @@ lex_token *get_next_token()
       if(c == '-' || isdigit(c))
       {
           // First, let's see if this can be a number.
-          i = 1;
-          while(is_idchar(LLA(i)) || LLA(i) == '.' || LLA(i) == '-'
-                || LLA(i) == '+' || LLA(i) == 'e' || LLA(i) == 'E' )
-              i++;
+          char *p = start + 1, *end = LEnd();
+          while(p < end && (idchar_table[(unsigned char) *p] || *p == '.'))
+              p++;
+          i = p - start;
 
           // Remove stuff that shouldn't be at the end.
           while(i > 1 && (LLA(i-1) == '-' || LLA(i-1) == '+' || LLA(i-1) == '.'
                           || LLA(i-1) == 'e' || LLA(i-1) == 'E'))
               i--;
 
-          strtod(start, &endptr);
+          // the buffer may be a mapped file without a terminating '\0'
+          std::string number(start, i);
+          char *numend;
+          strtod(number.c_str(), &numend);
+          endptr = start + (numend - number.c_str());
       }
 
       if(endptr != start + i)
       {
           // See if it's an identifier.
-          i = 0;
-          while(is_idchar(LLA(i)) || LLA(i) == '!') i++;
+          char *p = start, *end = LEnd();
+          while(p < end && (idchar_table[(unsigned char) *p] || *p == '!'))
+            p++;
+          i = p - start;
 
           if(i == 0)
           { char str[3] = { (char) c, '\'', '\0' };
@@ -455,31 +503,19 @@ lex_token *
 get_token()
 {
     lex_token *t;
-    int hope = 1;
 
-    while(hope)
+    // whitespace and comments are never delivered, so they are skipped
+    // without building tokens; at the end of an included file, continue
+    // with the including one
+    for(;;)
     {
-        while((t = get_next_token())->tag != T_EOF)
-        {
-            if(t->tag != T_WS && t->tag != T_COMM)
-            {
-#ifdef PETDEBUG
-              LOG(logSyntax, DEBUG, "delivering " << t) ;
-#endif
-                tokensdelivered++;
-                return t;
-            }
-#ifdef PETDEBUG
-            else
-            {
-              LOG(logSyntax, DEBUG, "not delivering " << t);
-            }
-#endif
-            free(t);
-        }
-        if(!pop_file()) hope = 0;
+        skip_blanks();
+        if(CURR != NULL && CURR->pos < CURR->len) break;
+        if(!pop_file()) break;
     }
 
+    t = get_next_token();
+
 #ifdef PETDEBUG
     LOG(logSyntax, DEBUG, "delivering " << t);
 #endif
@@ -535,9 +571,7 @@ void consume1()
     }
   else
     {
-      if(LA_BUF[0]->text != NULL) free(LA_BUF[0]->text);
-      if(LA_BUF[0]->loc != NULL) free(LA_BUF[0]->loc);
-      free(LA_BUF[0]);
+      free_token(LA_BUF[0]);
     }
 
   for(i = 0; i < MAX_LA; ++i)
@@ -119,6 +119,14 @@ setting *settings::lookup(const char *name) {
   return 0;
 }
 
+std::set<std::string> settings::files() {
+  std::set<std::string> result;
+  for(int i = 0; i < _n; ++i)
+    if(_set[i]->loc != NULL && _set[i]->loc->fname != NULL)
+      result.insert(_set[i]->loc->fname);
+  return result;
+}
+
 /** Return the value of the first setting matching \a name or NULL if there is
  * no such setting.
  */
@@ -226,30 +234,33 @@ std::set<std::string> settings::smap(const char *name, int key_type)
  */
 bool settings::statusmember(const char *name, type_t key)
 {
-  // first try to find the list of status types for name in the cache
-  list_int *l = _li_cache[string(name)];
-  if(l == 0)
+  // first try to find the list of status types for name in the cache. Status
+  // settings that are missing or empty are cached as empty lists, since this
+  // function is called for every type when the grammar is loaded.
+  std::map<std::string, list_int *>::iterator cached = _li_cache.find(name);
+  if(cached != _li_cache.end())
+    return contains(cached->second, key);
+
+  list_int *l = 0;
+  setting *set = lookup(name);
+  // convert the set of status names into a list of code numbers and store
+  // it in the cache. All status names that do not occur in the grammar
+  // are reported to be unknown.
+  if(set != 0)
     {
-      setting *set = lookup(name);
-      // convert the set of status names into a list of code numbers and store
-      // it in the cache. All status names that do not occur in the grammar
-      // are reported to be unknown.
-      if(set != 0)
+      for(int i = 0; i < set->n; ++i)
         {
-          for(int i = 0; i < set->n; ++i)
+          int v = lookup_status(set->values[i]);
+          if(v == -1)
             {
-              int v = lookup_status(set->values[i]);
-              if(v == -1)
-                {
-                  LOG(logAppl, WARN, "ignoring unknown status `"
-                      << set->values[i] << "' in setting `" << name << "'");
-                }
-              else
-                l = cons(v, l);
+              LOG(logAppl, WARN, "ignoring unknown status `"
+                  << set->values[i] << "' in setting `" << name << "'");
             }
-          _li_cache[string(name)] = l;
+          else
+            l = cons(v, l);
         }
     }
+  _li_cache[string(name)] = l;
   return contains(l, key);
 }
 
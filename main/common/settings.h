@@ -75,6 +75,9 @@ class settings
 
   struct lex_location *lloc() { return _lloc; }
 
+  /** The names of the files that define at least one of the settings */
+  std::set<std::string> files();
+
   //
   // to (temporarily) install or uninstall 'extensions' (acting as overlays)
   //
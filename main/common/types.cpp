@@ -35,7 +35,9 @@
 #undef SUBTYPECACHE
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 using namespace std;
 using namespace HASH_SPACE;
@@ -63,7 +65,7 @@ type_t ntypes;
 std::vector<std::string> typenames;
 std::vector<std::string> printnames;
 int *typestatus = 0;
-typedef hash_map<string, type_t, simple_string_hash, string_eq> string_map;
+typedef hash_map<string, type_t, bj_string_hash, string_eq> string_map;
 string_map typename_memo;
 
 type_t BI_TOP, BI_SYMBOL, BI_STRING, BI_CONS, BI_LIST, BI_NIL, BI_DIFF_LIST;
@@ -328,6 +330,7 @@ void free_type_tables()
     attrnamelen = 0;
   }
 
+  free_glb_table();
   delete temp_bitcode;
   delete[] leaftypeparent;
   delete[] apptype;
@@ -529,6 +532,78 @@ void prune_glbcache()
 #endif
 }
 
+/** @name Dense glb table
+ * The glbs of the static non-leaf types that glb() is asked about most
+ * often, in a lower triangular matrix that is filled on demand: the glb of
+ * two types with table indices i < j is at j * (j - 1) / 2 + i. Zero means
+ * not computed yet, since \c BI_TOP is never the glb of two types different
+ * from it. Until the table is set up, the queries of every type are counted.
+ */
+//@{
+static type_t *glb_table = 0;
+/** The table index of every static non-leaf type, -1 if it is not in it */
+static int *glb_table_index = 0;
+/** The maximal number of types in the table */
+static int glb_table_size = 0;
+/** The number of glb() calls for every static non-leaf type so far */
+static long *glb_query_counts = 0;
+/** The number of glb() calls to count before the table is set up */
+static long glb_warmup = 0;
+
+/** Order types by decreasing number of queries, then by code */
+struct more_queried {
+  bool operator()(type_t a, type_t b) const {
+    if(glb_query_counts[a] != glb_query_counts[b])
+      return glb_query_counts[a] > glb_query_counts[b];
+    return a < b;
+  }
+};
+
+/** Set up the table for the most frequently queried types */
+static void build_glb_table()
+{
+  vector<type_t> ranked;
+  for(type_t t = 0; t < first_leaftype; ++t)
+    if(glb_query_counts[t] > 0) ranked.push_back(t);
+  sort(ranked.begin(), ranked.end(), more_queried());
+  if((int) ranked.size() > glb_table_size) ranked.resize(glb_table_size);
+  delete[] glb_query_counts;
+  glb_query_counts = 0;
+
+  int n = ranked.size();
+  if(n < 2) return;
+  glb_table_index = new int[first_leaftype];
+  fill(glb_table_index, glb_table_index + first_leaftype, -1);
+  for(int i = 0; i < n; ++i) glb_table_index[ranked[i]] = i;
+  long long entries = (long long) n * (n - 1) / 2;
+  glb_table = new type_t[entries];
+  memset(glb_table, 0, entries * sizeof(type_t));
+}
+
+void init_glb_table(int n, long warmup)
+{
+  free_glb_table();
+  // only non-leaf types, the glb of leaf types is cheap anyway
+  if(n > first_leaftype) n = first_leaftype;
+  if(n < 2) return;
+  glb_table_size = n;
+  glb_warmup = (warmup > 0) ? warmup : 1;
+  glb_query_counts = new long[first_leaftype];
+  fill(glb_query_counts, glb_query_counts + first_leaftype, 0L);
+}
+
+void free_glb_table()
+{
+  delete[] glb_table;
+  glb_table = 0;
+  delete[] glb_table_index;
+  glb_table_index = 0;
+  delete[] glb_query_counts;
+  glb_query_counts = 0;
+  glb_table_size = 0;
+}
+//@}
+
 #endif
 
 
@@ -715,6 +790,23 @@ int glb(int s1, int s2)
   }
 #endif
 
+  if(s2 < first_leaftype) {
+    if(glb_table_index != 0) {
+      int i = glb_table_index[s1], j = glb_table_index[s2];
+      if(i >= 0 && j >= 0) {
+        if(j < i) swap(i, j);
+        type_t &entry = glb_table[(long long) j * (j - 1) / 2 + i];
+        if(entry) return entry;
+        return (entry = core_glb(s1, s2));
+      }
+    }
+    else if(glb_query_counts != 0) {
+      ++glb_query_counts[s1];
+      ++glb_query_counts[s2];
+      if(--glb_warmup == 0) build_glb_table();
+    }
+  }
+
   // result is a _reference_ to the cache entry -> automatic writeback
   int &result = glbcache[ (typecachekey_t) s1*nstatictypes + s2 ];
   if(result) return result;
@@ -264,6 +264,10 @@ const std::list<type_t> &all_supertypes(type_t type);
  *  bitcodes, which works only for proper types, not leaf types.
  */
 bool core_subtype(type_t a, type_t b);
+/** Return the glb of the proper types \a a and \a b, computed using the
+ *  bitcodes without consulting the glb cache.
+ */
+type_t core_glb(type_t a, type_t b);
 /** Return \c true if \a a is a subtype of \a b, for any two types \a a and \a
  *  b, no matter if static, dynamic, leaf or whatsoever.
  */
@@ -292,6 +296,17 @@ type_t leaftype_parent(type_t t);
 #ifndef FLOP
 /** Empty the glb/subtype cache to save space. */
 void prune_glbcache();
+
+/** Keep the glbs of the \a n static non-leaf types that glb() is asked
+ *  about most often in a dense table instead of the glb cache. The types
+ *  are ranked by the number of times they occur in the first \a warmup
+ *  calls of glb() on two such types, then the table is set up and filled on
+ *  demand. It needs about 2 n^2 bytes.
+ */
+void init_glb_table(int n, long warmup);
+
+/** Release the dense glb table */
+void free_glb_table();
 #endif
 
 /** Check the validity of type code \a a. */
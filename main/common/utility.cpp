@@ -213,6 +213,29 @@ string escape_string(const string &s)
   return res;
 }
 
+string json_string(const string &s)
+{
+  string res = "\"";
+
+  for(string::const_iterator it = s.begin(); it != s.end(); ++it)
+  {
+    switch(*it) {
+    case '"': res += "\\\""; break;
+    case '\\': res += "\\\\"; break;
+    default:
+      if((unsigned char) *it < 0x20) {
+        char buf[8];
+        sprintf(buf, "\\u%04x", *it);
+        res += buf;
+      } else {
+        res += *it;
+      }
+    }
+  }
+
+  return res + "\"";
+}
+
 
 /** Return the current date and time in a static char array */
 string current_time(void)
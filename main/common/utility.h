@@ -77,6 +77,10 @@ std::string convert_escapes(const std::string &s);
 /** escape all '"' and '\' in string \a s using '\' */
 std::string escape_string(const std::string &s);
 
+/** return \a s as a quoted JSON string, with '"', '\' and control characters
+ *  escaped */
+std::string json_string(const std::string &s);
+
 /** return current date and time in static string; client must not free() */
 std::string current_time(void);
 
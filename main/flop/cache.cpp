@@ -0,0 +1,554 @@
+/* PET
+ * Platform for Experimentation with efficient HPSG processing Techniques
+ *
+ *   This program is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* cache for incremental compilation */
+
+#include "flop.h"
+#include "hierarchy.h"
+#include "bitcode.h"
+#include "dag.h"
+#include "list-int.h"
+#include "options.h"
+#include "settings.h"
+#include "logging.h"
+
+#include <cstdio>
+#include <cstring>
+
+using std::list;
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+bool pseudo_type(type_t i);
+bool dont_expand(type_t i);
+
+/** First word of a cache file; change when the format changes */
+#define CACHE_MAGIC 0x50464331
+
+typedef unsigned long long cache_key_t;
+
+/** One type or instance in the cache */
+struct cache_entry {
+  /** index of the name in the cache's type table */
+  int name;
+  /** key of the definition, see definition_key() */
+  cache_key_t key;
+  /** encode_dag() codes after delta and after full expansion, with the ids
+   *  of the cache's type and attribute tables
+   */
+  vector<int> delta, full;
+  /** the types whose constraints the full expansion unified in, as
+   *  2 * index in the type table + 1 if the type had been fully expanded
+   *  already at that time
+   */
+  vector<int> reads;
+};
+
+/** A glb type in the cache */
+struct cache_glb {
+  int name;
+  /** the types of the bits that are set in the glb type's bitcode */
+  vector<int> bits;
+};
+
+static bool enabled = false;
+static string cache_file;
+static cache_key_t files_key;
+
+/** @name The loaded cache */
+/*@{*/
+static bool loaded = false;
+static vector<string> cached_types, cached_attrs;
+static cache_key_t cached_hierarchy, cached_appropriateness;
+static vector<cache_glb> cached_glbs;
+static vector<cache_entry> cached_entries;
+/** cache type and attribute ids to ids of this run, -1 if unknown */
+static vector<int> typemap, attrmap;
+/** the entry of every type of this run in \c cached_entries, or -1 */
+static vector<int> entry_of;
+/** the cached dags are usable: same hierarchy and appropriateness */
+static bool dags_valid = false;
+/*@}*/
+
+/** @name The state of this run */
+/*@{*/
+static cache_key_t hierarchy_key;
+static bool glbs_restored = false;
+static int glb_start = 0, glb_end = 0;
+static vector<cache_key_t> delta_key;
+static vector<char> reused_delta, reused_full;
+static vector< vector<int> > delta_code;
+static vector<int> position;
+static vector< vector<int> > reads_of;
+/*@}*/
+
+/** @name FNV-1a hashing */
+/*@{*/
+static const cache_key_t FNV_OFFSET = 14695981039346656037ULL;
+
+static void fnv(cache_key_t &h, const void *data, size_t n) {
+  const unsigned char *p = (const unsigned char *) data;
+  for(size_t i = 0; i < n; ++i) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+}
+
+static void fnv(cache_key_t &h, const string &s) {
+  fnv(h, s.c_str(), s.size() + 1);
+}
+
+static void fnv(cache_key_t &h, int i) {
+  fnv(h, &i, sizeof(int));
+}
+
+/** Hash the contents of file \a fname into \a h */
+static bool fnv_file(cache_key_t &h, const string &fname) {
+  FILE *f = fopen(fname.c_str(), "rb");
+  if(f == NULL) return false;
+  char buf[8192];
+  size_t n;
+  while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    fnv(h, buf, n);
+  fclose(f);
+  return true;
+}
+/*@}*/
+
+/** @name Reading and writing the cache file */
+/*@{*/
+static bool put_int(FILE *f, int i) {
+  return fwrite(&i, sizeof(int), 1, f) == 1;
+}
+
+static bool put_key(FILE *f, cache_key_t k) {
+  return fwrite(&k, sizeof(cache_key_t), 1, f) == 1;
+}
+
+static bool put_code(FILE *f, const vector<int> &code) {
+  return put_int(f, code.size())
+    && (code.empty()
+        || fwrite(&code[0], sizeof(int), code.size(), f) == code.size());
+}
+
+static bool put_string(FILE *f, const string &s) {
+  return put_int(f, s.size())
+    && fwrite(s.c_str(), 1, s.size(), f) == s.size();
+}
+
+static bool get_int(FILE *f, int &i) {
+  return fread(&i, sizeof(int), 1, f) == 1;
+}
+
+static bool get_key(FILE *f, cache_key_t &k) {
+  return fread(&k, sizeof(cache_key_t), 1, f) == 1;
+}
+
+static bool get_code(FILE *f, vector<int> &code) {
+  int n;
+  if(!get_int(f, n) || n < 0) return false;
+  code.resize(n);
+  return n == 0 || fread(&code[0], sizeof(int), n, f) == (size_t) n;
+}
+
+static bool get_string(FILE *f, string &s) {
+  int n;
+  if(!get_int(f, n) || n < 0) return false;
+  vector<char> buf(n + 1);
+  if(fread(&buf[0], 1, n, f) != (size_t) n) return false;
+  s.assign(&buf[0], n);
+  return true;
+}
+
+static bool get_strings(FILE *f, vector<string> &v) {
+  int n;
+  if(!get_int(f, n) || n < 0) return false;
+  v.resize(n);
+  for(int i = 0; i < n; ++i)
+    if(!get_string(f, v[i])) return false;
+  return true;
+}
+
+static bool read_cache(FILE *f) {
+  int magic, n;
+  cache_key_t key;
+  if(!get_int(f, magic) || magic != CACHE_MAGIC
+     || !get_key(f, key) || key != files_key)
+    return false;
+  if(!get_strings(f, cached_types) || !get_strings(f, cached_attrs)
+     || !get_key(f, cached_hierarchy) || !get_int(f, n) || n < 0)
+    return false;
+  cached_glbs.resize(n);
+  for(int i = 0; i < n; ++i)
+    if(!get_int(f, cached_glbs[i].name) || !get_code(f, cached_glbs[i].bits))
+      return false;
+  if(!get_key(f, cached_appropriateness) || !get_int(f, n) || n < 0)
+    return false;
+  cached_entries.resize(n);
+  for(int i = 0; i < n; ++i) {
+    cache_entry &e = cached_entries[i];
+    if(!get_int(f, e.name) || !get_key(f, e.key) || !get_code(f, e.delta)
+       || !get_code(f, e.full) || !get_code(f, e.reads))
+      return false;
+  }
+  return true;
+}
+/*@}*/
+
+/** The key of the options and the files that define types, templates and
+ *  settings. Instances, and the string and symbol atoms they mention, may
+ *  change without changing this key.
+ */
+static cache_key_t compute_files_key() {
+  set<string> files = flop_settings->files();
+  for(int i = 0; i < types.number(); ++i)
+    if(!types[i]->tdl_instance && types[i]->status != ATOM_STATUS
+       && types[i]->def != NULL
+       && types[i]->def->fname != NULL)
+      files.insert(types[i]->def->fname);
+  for(int i = 0; i < templates.number(); ++i)
+    if(templates[i]->loc != NULL && templates[i]->loc->fname != NULL)
+      files.insert(templates[i]->loc->fname);
+
+  cache_key_t h = FNV_OFFSET;
+  fnv(h, get_opt_bool("opt_full_expansion"));
+  fnv(h, get_opt_bool("opt_expand_all_instances"));
+  fnv(h, get_opt_bool("opt_propagate_status"));
+  fnv(h, get_opt_bool("opt_no_sem"));
+  for(set<string>::iterator it = files.begin(); it != files.end(); ++it) {
+    fnv(h, *it);
+    if(!fnv_file(h, *it)) fnv(h, -1);
+  }
+  return h;
+}
+
+/** The key of the hierarchy: every proper type with the set of its
+ *  subtypes, independent of the type ids and bit positions.
+ */
+static cache_key_t compute_hierarchy_key() {
+  vector<cache_key_t> names(types.number());
+  for(int i = 0; i < types.number(); ++i) {
+    names[i] = FNV_OFFSET;
+    fnv(names[i], types.name(i));
+  }
+  cache_key_t h = FNV_OFFSET;
+  for(int i = 0; i < types.number(); ++i) if(leaftypeparent[i] == -1) {
+    cache_key_t subtypes = 0;
+    list_int *bits = types[i]->bcode->get_elements();
+    for(list_int *l = bits; l != NULL; l = rest(l))
+      subtypes += names[idbit_type[first(l)]];
+    free_list(bits);
+    fnv(h, &names[i], sizeof(cache_key_t));
+    fnv(h, &subtypes, sizeof(cache_key_t));
+  }
+  return h;
+}
+
+/** The key of the features and the types that introduce them */
+static cache_key_t compute_appropriateness_key() {
+  cache_key_t h = FNV_OFFSET;
+  for(int j = 0; j < attributes.number(); ++j) {
+    fnv(h, attributes.name(j));
+    fnv(h, types.name(apptype[j]));
+  }
+  return h;
+}
+
+/** The key of the definition of type \a i, i.e., of everything its delta
+ *  expansion depends on apart from its parents' delta expansions: its name,
+ *  status, parents and dag before delta expansion.
+ */
+static cache_key_t definition_key(int i) {
+  cache_key_t h = FNV_OFFSET;
+  fnv(h, types.name(i));
+  fnv(h, statustable.name(types[i]->status));
+  fnv(h, pseudo_type(i));
+  fnv(h, dont_expand(i));
+  list<int> parents = immediate_supertypes(i);
+  for(list<int>::iterator it = parents.begin(); it != parents.end(); ++it)
+    fnv(h, types.name(*it));
+  fnv(h, -1);
+
+  vector<int> code;
+  encode_dag(types[i]->thedag, code);
+  size_t pos = 1;
+  for(int k = 0; k < code[0]; ++k) {
+    fnv(h, code[pos] < types.number() ? types.name(code[pos]) : string());
+    int nattrs = code[pos + 1];
+    fnv(h, nattrs);
+    pos += 2;
+    for(int a = 0; a < nattrs; ++a, pos += 2) {
+      fnv(h, attributes.name(code[pos]));
+      fnv(h, code[pos + 1]);
+    }
+  }
+  return h;
+}
+
+/** Map the type and attribute ids of the cached dag code \a in to those of
+ *  this run. \return \c false if some type or attribute does not exist.
+ */
+static bool translate(const vector<int> &in, vector<int> &out) {
+  if(in.empty()) return false;
+  out = in;
+  size_t pos = 1;
+  for(int k = 0; k < in[0]; ++k) {
+    int t = in[pos];
+    if(t < 0 || t >= (int) typemap.size() || (out[pos] = typemap[t]) < 0)
+      return false;
+    int nattrs = in[pos + 1];
+    pos += 2;
+    for(int a = 0; a < nattrs; ++a, pos += 2) {
+      int f = in[pos];
+      if(f < 0 || f >= (int) attrmap.size() || (out[pos] = attrmap[f]) < 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+/** Set up the state of this run and the mapping from the cache, once all
+ *  types exist.
+ */
+static void prepare_dags() {
+  int n = types.number();
+  delta_key.assign(n, 0);
+  reused_delta.assign(n, 0);
+  reused_full.assign(n, 0);
+
+  dags_valid = loaded && glbs_restored
+    && compute_appropriateness_key() == cached_appropriateness;
+  if(!dags_valid) {
+    if(loaded)
+      LOG(logAppl, INFO, "- cache: the type hierarchy has changed");
+    return;
+  }
+
+  typemap.resize(cached_types.size());
+  for(size_t i = 0; i < cached_types.size(); ++i)
+    typemap[i] = types.id(cached_types[i]);
+  attrmap.resize(cached_attrs.size());
+  for(size_t i = 0; i < cached_attrs.size(); ++i)
+    attrmap[i] = attributes.id(cached_attrs[i]);
+  entry_of.assign(n, -1);
+  for(size_t e = 0; e < cached_entries.size(); ++e) {
+    int name = cached_entries[e].name;
+    if(name >= 0 && name < (int) typemap.size() && typemap[name] >= 0)
+      entry_of[typemap[name]] = e;
+  }
+}
+
+bool cache_enabled() {
+  return enabled;
+}
+
+void cache_load(const string &fname) {
+  enabled = true;
+  cache_file = fname;
+  files_key = compute_files_key();
+
+  FILE *f = fopen(fname.c_str(), "rb");
+  if(f == NULL) return;
+  loaded = read_cache(f);
+  fclose(f);
+  if(loaded)
+    LOG(logAppl, INFO, "- reading cache `" << fname << "'");
+  else {
+    LOG(logAppl, INFO, "- cache `" << fname << "' is out of date");
+    cached_types.clear(); cached_attrs.clear();
+    cached_glbs.clear(); cached_entries.clear();
+  }
+}
+
+bool cache_restore_glbs() {
+  if(!enabled) return false;
+  hierarchy_key = compute_hierarchy_key();
+  if(!loaded || hierarchy_key != cached_hierarchy) return false;
+
+  map<int, int> bit_of;
+  for(map<int, int>::iterator it = idbit_type.begin();
+      it != idbit_type.end(); ++it)
+    bit_of[it->second] = it->first;
+
+  // check everything before the first glb type is created
+  vector<bitcode *> codes;
+  bool ok = true;
+  for(vector<cache_glb>::iterator g = cached_glbs.begin();
+      ok && g != cached_glbs.end(); ++g) {
+    ok = g->name >= 0 && g->name < (int) cached_types.size()
+      && types.id(cached_types[g->name]) == -1;
+    bitcode *code = new bitcode(codesize);
+    for(vector<int>::iterator b = g->bits.begin(); ok && b != g->bits.end();
+        ++b) {
+      map<int, int>::iterator bit = bit_of.end();
+      if(*b >= 0 && *b < (int) cached_types.size())
+        bit = bit_of.find(types.id(cached_types[*b]));
+      if((ok = (bit != bit_of.end())))
+        code->insert(bit->second);
+    }
+    // a glb type must not coincide with an existing type
+    ok = ok && lookup_code(*code) == -1;
+    codes.push_back(code);
+  }
+  if(!ok) {
+    for(vector<bitcode *>::iterator c = codes.begin(); c != codes.end(); ++c)
+      delete *c;
+    return false;
+  }
+
+  for(size_t i = 0; i < cached_glbs.size(); ++i) {
+    struct type *glbtype = new_type(cached_types[cached_glbs[i].name], false);
+    glbtype->def = new_location("synthesized", 0, 0);
+    glbtype->bcode = codes[i];
+    register_codetype(*codes[i], glbtype->id);
+  }
+  glbs_restored = true;
+  return true;
+}
+
+void cache_note_glbs(int start, int end) {
+  glb_start = start; glb_end = end;
+}
+
+bool cache_reuse_delta(int i) {
+  if(!enabled) return false;
+  if(delta_key.empty()) prepare_dags();
+
+  delta_key[i] = definition_key(i);
+  if(!dags_valid || entry_of[i] == -1) return false;
+  const cache_entry &e = cached_entries[entry_of[i]];
+  if(e.key != delta_key[i]) return false;
+
+  // the parents' delta expansions were unified in
+  list<int> parents = immediate_supertypes(i);
+  for(list<int>::iterator it = parents.begin(); it != parents.end(); ++it)
+    if(!reused_delta[*it]) return false;
+
+  vector<int> code;
+  if(!translate(e.delta, code)) return false;
+  types[i]->thedag = decode_dag(code);
+  reused_delta[i] = true;
+  return true;
+}
+
+void cache_note_delta() {
+  if(!enabled) return;
+  delta_code.resize(types.number());
+  for(int i = 0; i < types.number(); ++i)
+    encode_dag(types[i]->thedag, delta_code[i]);
+}
+
+void cache_note_order(const vector<int> &order) {
+  if(!enabled) return;
+  position.assign(types.number(), 0);
+  for(size_t k = 0; k < order.size(); ++k) position[order[k]] = k;
+  reads_of.assign(types.number(), vector<int>());
+}
+
+bool cache_reuse_full(int i) {
+  if(!enabled || !reused_delta[i]) return false;
+  const cache_entry &e = cached_entries[entry_of[i]];
+
+  // everything the full expansion read must be in the same state as when
+  // the entry was saved: fully expanded, and then also reused, or only
+  // delta expanded, with a reused delta expansion
+  vector<int> reads;
+  for(vector<int>::const_iterator it = e.reads.begin(); it != e.reads.end();
+      ++it) {
+    int name = *it / 2, r;
+    bool expanded = *it % 2;
+    if(name >= (int) typemap.size() || (r = typemap[name]) < 0
+       || (position[r] < position[i]) != expanded
+       || !(expanded ? reused_full[r] : reused_delta[r]))
+      return false;
+    reads.push_back(2 * r + expanded);
+  }
+
+  vector<int> code;
+  if(!translate(e.full, code)) return false;
+  types[i]->thedag = decode_dag(code);
+  register_dag(i, types[i]->thedag);
+  reads_of[i] = reads;
+  reused_full[i] = true;
+  return true;
+}
+
+void cache_note_reads(int i, const set<int> &reads) {
+  if(!enabled) return;
+  reads_of[i].clear();
+  for(set<int>::const_iterator r = reads.begin(); r != reads.end(); ++r)
+    if(*r != i)
+      reads_of[i].push_back(2 * *r + (position[*r] < position[i]));
+}
+
+void cache_save() {
+  if(!enabled) return;
+
+  int ndelta = 0, nfull = 0;
+  for(size_t i = 0; i < reused_delta.size(); ++i) {
+    ndelta += reused_delta[i];
+    nfull += reused_full[i];
+  }
+  LOG(logApplC, INFO, " (" << ndelta << " / " << nfull << " of "
+      << types.number() << " cached)");
+
+  // write to a temporary file first, so an interrupted run does not leave a
+  // broken cache behind
+  string tmpname = cache_file + ".tmp";
+  FILE *f = fopen(tmpname.c_str(), "wb");
+  if(f == NULL) {
+    LOG(logAppl, WARN, "could not write cache `" << cache_file << "'");
+    return;
+  }
+
+  bool ok = put_int(f, CACHE_MAGIC) && put_key(f, files_key)
+    && put_int(f, types.number());
+  for(int i = 0; ok && i < types.number(); ++i)
+    ok = put_string(f, types.name(i));
+  ok = ok && put_int(f, attributes.number());
+  for(int j = 0; ok && j < attributes.number(); ++j)
+    ok = put_string(f, attributes.name(j));
+
+  ok = ok && put_key(f, hierarchy_key) && put_int(f, glb_end - glb_start);
+  for(int i = glb_start; ok && i < glb_end; ++i) {
+    vector<int> bits;
+    list_int *l = types[i]->bcode->get_elements();
+    for(list_int *b = l; b != NULL; b = rest(b))
+      bits.push_back(idbit_type[first(b)]);
+    free_list(l);
+    ok = put_int(f, i) && put_code(f, bits);
+  }
+
+  ok = ok && put_key(f, compute_appropriateness_key())
+    && put_int(f, types.number());
+  for(int i = 0; ok && i < types.number(); ++i) {
+    vector<int> full;
+    encode_dag(types[i]->thedag, full);
+    ok = put_int(f, i) && put_key(f, delta_key[i])
+      && put_code(f, delta_code[i]) && put_code(f, full)
+      && put_code(f, reads_of[i]);
+  }
+
+  ok = (fclose(f) == 0) && ok;
+  if(!ok || rename(tmpname.c_str(), cache_file.c_str()) != 0) {
+    LOG(logAppl, WARN, "could not write cache `" << cache_file << "'");
+    remove(tmpname.c_str());
+  }
+}
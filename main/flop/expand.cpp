@@ -26,6 +26,7 @@
 #include "partition.h"
 #include "settings.h"
 #include "dag.h"
+#include "dag-arced.h"
 #include "logging.h"
 
 #include <set>
@@ -224,6 +225,9 @@ bool delta_expand_types() {
     {
       i = *it;
 
+      if(cache_enabled() && cache_reuse_delta(i))
+        continue;
+
       if(!pseudo_type(i) && (opt_expand_all_instances || !dont_expand(i)))
         {
           l = immediate_supertypes(i);
@@ -274,6 +278,11 @@ void critical_types(struct dag_node *dag, set<int> &cs) {
  */
 #define MAX_EXP_DEPTH 1000
 
+/** If not \c NULL, fully_expand() records here the types whose constraints
+ *  it unifies in.
+ */
+static set<int> *expansion_reads = NULL;
+
 /**
  * Recursively unify the feature constraints of the type of each dag node into
  * the node
@@ -302,6 +311,8 @@ list_int *fully_expand(struct dag_node *dag, bool full) {
 
       if(dag->type < types.number() && (full || dag->arcs))
         {
+          if(expansion_reads != NULL)
+            expansion_reads->insert(dag->type);
           if(dag_unify3(types[dag->type]->thedag, dag) == FAIL)
             {
               LOG(logSemantic, ERROR, "full expansion with `"
@@ -343,6 +354,103 @@ string attrlist2string(list_int *l, string sep) {
   return out.str();
 }
 
+/** Fully expand the type dag of type \a i, set \a fail if it turns out to be
+ *  inconsistent or cyclic.
+ */
+static void expand_type(int i, bool full_expansion, bool &fail) {
+  if(!pseudo_type(i))
+    {
+      list_int *path = fully_expand(types[i]->thedag, full_expansion);
+
+      if(path != NULL)
+        {
+          LOG(logSemantic, ERROR,
+              " `" << type_name(i) << "' failed under path ("
+              << attrlist2string(path,"|") << ")");
+          free_list(path);
+          fail = true;
+        }
+
+      dag_invalidate_visited();
+
+      if(!fail && dag_cyclic(types[i]->thedag))
+        {
+          LOG(logSemantic, ERROR,
+              " `" << type_name(i) << "' failed (cyclic structure)");
+          fail = true;
+        }
+    }
+
+  register_dag(i, (types[i]->thedag = dag_deref(types[i]->thedag)));
+}
+
+/** Expand type \a i like expand_type(), or take its expansion from the
+ *  cache (see cache_reuse_full()).
+ */
+static void expand_or_reuse_type(int i, bool full_expansion, bool &fail) {
+  if(!cache_enabled())
+    expand_type(i, full_expansion, fail);
+  else if(!cache_reuse_full(i)) {
+    set<int> reads;
+    expansion_reads = &reads;
+    expand_type(i, full_expansion, fail);
+    expansion_reads = NULL;
+    cache_note_reads(i, reads);
+  }
+}
+
+/** Number the nodes of \a dag in their visit slots, starting with one, in
+ *  the order they are reached first, and collect them in \a nodes.
+ */
+static void collect_dag_nodes(dag_node *dag, vector<dag_node *> &nodes) {
+  dag = dag_deref(dag);
+  if(dag_get_visit(dag) != 0) return;
+  nodes.push_back(dag);
+  dag_set_visit(dag, nodes.size());
+  for(dag_arc *arc = dag->arcs; arc != NULL; arc = arc->next)
+    collect_dag_nodes(arc->val, nodes);
+}
+
+void encode_dag(dag_node *dag, vector<int> &code) {
+  vector<dag_node *> nodes;
+  collect_dag_nodes(dag, nodes);
+  code.clear();
+  code.push_back(nodes.size());
+  for(vector<dag_node *>::iterator it = nodes.begin(); it != nodes.end();
+      ++it) {
+    code.push_back((*it)->type);
+    size_t nattrs = code.size();
+    code.push_back(0);
+    for(dag_arc *arc = (*it)->arcs; arc != NULL; arc = arc->next) {
+      code.push_back(arc->attr);
+      code.push_back(dag_get_visit(dag_deref(arc->val)) - 1);
+      ++code[nattrs];
+    }
+  }
+  dag_invalidate_visited();
+}
+
+dag_node *decode_dag(const vector<int> &code) {
+  vector<dag_node *> nodes(code[0]);
+  int pos = 1;
+  for(int i = 0; i < code[0]; ++i) {
+    nodes[i] = new_dag(code[pos]);
+    pos += 2 + 2 * code[pos + 1];
+  }
+  pos = 1;
+  for(int i = 0; i < code[0]; ++i) {
+    int nattrs = code[pos + 1];
+    pos += 2;
+    // keep the order of the arcs
+    dag_arc **tail = &nodes[i]->arcs;
+    for(int j = 0; j < nattrs; ++j, pos += 2) {
+      *tail = new_arc(code[pos], nodes[code[pos + 1]]);
+      tail = &(*tail)->next;
+    }
+  }
+  return nodes[0];
+}
+
 /**
  * Expand the feature structure constraints of each type after delta expansion.
  *
@@ -352,6 +460,10 @@ string attrlist2string(list_int *l, string sep) {
  * feature structure constraints fully in topological order over this graph.
  * Otherwise, there are illegal cyclic type dependencies in the definitions
  *
+ * With \c opt_incremental, expansions are taken from the cache where
+ * possible. The wall clock time of the expansion is logged on \c logApplC at
+ * DEBUG level.
+ *
  * \return true if the definitions are all OK, false otherwise
  */
 bool fully_expand_types(bool full_expansion)
@@ -387,35 +499,16 @@ bool fully_expand_types(bool full_expansion)
 
   vector<int> topo;
   boost::topological_sort(G, back_inserter(topo));
-  for(vector<int>::reverse_iterator it = topo.rbegin(); it != topo.rend(); ++it)
-    {
-      i = *it;
 
-      if(!pseudo_type(i))
-        {
-          list_int *path = fully_expand(types[i]->thedag, full_expansion);
-
-          if(path != NULL)
-            {
-              LOG(logSemantic, ERROR,
-                  " `" << type_name(i) << "' failed under path ("
-                  << attrlist2string(path,"|") << ")");
-              free_list(path);
-              fail = true;
-            }
+  // the expansion order is the topological one
+  vector<int> order(topo.rbegin(), topo.rend());
+  cache_note_order(order);
 
-          dag_invalidate_visited();
-
-          if(!fail && dag_cyclic(types[i]->thedag))
-            {
-              LOG(logSemantic, ERROR,
-                  " `" << type_name(i) << "' failed (cyclic structure)");
-              fail = true;
-            }
-        }
-
-      register_dag(i, (types[i]->thedag = dag_deref(types[i]->thedag)));
-    }
+  double start = wall_clock();
+  for(size_t k = 0; k < order.size(); ++k)
+    expand_or_reuse_type(order[k], full_expansion, fail);
+  LOG(logApplC, DEBUG, "(" << order.size() << " types, "
+      << wall_clock() - start << "s) ");
 
   unify_reset_visited = false;
 
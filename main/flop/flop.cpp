@@ -272,10 +272,14 @@ void process_types()
   LOG(logApplC, INFO, "- delta");
   if(!delta_expand_types())
     exit(1);
+  if(cache_enabled())
+    cache_note_delta();
 
   LOG(logApplC, INFO, " / full");
   if(!fully_expand_types(get_opt_bool("opt_full_expansion")))
     exit(1);
+  if(cache_enabled())
+    cache_save();
 
   LOG(logAppl, INFO, " expansion for types");
   compute_maxapp();
@@ -481,6 +485,9 @@ int process(char *ofname) {
     if(!pre_only)
       check_undefined_types();
 
+    if(!pre_only && get_opt_bool("opt_incremental"))
+      cache_load(output_name(fname, TDL_EXT, CACHE_EXT));
+
     LOG(logAppl, INFO, std::endl << std::endl << "finished parsing - "
         << syntax_errors << " syntax errors, "
         << total_lexed_lines << " lines in " << std::setprecision(3)
@@ -567,6 +574,13 @@ void init() {
     false);
   managed_opt("opt_unfill", "Remove dag nodes whose information is subsumed by the type feature structure of one of its enclosing nodes", false);
   managed_opt("opt_propagate_status", "", false);
+  managed_opt("opt_jobs",
+    "number of worker processes that compute the glb types in parallel",
+    (int) 1);
+  managed_opt("opt_incremental",
+    "keep the glb types and expanded types in a cache file next to the "
+    "grammar and reuse those whose definitions did not change",
+    false);
 
 }
 
@@ -27,6 +27,8 @@
 #include "symtab.h"
 #include "types.h"
 #include <list>
+#include <set>
+#include <vector>
 #include <cstdio>
 
 /***************************/
@@ -43,6 +45,10 @@
 #define VOC_EXT ".voc"
 /** Default extension of irregular form files */
 #define IRR_EXT ".tab"
+/** Default extension of the cache files of incremental compilation
+ * (\c -incremental option)
+ */
+#define CACHE_EXT ".cache"
 
 /** @name Limits
  * fixed upper limit for tables used for elements of conjunctions,
@@ -451,6 +457,9 @@ char *add_inflr(char *old, char *add);
 
 /** A hash function for strings */
 extern int Hash(const std::string &s);
+
+/** Wall clock time in seconds, for the progress messages */
+double wall_clock();
 /*@}*/
 
 /** @name full-form.cc */
@@ -614,6 +623,54 @@ void unfill_types();
  * \result A path to the failure point, if one occured, NULL otherwise
  */
 list_int *fully_expand(struct dag_node *dag, bool full);
+
+/** Encode \a dag as integers in \a code: the number of nodes, then for every
+ *  node its type, its number of arcs and for every arc the attribute and the
+ *  index of the target node. Coreferences and the order of the arcs are kept.
+ */
+void encode_dag(struct dag_node *dag, std::vector<int> &code);
+/** Build a new dag from \a code, as produced by encode_dag() */
+struct dag_node *decode_dag(const std::vector<int> &code);
+/*@}*/
+
+/** @name cache.cc
+ * Incremental compilation (option \c -incremental). The glb types and, for
+ * every type and instance, its dags after delta and after full expansion are
+ * saved to a cache file next to the grammar. The cache is only loaded if the
+ * files defining types and templates, the settings files and the options are
+ * the same as when it was saved. A type or instance then reuses its cached
+ * expansions if its own definition and everything its expansion read are
+ * unchanged, so after a change of the lexicon only the new and changed
+ * instances are expanded.
+ */
+/*@{*/
+/** Is incremental compilation switched on? */
+bool cache_enabled();
+/** Load the cache for the grammar \a fname, if it is valid */
+void cache_load(const std::string &fname);
+/** Create the glb types of the cache, if the hierarchy is the one they were
+ *  computed for. \return \c true if the glb types were created.
+ */
+bool cache_restore_glbs();
+/** The glb types are the types \a start ... \a end - 1 */
+void cache_note_glbs(int start, int end);
+/** Replace the dag of \a type by its cached delta expansion, if valid.
+ *  Must be called in delta expansion order, before \a type is expanded.
+ *  \return \c true if the cached dag was used.
+ */
+bool cache_reuse_delta(int type);
+/** Record the dags of all types after delta expansion */
+void cache_note_delta();
+/** The types are fully expanded in the order \a order */
+void cache_note_order(const std::vector<int> &order);
+/** Replace the dag of \a type by its cached full expansion, if valid.
+ *  \return \c true if the cached dag was used.
+ */
+bool cache_reuse_full(int type);
+/** The full expansion of \a type unified the constraints of \a reads */
+void cache_note_reads(int type, const std::set<int> &reads);
+/** Save the cache, after full expansion */
+void cache_save();
 /*@}*/
 
 /** dump.cc: Dump the whole grammar to a binary data file.
@@ -30,7 +30,11 @@
 #include "logging.h"
 
 #include <boost/graph/topological_sort.hpp>
+#include <algorithm>
+#include <cstdio>
 #include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using std::list;
 using std::map;
@@ -262,6 +266,138 @@ template<typename T, bool V> struct fixedPred : std::unary_function<T, bool>
 };
 
 
+/** @name glb candidates
+ * Two types can only have a glb if their bitcodes intersect, i.e., if they
+ * share at least one descendant. Instead of intersecting the bitcodes of all
+ * pairs of non-leaf types, the candidate pairs are taken from an inverted
+ * index that maps every bit position to the types whose bitcode has this bit
+ * set.
+ */
+/*@{*/
+
+/** The inverted index: the non-leaf types in \a low ... \a high for every bit
+ *  position, in ascending order.
+ */
+static void
+build_glb_index(int low, int high, vector< vector<int> > &index)
+{
+  index.assign(codesize, vector<int>());
+  for(int i = low; i < high; ++i) if(leaftypeparent[i] == -1)
+    {
+      list_int *bits = types[i]->bcode->get_elements();
+      for(list_int *l = bits; l != NULL; l = rest(l))
+        index[first(l)].push_back(i);
+      free_list(bits);
+    }
+}
+
+/** Collect the pairs <i, j>, i < j, of non-leaf types in \a low ... \a high
+ *  whose bitcodes intersect in a code that belongs to no existing type, for
+ *  every \a step th type starting at \a first. \a candidates is increased
+ *  by the number of intersecting pairs.
+ */
+static void
+glb_pairs(const vector< vector<int> > &index, int start, int high, int step,
+          vector< std::pair<int, int> > &pairs, long &candidates)
+{
+  bitcode temp(codesize);
+  vector<int> seen(high, -1);
+  vector<int> partners;
+
+  for(int i = start; i < high; i += step) if(leaftypeparent[i] == -1)
+    {
+      partners.clear();
+      list_int *bits = types[i]->bcode->get_elements();
+      for(list_int *l = bits; l != NULL; l = rest(l))
+        {
+          const vector<int> &users = index[first(l)];
+          for(vector<int>::const_iterator j =
+                std::upper_bound(users.begin(), users.end(), i);
+              j != users.end(); ++j)
+            if(seen[*j] != i)
+              {
+                seen[*j] = i;
+                partners.push_back(*j);
+              }
+        }
+      free_list(bits);
+
+      candidates += partners.size();
+      std::sort(partners.begin(), partners.end());
+      for(vector<int>::iterator j = partners.begin(); j != partners.end(); ++j)
+        {
+          intersect_empty(*types[i]->bcode, *types[*j]->bcode, &temp);
+          if(lookup_code(temp) == -1)
+            pairs.push_back(std::make_pair(i, *j));
+        }
+    }
+}
+
+/** Compute the glb pairs of glb_pairs() with \a jobs worker processes.
+ *  \return false if a worker failed, so the pairs have to be computed
+ *  serially
+ */
+static bool
+glb_pairs_parallel(const vector< vector<int> > &index, int low, int high,
+                   int jobs, vector< std::pair<int, int> > &pairs,
+                   long &candidates)
+{
+  vector<FILE *> files;
+  vector<pid_t> workers;
+  bool ok = true;
+  fflush(NULL);
+  for(int w = 0; w < jobs && ok; ++w) {
+    FILE *f = tmpfile();
+    if(f == NULL) { ok = false; break; }
+    files.push_back(f);
+    pid_t pid = fork();
+    if(pid == 0) {
+      vector< std::pair<int, int> > mine;
+      long count = 0;
+      glb_pairs(index, low + w, high, jobs, mine, count);
+      bool written = fwrite(&count, sizeof(long), 1, f) == 1;
+      for(vector< std::pair<int, int> >::iterator it = mine.begin();
+          written && it != mine.end(); ++it)
+        written = fwrite(&it->first, sizeof(int), 1, f) == 1
+          && fwrite(&it->second, sizeof(int), 1, f) == 1;
+      written = fflush(f) == 0 && written;
+      _exit(written ? 0 : 1);
+    }
+    if(pid < 0) ok = false; else workers.push_back(pid);
+  }
+  for(vector<pid_t>::iterator it = workers.begin(); it != workers.end();
+      ++it) {
+    int status;
+    if(waitpid(*it, &status, 0) != *it || !WIFEXITED(status)
+       || WEXITSTATUS(status) != 0)
+      ok = false;
+  }
+
+  for(vector<FILE *>::iterator f = files.begin(); f != files.end(); ++f) {
+    rewind(*f);
+    long count;
+    if(ok && fread(&count, sizeof(long), 1, *f) == 1) {
+      candidates += count;
+      int p[2];
+      while(fread(p, sizeof(int), 2, *f) == 2)
+        pairs.push_back(std::make_pair(p[0], p[1]));
+    }
+    else
+      ok = false;
+    fclose(*f);
+  }
+  if(!ok) {
+    LOG(logAppl, WARN, "parallel glb computation failed, computing serially");
+    pairs.clear();
+    return false;
+  }
+  // every worker has its own types, restore the order of the serial loop
+  std::sort(pairs.begin(), pairs.end());
+  return true;
+}
+
+/*@}*/
+
 // recompute hierarchy so it's a semilattice
 // theoretical background: (Ait-Kaci et al., 1989)
 void make_semilattice()
@@ -278,59 +414,91 @@ void make_semilattice()
   // scratch bitcode
   bitcode *temp = new bitcode(codesize);
 
+  int jobs = get_opt_int("opt_jobs");
+  int iteration = 0;
+
   LOG(logApplC, INFO, "glbs ");
 
   low = 0; high = types.number();
 
+  // with -incremental, the glb types of an unchanged hierarchy are taken
+  // from the cache
+  if(cache_restore_glbs())
+    {
+      glbtypes = types.number() - oldntypes;
+      high = types.number();
+      leaftypeparent = (int *) realloc(leaftypeparent, high * sizeof(int));
+      for(i = oldntypes; i < high; ++i) leaftypeparent[i] = -1;
+    }
+  else
   // least fixpoint iteration - add glb types until nothing changes
   do {
     changed = false;
+    double start = wall_clock();
+    int before = glbtypes;
+
+    // consider all ordered pairs of non-leaf types in the range low ... high
+    // that share a descendant, and keep those whose intersection does not
+    // correspond to an existing type
+    vector< vector<int> > index;
+    vector< std::pair<int, int> > pairs;
+    long candidates = 0;
+    build_glb_index(low, high, index);
+    if(jobs <= 1 || high - low < 2 * jobs
+       || !glb_pairs_parallel(index, low, high, jobs, pairs, candidates))
+      {
+        candidates = 0;
+        glb_pairs(index, low, high, 1, pairs, candidates);
+      }
+    index.clear();
+
+    // main loop: in the order of the pairs, introduce a glb type for every
+    // intersection that still does not correspond to a type; an earlier pair
+    // may have introduced it in the meantime
+    for(vector< std::pair<int, int> >::iterator p = pairs.begin();
+        p != pairs.end(); ++p)
+      {
+        i = p->first; j = p->second;
+        intersect_empty(*types[i]->bcode, *types[j]->bcode, temp);
+
+        if(lookup_code(*temp) == -1)
+          {
+            struct type *glbtype;
+            char *name;
+
+            // make up a name
+            name = (char *) salloc(20);
+            sprintf(name, "glbtype%d", glbtypes++);
+
+            // create new type using this name and the result of the
+            // intersection as its bitcode
+            glbtype = new_type(name, false);
+            glbtype->def = new_location("synthesized", 0, 0);
+            glbtype->bcode = temp;
+
+           LOG(logSemantic, DEBUG,
+               "Introducing " << name << " for " << types.name(i)
+               << " and " << types.name(j) << ":" << std::endl
+               << "[" << types.name(i) << "]:"
+               << debug_print_subtypes(types[i]->bcode) << std::endl
+               << "[" << types.name(j) << "]:"
+               << debug_print_subtypes(types[j]->bcode) << std::endl
+               << "[" << name << "]:" <<debug_print_subtypes(temp));
+
+            // register the new type's bitcode in the hash table
+            register_codetype(*temp, glbtype->id);
+
+            // create a new scratch code
+            temp = new bitcode(codesize);
+
+            changed = true;
+          }
+      }
+
+    LOG(logApplC, DEBUG, "(iteration " << ++iteration << ": "
+        << high - low << " types, " << candidates << " candidate pairs, "
+        << glbtypes - before << " glbs, " << wall_clock() - start << "s) ");
 
-    // main loop: consider all ordered pairs of non-leaf types in the
-    // range low ... high
-    for(i = low; i < high; ++i) if(leaftypeparent[i] == -1)
-      for(j = i + 1; j < high; ++j) if(leaftypeparent[j] == -1)
-        {
-          // combine i's and j's bitcodes by binary and, and check
-          // if result is all zeroes
-          bool empty = intersect_empty(*types[i]->bcode,
-                                       *types[j]->bcode, temp);
-
-          // if we have a non empty intersection, and it does not
-          // correspond to a type, we have to introduce a glb type
-          if(!empty && lookup_code(*temp) == -1)
-            {
-              struct type *glbtype;
-              char *name;
-
-              // make up a name
-              name = (char *) salloc(20);
-              sprintf(name, "glbtype%d", glbtypes++);
-
-              // create new type using this name and the result of the
-              // intersection as its bitcode
-              glbtype = new_type(name, false);
-              glbtype->def = new_location("synthesized", 0, 0);
-              glbtype->bcode = temp;
-
-             LOG(logSemantic, DEBUG,
-                 "Introducing " << name << " for " << types.name(i)
-                 << " and " << types.name(j) << ":" << std::endl
-                 << "[" << types.name(i) << "]:"
-                 << debug_print_subtypes(types[i]->bcode) << std::endl
-                 << "[" << types.name(j) << "]:"
-                 << debug_print_subtypes(types[j]->bcode) << std::endl
-                 << "[" << name << "]:" <<debug_print_subtypes(temp));
-
-              // register the new type's bitcode in the hash table
-              register_codetype(*temp, glbtype->id);
-
-              // create a new scratch code
-              temp = new bitcode(codesize);
-
-              changed = true;
-            }
-        }
     // we only have to consider the new types in the next iteration
     low = high; high = types.number();
 
@@ -340,6 +508,8 @@ void make_semilattice()
 
   } while(changed);
 
+  cache_note_glbs(oldntypes, types.number());
+
   LOG(logApplC, INFO, "[" << glbtypes << "], ");
 
   // register the codes corresponding to non-leaf types
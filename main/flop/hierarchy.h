@@ -12,6 +12,8 @@
 
 #include <boost/graph/adjacency_list.hpp>
 #include <iosfwd>
+#include <list>
+#include <map>
 
 /** typedef for boost graph implementation */
 typedef boost::adjacency_list
@@ -27,6 +29,11 @@ typedef boost::graph_traits<tHierarchy>::edge_descriptor tHierarchyEdge;
 /** The global type hierarchy */
 extern tHierarchy hierarchy;
 
+/** The length of the bitcodes (number of bits) */
+extern int codesize;
+/** Maps from bit position in the bitcode to the corresponding type */
+extern std::map<int,int> idbit_type;
+
 /** Check and complete the hierarchy to get a BCPO
  *  \param propagate_status if \c true, propagate the status values through the
  *            hierarchy as the last step
@@ -45,6 +45,10 @@ void usage(std::ostream &out)
       << std::endl
       << "  `-cmi=level' --- create morph info, level = 0..2, default 0"
       << std::endl
+      << "  `-jobs=n' --- compute glbs with n worker processes, default 1"
+      << std::endl
+      << "  `-incremental' --- reuse the glb types and expansions of the last "
+      << "run where the definitions did not change" << std::endl
   //    << "  `-verbose[=n]' --- set verbosity level to n" << std::endl
   //    << "  `-errors-to=n' --- print errors to fd n" << std::endl
     ;
@@ -61,6 +65,8 @@ void usage(std::ostream &out)
 #define OPTION_PROPAGATE_STATUS 10
 #define OPTION_GLBDEBUG 11
 #define OPTION_CMI 12
+#define OPTION_JOBS 13
+#define OPTION_INCREMENTAL 14
 
 
 char *parse_options(int argc, char* argv[])
@@ -76,6 +82,8 @@ char *parse_options(int argc, char* argv[])
     {"no-semantics", no_argument, 0, OPTION_NO_SEM},
     {"propagate-status", no_argument, 0, OPTION_PROPAGATE_STATUS},
     {"cmi", required_argument, 0, OPTION_CMI},
+    {"jobs", required_argument, 0, OPTION_JOBS},
+    {"incremental", no_argument, 0, OPTION_INCREMENTAL},
     //{"verbose", optional_argument, 0, OPTION_VERBOSE},
     //{"errors-to", required_argument, 0, OPTION_ERRORS_TO},
     {0, 0, 0, 0}
@@ -122,6 +130,13 @@ char *parse_options(int argc, char* argv[])
       if(optarg != NULL)
         set_opt_from_string("opt_cmi", optarg);
       break;
+    case OPTION_JOBS:
+      if(optarg != NULL)
+        set_opt_from_string("opt_jobs", optarg);
+      break;
+    case OPTION_INCREMENTAL:
+      set_opt("opt_incremental", true);
+      break;
     /*
     case OPTION_VERBOSE:
       if(optarg != NULL)
@@ -24,6 +24,8 @@
 #include "lex-io.h"
 #include "utility.h"
 
+#include <sys/time.h>
+
 using namespace std;
 
 int strcount(char *s, char c)
@@ -118,3 +120,10 @@ char *add_inflr(char *old, char *add)
   strcat(s, add);
   return s;
 }
+
+double wall_clock()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}